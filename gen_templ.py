@@ -41,7 +41,7 @@ template_dir = "templ"
 variables = {
     'XM_FUNCTION_PARAM_MAX': 8,
     'XM_GET_N_SET_EXTRA_PARAM_MAX': 3,
-    'XM_DECLARE_TEMPLATE_PARAM_MAX' : 4
+    'XM_DECLARE_TEMPLATE_PARAM_MAX' : 5
     }
 
 def gen_seq(string, count, sep = ""):
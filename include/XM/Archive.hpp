@@ -0,0 +1,274 @@
+/******************************************************************************      
+ *      Extended Mirror: Archive.hpp                                          *
+ ******************************************************************************
+ *      Copyright (c) 2012-2015, Manuele Finocchiaro                          *
+ *      All rights reserved.                                                  *
+ ******************************************************************************
+ * Redistribution and use in source and binary forms, with or without         *
+ * modification, are permitted provided that the following conditions         *
+ * are met:                                                                   *
+ *                                                                            *
+ *    1. Redistributions of source code must retain the above copyright       *
+ *       notice, this list of conditions and the following disclaimer.        *
+ *                                                                            *
+ *    2. Redistributions in binary form must reproduce the above copyright    *
+ *       notice, this list of conditions and the following disclaimer in      *
+ *       the documentation and/or other materials provided with the           *
+ *       distribution.                                                        *
+ *                                                                            *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"* 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE  *
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE *
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE  *
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR        *
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF       *
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS   *
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN    *
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)    *
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF     *
+ * THE POSSIBILITY OF SUCH DAMAGE.                                            *
+ *****************************************************************************/
+
+
+#ifndef XM_ARCHIVE_HPP
+#define	XM_ARCHIVE_HPP
+
+namespace xm {
+
+class MappedArchive;
+
+
+/**
+ * Writes a sequence of instances of a class as an archive that can be memory
+ * mapped and read in place by MappedArchive.
+ * 
+ * The archive starts with the schema of the class, the list of the stored
+ * fields with their offsets, sizes and type names, followed by a record for
+ * each instance. A record has the size and layout of an instance of the class:
+ * fields of plain data type (see ClassLayout::isPlainData()) are stored at
+ * their offsets, fields of nested classes are flattened into their own plain
+ * data fields, named by their path (e.g. "position.x"). Pointers and
+ * properties accessed through getters and setters are not stored, the bytes
+ * they occupy are zeroed.
+ */
+class ArchiveWriter
+{
+public:
+    /**
+     * Constructor. The schema is written immediately.
+     * 
+     * @param clazz The class of the archived instances.
+     * @param recordCount The number of instances that will be written.
+     * @param out The stream to write the archive into.
+     */
+    ArchiveWriter(const Class& clazz, std::size_t recordCount, OutStream& out);
+    
+    /**
+     * Write the next instance.
+     * A SerializationException is thrown if more instances than announced are
+     * written.
+     * 
+     * @param object A variant holding the instance.
+     */
+    void write(const Variant& object);
+    
+private:
+    // A plain data field of the class or of a nested class.
+    struct Column
+    {
+        std::string path;
+        const Type* type;
+        std::size_t offset;
+    };
+    
+    typedef std::vector<Column> Column_Vector;
+    
+    static void addColumns(const Class& clazz,
+                           const std::string& prefix,
+                           std::size_t offset,
+                           Column_Vector& columns);
+    
+    // The archived class.
+    const Class* class_;
+    
+    // The stored fields.
+    Column_Vector columns_;
+    
+    // The stream the archive is written into.
+    OutStream* out_;
+    
+    // The record being written.
+    std::vector<char> record_;
+    
+    // The number of records still to write.
+    std::size_t remaining_;
+    
+    friend class MappedArchive;
+};
+
+
+/**
+ * A read only view of a record of a MappedArchive.
+ * 
+ * Field values are returned as constant reference variants to the archived
+ * bytes, no copy is made. The view is valid as long as the archive is.
+ */
+class RecordView
+{
+public:
+    /**
+     * Get the value of a property of the archived class.
+     * If the property is not stored in the archive, because it was added to
+     * the class after the archive was written or it is not of plain data type,
+     * Variant::Void is returned.
+     * 
+     * @param property The property.
+     * @return A constant reference variant to the archived value.
+     */
+    Variant getData(const Property& property) const;
+    
+    /**
+     * Get the value of a field given its path, such as "position.x" for the
+     * field x of the nested object position.
+     * Variant::Void is returned if the field is not stored in the archive.
+     * 
+     * @param path The field path.
+     * @return A constant reference variant to the archived value.
+     */
+    Variant getData(const std::string& path) const;
+    
+    /**
+     * Copy the stored fields into an instance of the class. Fields that are
+     * not stored in the archive are left untouched.
+     * 
+     * @param object A reference variant to the instance.
+     */
+    void load(const Variant& object) const;
+    
+private:
+    RecordView(const MappedArchive& archive, const char* record);
+    
+    // The archive.
+    const MappedArchive* archive_;
+    
+    // The record bytes.
+    const char* record_;
+    
+    friend class MappedArchive;
+};
+
+
+/**
+ * An archive written by ArchiveWriter, mapped in memory and read in place.
+ * 
+ * Opening an archive costs only the parsing of its schema, which is
+ * reconciled with the current definition of the class: fields are matched by
+ * path, type and size, so that archives stay readable after fields have been
+ * added, removed or moved. Fields removed from the class are ignored, those
+ * added are reported as missing.
+ * 
+ * A SerializationException is thrown if the archive is malformed.
+ */
+class MappedArchive
+{
+public:
+    /**
+     * Map the given archive file in memory.
+     * 
+     * @param path The archive file path.
+     * @param clazz The class of the archived instances.
+     */
+    MappedArchive(const std::string& path, const Class& clazz);
+    
+    /**
+     * Read an archive already in memory. The data must be aligned to 8
+     * bytes and outlive the archive.
+     * 
+     * @param data The archive data.
+     * @param size The archive size.
+     * @param clazz The class of the archived instances.
+     */
+    MappedArchive(const void* data, std::size_t size, const Class& clazz);
+    
+    /**
+     * Get the class of the archived instances.
+     * 
+     * @return The class.
+     */
+    const Class& getClass() const;
+    
+    /**
+     * Get the number of records.
+     * 
+     * @return The number of records.
+     */
+    std::size_t getRecordCount() const;
+    
+    /**
+     * Get a view of a record.
+     * 
+     * @param index The record index.
+     * @return The record view.
+     */
+    RecordView getRecord(std::size_t index) const;
+    
+    /**
+     * Ask whether the archive was written with the current schema of the
+     * class, in which case every field is read at its own offset.
+     * 
+     * @return true if the schema is the current one, false otherwise.
+     */
+    bool isSchemaCurrent() const;
+    
+    ~MappedArchive();
+    
+private:
+    // Reconciles a current field with the archived one.
+    struct Column
+    {
+        std::string path;
+        const Type* type;
+        std::size_t offset;
+        std::ptrdiff_t archiveOffset;
+    };
+    
+    typedef std::vector<Column> Column_Vector;
+    
+    MappedArchive(const MappedArchive&);
+    MappedArchive& operator=(const MappedArchive&);
+    
+    void parse();
+    void unmap();
+    const Column* findColumn(const std::string& path) const;
+    
+    // The archived class.
+    const Class* class_;
+    
+    // The archive data.
+    const char* data_;
+    std::size_t size_;
+    
+    // The mapping of the archive file, if the archive was mapped.
+    void* mapping_;
+    void* fileMapping_;
+    
+    // The records.
+    const char* records_;
+    std::size_t recordSize_;
+    std::size_t recordCount_;
+    
+    // The current fields, sorted by path.
+    Column_Vector columns_;
+    
+    // The columns of the properties of the class, by layout field index.
+    std::vector<std::ptrdiff_t> fieldColumns_;
+    
+    bool schemaCurrent_;
+    
+    friend class RecordView;
+};
+
+
+} // namespace xm
+
+#endif	/* XM_ARCHIVE_HPP */
@@ -0,0 +1,246 @@
+/******************************************************************************      
+ *      Extended Mirror: ArrayView.hpp                                        *
+ ******************************************************************************
+ *      Copyright (c) 2012-2015, Manuele Finocchiaro                          *
+ *      All rights reserved.                                                  *
+ ******************************************************************************
+ * Redistribution and use in source and binary forms, with or without         *
+ * modification, are permitted provided that the following conditions         *
+ * are met:                                                                   *
+ *                                                                            *
+ *    1. Redistributions of source code must retain the above copyright       *
+ *       notice, this list of conditions and the following disclaimer.        *
+ *                                                                            *
+ *    2. Redistributions in binary form must reproduce the above copyright    *
+ *       notice, this list of conditions and the following disclaimer in      *
+ *       the documentation and/or other materials provided with the           *
+ *       distribution.                                                        *
+ *                                                                            *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"* 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE  *
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE *
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE  *
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR        *
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF       *
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS   *
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN    *
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)    *
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF     *
+ * THE POSSIBILITY OF SUCH DAMAGE.                                            *
+ *****************************************************************************/
+
+
+#ifndef XM_ARRAYVIEW_HPP
+#define	XM_ARRAYVIEW_HPP
+
+namespace xm {
+
+
+/**
+ * A strided view over the elements of a multidimensional array, such as a
+ * C array property or a column of a matrix. The view does not own the
+ * elements.
+ * 
+ * Elements are addressed by an index tuple, one index per dimension, and can
+ * be copied in bulk to and from dense row-major buffers. Plain data elements
+ * are copied with memcpy.
+ */
+class ArrayView
+{
+public:
+    typedef std::vector<std::size_t> Extent_Vector;
+    typedef std::vector<std::ptrdiff_t> Stride_Vector;
+    
+    /**
+     * Construct a view of a whole, possibly nested, C array. The extents are
+     * those of the nested array types, the element type is the innermost non
+     * array type.
+     * 
+     * @param data The address of the array.
+     * @param type The array type.
+     * @param isConst Whether the elements cannot be modified.
+     */
+    ArrayView(void* data, const ArrayType& type, bool isConst = false);
+    
+    /**
+     * Construct a view with custom extents and strides.
+     * 
+     * @param data The address of the first element.
+     * @param elementType The element type.
+     * @param extents The number of elements in each dimension.
+     * @param strides The distance in bytes between consecutive elements of
+     *        each dimension, as many as the extents.
+     * @param isConst Whether the elements cannot be modified.
+     */
+    ArrayView(void* data,
+              const Type& elementType,
+              const Extent_Vector& extents,
+              const Stride_Vector& strides,
+              bool isConst = false);
+    
+    /**
+     * Construct a view of an array property of an object.
+     * 
+     * @param self The object.
+     * @param property The array property.
+     */
+    ArrayView(const Variant& self, const Property& property);
+    
+    /**
+     * Get the element type.
+     * 
+     * @return The element type.
+     */
+    const Type& getElementType() const;
+    
+    /**
+     * Get the number of dimensions.
+     * 
+     * @return The number of dimensions.
+     */
+    std::size_t getRank() const;
+    
+    /**
+     * Get the number of elements in each dimension.
+     * 
+     * @return The extents.
+     */
+    const Extent_Vector& getExtents() const;
+    
+    /**
+     * Get the distance in bytes between consecutive elements of each
+     * dimension.
+     * 
+     * @return The strides.
+     */
+    const Stride_Vector& getStrides() const;
+    
+    /**
+     * Get the total number of elements.
+     * 
+     * @return The number of elements.
+     */
+    std::size_t getSize() const;
+    
+    /**
+     * Checks whether the elements are dense and in row-major order.
+     * 
+     * @return True if the view is contiguous.
+     */
+    bool isContiguous() const;
+    
+    /**
+     * Checks whether the elements cannot be modified through the view.
+     * 
+     * @return True if the view is const.
+     */
+    bool isConst() const;
+    
+    /**
+     * Get the address of an element, throws SequenceIndexException if an
+     * index is out of range.
+     * 
+     * @param index One index per dimension.
+     * @return The element address.
+     */
+    void* getAddress(const std::size_t* index) const;
+    
+    /**
+     * Get the address of an element, throws SequenceIndexException if the
+     * number of indexes is not the rank or an index is out of range.
+     * 
+     * @param index One index per dimension.
+     * @return The element address.
+     */
+    void* getAddress(std::initializer_list<std::size_t> index) const;
+    
+    /**
+     * Get an element.
+     * 
+     * @param index One index per dimension.
+     * @return A reference Variant to the element, const if the view is.
+     */
+    Variant at(const std::size_t* index) const;
+    
+    /**
+     * Get an element, see getAddress(std::initializer_list<std::size_t>).
+     * 
+     * @param index One index per dimension.
+     * @return A reference Variant to the element, const if the view is.
+     */
+    Variant at(std::initializer_list<std::size_t> index) const;
+    
+    /**
+     * Get the view of the sub-array at an index of the first dimension.
+     * 
+     * @param index The index in the first dimension.
+     * @return The view, with one dimension less.
+     */
+    ArrayView slice(std::size_t index) const;
+    
+    /**
+     * Copy the elements to a dense row-major buffer of getSize() elements.
+     * Elements of string or class type are assigned, so the buffer must
+     * hold constructed objects.
+     * 
+     * @param buffer The buffer.
+     */
+    void copyTo(void* buffer) const;
+    
+    /**
+     * Copy the elements from a dense row-major buffer of getSize() elements.
+     * Elements of string or class type are assigned from the ones of the
+     * buffer, which must hold constructed objects.
+     * Throws VariantCostnessException if the view is const.
+     * 
+     * @param buffer The buffer.
+     */
+    void copyFrom(const void* buffer) const;
+    
+    /**
+     * Copy the elements to a typed buffer, throws VariantTypeException if T
+     * is not the element type.
+     * 
+     * @param buffer The buffer.
+     */
+    template<typename T>
+    void copyTo(T* buffer) const
+    {
+        checkElementType(registerType<T>());
+        copyTo(static_cast<void*>(buffer));
+    }
+    
+    /**
+     * Copy the elements from a typed buffer, throws VariantTypeException if T
+     * is not the element type.
+     * 
+     * @param buffer The buffer.
+     */
+    template<typename T>
+    void copyFrom(const T* buffer) const
+    {
+        checkElementType(registerType<T>());
+        copyFrom(static_cast<const void*>(buffer));
+    }
+    
+private:
+    void init(const ArrayType& type);
+    
+    void checkElementType(const Type& type) const;
+    
+    void copy(char* data, char*& buffer, std::size_t dim, bool toBuffer) const;
+    
+    void assign(char* dst, const char* src) const;
+    
+    char* data_;
+    const Type* elementType_;
+    Extent_Vector extents_;
+    Stride_Vector strides_;
+    bool isConst_;
+    bool plainData_;
+};
+
+
+} // namespace xm
+
+#endif	/* XM_ARRAYVIEW_HPP */
@@ -0,0 +1,184 @@
+/******************************************************************************      
+ *      Extended Mirror: Associative.hpp                                      *
+ ******************************************************************************
+ *      Copyright (c) 2012-2015, Manuele Finocchiaro                          *
+ *      All rights reserved.                                                  *
+ ******************************************************************************
+ * Redistribution and use in source and binary forms, with or without         *
+ * modification, are permitted provided that the following conditions         *
+ * are met:                                                                   *
+ *                                                                            *
+ *    1. Redistributions of source code must retain the above copyright       *
+ *       notice, this list of conditions and the following disclaimer.        *
+ *                                                                            *
+ *    2. Redistributions in binary form must reproduce the above copyright    *
+ *       notice, this list of conditions and the following disclaimer in      *
+ *       the documentation and/or other materials provided with the           *
+ *       distribution.                                                        *
+ *                                                                            *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"* 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE  *
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE *
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE  *
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR        *
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF       *
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS   *
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN    *
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)    *
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF     *
+ * THE POSSIBILITY OF SUCH DAMAGE.                                            *
+ *****************************************************************************/
+
+
+#ifndef XM_ASSOCIATIVE_HPP
+#define	XM_ASSOCIATIVE_HPP
+
+namespace xm {
+
+
+/**
+ * Reflects the interface of an associative container, such as std::map or
+ * std::unordered_set, so that its elements can be looked up by a key held in
+ * a Variant.
+ * 
+ * The containers are always passed as Variant, their constness is honored.
+ * Keys are converted to the key type by reference, they are never copied for
+ * lookups.
+ */
+class Associative
+{
+public:
+    /**
+     * Receives the elements of a container during forEach().
+     */
+    class Visitor
+    {
+    public:
+        /**
+         * Called for each element.
+         * 
+         * @param key A const reference Variant to the key.
+         * @param mapped A reference Variant to the mapped value, a Void
+         *        Variant for sets.
+         */
+        virtual void visit(const Variant& key, const Variant& mapped) = 0;
+        
+        virtual ~Visitor() {};
+    };
+    
+    /**
+     * Constructor.
+     * 
+     * @param keyType The type of the keys.
+     * @param mappedType The type of the mapped values, NULL for sets.
+     * @param hashed Whether the container is a hash table.
+     */
+    Associative(const Type& keyType, const Type* mappedType, bool hashed);
+    
+    /**
+     * Get the type of the keys.
+     * 
+     * @return The key type.
+     */
+    const Type& getKeyType() const;
+    
+    /**
+     * Get the type of the mapped values.
+     * 
+     * @return The mapped type, NULL if the container is a set.
+     */
+    const Type* getMappedType() const;
+    
+    /**
+     * Checks whether the container is a hash table rather than an ordered
+     * tree.
+     * 
+     * @return True if the container is hashed.
+     */
+    bool isHashed() const;
+    
+    /**
+     * Get the number of elements.
+     * 
+     * @param container The container.
+     * @return The number of elements.
+     */
+    virtual std::size_t getSize(const Variant& container) const = 0;
+    
+    /**
+     * Look up an element.
+     * 
+     * @param container The container.
+     * @param key The key, of the container key type.
+     * @return A reference Variant to the mapped value, or to the key for
+     *         sets, a Void Variant if the key is not found.
+     */
+    virtual Variant find(const Variant& container,
+                         const Variant& key) const = 0;
+    
+    /**
+     * Insert an element, for maps the mapped value is default constructed.
+     * 
+     * @param container The non const container.
+     * @param key The key, of the container key type.
+     * @return True if the element was inserted, false if already present.
+     */
+    virtual bool insert(const Variant& container,
+                        const Variant& key) const = 0;
+    
+    /**
+     * Insert an element with its mapped value, which is ignored for sets.
+     * 
+     * @param container The non const container.
+     * @param key The key, of the container key type.
+     * @param mapped The mapped value, of the container mapped type.
+     * @return True if the element was inserted, false if already present.
+     */
+    virtual bool insert(const Variant& container, const Variant& key,
+                        const Variant& mapped) const = 0;
+    
+    /**
+     * Erase an element.
+     * 
+     * @param container The non const container.
+     * @param key The key, of the container key type.
+     * @return True if the element was found and erased.
+     */
+    virtual bool erase(const Variant& container,
+                       const Variant& key) const = 0;
+    
+    /**
+     * Remove all the elements.
+     * 
+     * @param container The non const container.
+     */
+    virtual void clear(const Variant& container) const = 0;
+    
+    /**
+     * Create a default constructed key, to be filled before an insertion.
+     * 
+     * @return A Variant holding the key by value.
+     */
+    virtual Variant createKey() const = 0;
+    
+    /**
+     * Visit all the elements, in the container order.
+     * 
+     * @param container The container.
+     * @param visitor The visitor receiving the elements.
+     */
+    virtual void forEach(const Variant& container,
+                         Visitor& visitor) const = 0;
+    
+    virtual ~Associative();
+    
+private:
+    const Type* keyType_;
+    const Type* mappedType_;
+    bool hashed_;
+};
+
+
+} // namespace xm
+
+#endif	/* XM_ASSOCIATIVE_HPP */
@@ -0,0 +1,211 @@
+/******************************************************************************      
+ *      Extended Mirror: AssociativeImpl.hpp                                  *
+ ******************************************************************************
+ *      Copyright (c) 2012-2015, Manuele Finocchiaro                          *
+ *      All rights reserved.                                                  *
+ ******************************************************************************
+ * Redistribution and use in source and binary forms, with or without         *
+ * modification, are permitted provided that the following conditions         *
+ * are met:                                                                   *
+ *                                                                            *
+ *    1. Redistributions of source code must retain the above copyright       *
+ *       notice, this list of conditions and the following disclaimer.        *
+ *                                                                            *
+ *    2. Redistributions in binary form must reproduce the above copyright    *
+ *       notice, this list of conditions and the following disclaimer in      *
+ *       the documentation and/or other materials provided with the           *
+ *       distribution.                                                        *
+ *                                                                            *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"* 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE  *
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE *
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE  *
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR        *
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF       *
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS   *
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN    *
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)    *
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF     *
+ * THE POSSIBILITY OF SUCH DAMAGE.                                            *
+ *****************************************************************************/
+
+
+#ifndef XM_ASSOCIATIVEIMPL_HPP
+#define	XM_ASSOCIATIVEIMPL_HPP
+
+namespace xm {
+
+
+/**
+ * Adapts the element of the associative container C, maps store pairs of
+ * key and mapped value, sets the bare keys.
+ */
+template<class C, bool = std::is_same<typename C::key_type,
+                                      typename C::value_type>::value>
+struct AssociativeElement
+{
+    typedef typename C::key_type KeyT;
+    typedef typename C::mapped_type MappedT;
+    
+    static const Type* getMappedType()
+    {
+        return &registerType<MappedT>();
+    }
+    
+    static const KeyT& getKey(const typename C::value_type& element)
+    {
+        return element.first;
+    }
+    
+    static Variant getMapped(const typename C::value_type& element,
+                             char flags)
+    {
+        return Variant(const_cast<MappedT&>(element.second), flags);
+    }
+    
+    static bool insert(C& container, const KeyT& key, const Variant& mapped)
+    {
+        return container.insert(typename C::value_type(key,
+                const_cast<Variant&>(mapped).as<const MappedT>())).second;
+    }
+    
+    static bool insert(C& container, const KeyT& key)
+    {
+        return container.insert(
+                typename C::value_type(key, MappedT())).second;
+    }
+};
+
+
+template<class C>
+struct AssociativeElement<C, true>
+{
+    typedef typename C::key_type KeyT;
+    
+    static const Type* getMappedType()
+    {
+        return NULL;
+    }
+    
+    static const KeyT& getKey(const typename C::value_type& element)
+    {
+        return element;
+    }
+    
+    static Variant getMapped(const typename C::value_type&, char)
+    {
+        return Variant::Void;
+    }
+    
+    static bool insert(C& container, const KeyT& key, const Variant&)
+    {
+        return container.insert(key).second;
+    }
+    
+    static bool insert(C& container, const KeyT& key)
+    {
+        return container.insert(key).second;
+    }
+};
+
+
+template<class C>
+class AssociativeImpl : public Associative
+{
+public:
+    typedef AssociativeElement<C> Element;
+    typedef typename C::key_type KeyT;
+    
+    static const bool IsSet =
+            std::is_same<KeyT, typename C::value_type>::value;
+    
+    AssociativeImpl()
+        : Associative(registerType<KeyT>(), Element::getMappedType(),
+                      IsHashed<C>::value) {}
+    
+    std::size_t getSize(const Variant& container) const
+    {
+        return get(container).size();
+    }
+    
+    Variant find(const Variant& container, const Variant& key) const
+    {
+        const C& c = get(container);
+        typename C::const_iterator ite = c.find(getKey(key));
+        if (ite == c.end())
+            return Variant::Void;
+        
+        // sets have no mapped value, their keys are never writable
+        if (IsSet)
+            return Variant(const_cast<KeyT&>(Element::getKey(*ite)),
+                           Variant::Reference | Variant::Const);
+        if (container.isConst())
+            return Element::getMapped(*ite,
+                    Variant::Reference | Variant::Const);
+        return Element::getMapped(*ite, Variant::Reference);
+    }
+    
+    bool insert(const Variant& container, const Variant& key) const
+    {
+        return Element::insert(getNonConst(container), getKey(key));
+    }
+    
+    bool insert(const Variant& container, const Variant& key,
+                const Variant& mapped) const
+    {
+        return Element::insert(getNonConst(container), getKey(key), mapped);
+    }
+    
+    bool erase(const Variant& container, const Variant& key) const
+    {
+        return getNonConst(container).erase(getKey(key)) != 0;
+    }
+    
+    void clear(const Variant& container) const
+    {
+        getNonConst(container).clear();
+    }
+    
+    Variant createKey() const
+    {
+        return Variant(KeyT());
+    }
+    
+    void forEach(const Variant& container, Visitor& visitor) const
+    {
+        const C& c = get(container);
+        char mappedFlags = Variant::Reference;
+        if (container.isConst())
+            mappedFlags |= Variant::Const;
+        
+        for (typename C::const_iterator ite = c.begin(); ite != c.end();
+                ++ite)
+        {
+            const KeyT& key = Element::getKey(*ite);
+            visitor.visit(Variant(const_cast<KeyT&>(key),
+                                  Variant::Reference | Variant::Const),
+                          Element::getMapped(*ite, mappedFlags));
+        }
+    }
+    
+private:
+    static const KeyT& getKey(const Variant& key)
+    {
+        return const_cast<Variant&>(key).as<const KeyT>();
+    }
+    
+    static const C& get(const Variant& container)
+    {
+        return const_cast<Variant&>(container).as<const C>();
+    }
+    
+    static C& getNonConst(const Variant& container)
+    {
+        return const_cast<Variant&>(container).as<C>();
+    }
+};
+
+
+} // namespace xm
+
+#endif	/* XM_ASSOCIATIVEIMPL_HPP */
@@ -51,6 +51,7 @@
 #define XM_BIND_CONSTANT(constant)                                            \
     bindConstant<decltype(constant), constant>(#constant);
 #define XM_BIND_ENUM(enum_) bindEnum(#enum_)
+#define XM_BIND_ENUM_TYPE(enum_) bindEnum<enum_>(#enum_)
 #define XM_ADD_ENUM_VAL(val) addValue(XM_UNV(val))
 #define XM_BIND_FUNCTION(function) bindFunction(XM_FNP(function))
 #define XM_BIND_VARIABLE(variable) bindVariable(XM_VNV(variable))
@@ -115,6 +116,21 @@ Enum& bindEnum(const std::string& name)
 }
 
 
+template<typename T>
+Enum& bindEnum(const std::string& name)
+{
+    Enum& xmEnum = bindEnum(name);
+    
+    // link the enumeration type to the Enum
+    const PrimitiveType& type =
+            dynamic_cast<const PrimitiveType&>(registerType<T>());
+    const_cast<PrimitiveType&>(type).setEnum(xmEnum);
+    xmEnum.setSigned(
+            std::is_signed<typename std::underlying_type<T>::type>::value);
+    return xmEnum;
+}
+
+
 template<class ClassT, class BaseT>
 void bindBase()
 {
@@ -182,6 +198,49 @@ void addTemplArg(T arg)
 }
 
 
+
+template<class ClassT, bool =
+        std::is_same<typename ClassT::reference,
+                     typename ClassT::value_type&>::value>
+struct BindSequence
+{
+    void operator()()
+    {
+        Class& clazz = const_cast<Class&>(getClass<ClassT>());
+        CompoundClass* compClass = dynamic_cast<CompoundClass*>(&clazz);
+        if (compClass) {
+            compClass->setSequence(*new SequenceImpl<ClassT>());
+        }
+    }
+};
+
+
+// containers handing out proxies, like std::vector<bool>, cannot be viewed
+template<class ClassT>
+struct BindSequence<ClassT, false>
+{
+    void operator()() {}
+};
+
+
+template<class ClassT>
+void bindSequence()
+{
+    BindSequence<ClassT>()();
+}
+
+
+template<class ClassT>
+void bindAssociative()
+{
+    Class& clazz = const_cast<Class&>(getClass<ClassT>());
+    CompoundClass* compClass = dynamic_cast<CompoundClass*>(&clazz);
+    if (compClass) {
+        compClass->setAssociative(*new AssociativeImpl<ClassT>());
+    }
+}
+
+
 } // namespace xm
 
 #endif	/* XM_BIND_HPP */
@@ -0,0 +1,219 @@
+/******************************************************************************      
+ *      Extended Mirror: ChangeTracker.hpp                                    *
+ ******************************************************************************
+ *      Copyright (c) 2012-2015, Manuele Finocchiaro                          *
+ *      All rights reserved.                                                  *
+ ******************************************************************************
+ * Redistribution and use in source and binary forms, with or without         *
+ * modification, are permitted provided that the following conditions         *
+ * are met:                                                                   *
+ *                                                                            *
+ *    1. Redistributions of source code must retain the above copyright       *
+ *       notice, this list of conditions and the following disclaimer.        *
+ *                                                                            *
+ *    2. Redistributions in binary form must reproduce the above copyright    *
+ *       notice, this list of conditions and the following disclaimer in      *
+ *       the documentation and/or other materials provided with the           *
+ *       distribution.                                                        *
+ *                                                                            *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"* 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE  *
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE *
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE  *
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR        *
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF       *
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS   *
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN    *
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)    *
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF     *
+ * THE POSSIBILITY OF SUCH DAMAGE.                                            *
+ *****************************************************************************/
+
+
+#ifndef XM_CHANGETRACKER_HPP
+#define	XM_CHANGETRACKER_HPP
+
+namespace xm {
+
+
+/**
+ * Receives the properties changed on a tracked instance, see ChangeTracker.
+ */
+class ChangeListener
+{
+public:
+    /**
+     * Called by ChangeTracker::flush() once for each tracked instance with
+     * changed properties.
+     * 
+     * @param object A reference variant to the instance.
+     * @param properties The changed properties, valid only during the call.
+     */
+    virtual void propertiesChanged(
+            const Variant& object,
+            const std::vector<const Property*>& properties) = 0;
+    
+    virtual ~ChangeListener();
+};
+
+
+/**
+ * Records which properties of a set of instances are changed through
+ * Property::setData() and notifies them to listeners in batches.
+ * 
+ * Tracking is opt-in: only the instances passed to track() are observed, by
+ * any of the existing trackers. Changes are recorded as the set of changed
+ * properties of each instance, in a side table keyed by instance address, and
+ * delivered to the listeners when flush() is called, typically at the end of
+ * a frame or of a transaction, with a single notification per instance.
+ * Once an instance is tracked recording a change does not allocate memory.
+ * 
+ * Changes made writing the fields directly, including those made by the
+ * deserializers, are not observed; they can be reported with markChanged().
+ * xm::scatter() reports the fields it writes.
+ * 
+ * The trackers and their tracked instances are guarded by a lock shared by
+ * all of them, so properties can be set from any thread while instances are
+ * tracked and changes flushed. The listeners are called without the lock
+ * held, so they can set properties; the listeners of a tracker must be
+ * managed, and its changes flushed, from a single thread at a time.
+ */
+class ChangeTracker
+{
+public:
+    ChangeTracker();
+    
+    /**
+     * Start observing an instance.
+     * 
+     * @param object A reference variant to the instance.
+     */
+    void track(const Variant& object);
+    
+    /**
+     * Stop observing an instance. Pending changes of the instance are
+     * discarded.
+     * 
+     * @param object A reference variant to the instance.
+     */
+    void untrack(const Variant& object);
+    
+    /**
+     * Record that a property of an instance has changed. Nothing is done if
+     * the instance is not tracked.
+     * 
+     * @param object The address of the instance.
+     * @param property The property.
+     */
+    void markChanged(const void* object, const Property& property);
+    
+    /**
+     * Ask whether a property of a tracked instance has changed since the last
+     * flush.
+     * 
+     * @param object A reference variant to the instance.
+     * @param property The property.
+     * @return true if the property has changed, false otherwise.
+     */
+    bool isChanged(const Variant& object, const Property& property) const;
+    
+    /**
+     * Add a listener.
+     * 
+     * @param listener The listener.
+     */
+    void addListener(ChangeListener& listener);
+    
+    /**
+     * Remove a listener.
+     * 
+     * @param listener The listener.
+     */
+    void removeListener(ChangeListener& listener);
+    
+    /**
+     * Notify the listeners of the changes recorded since the last flush and
+     * clear them.
+     */
+    void flush();
+    
+    /**
+     * Called by Property::setData() implementations after setting the data,
+     * records the change in all the trackers observing the instance.
+     * 
+     * @param object The address of the instance.
+     * @param property The property.
+     */
+    static void notifySet(const void* object, const Property& property);
+    
+    /**
+     * Record the change of a property of every instance in an array, in
+     * all the trackers observing them, as notifySet() does for a single
+     * instance. Used by the bulk writes bypassing Property::setData().
+     * 
+     * @param objects The address of the first instance.
+     * @param stride The distance in bytes between two instances.
+     * @param count The number of instances.
+     * @param property The property.
+     */
+    static void notifySet(const void* objects, std::size_t stride,
+                          std::size_t count, const Property& property);
+    
+    ~ChangeTracker();
+    
+private:
+    // The state of a tracked instance.
+    struct Entry
+    {
+        Entry() : clazz(NULL) {}
+        
+        const Class* clazz;
+        
+        // The changed properties, in order of first change. Queued when
+        // not empty.
+        std::vector<const Property*> changed;
+    };
+    
+    // An instance with changes being delivered by flush(), its properties
+    // in the changed_ range [first, last).
+    struct Pending
+    {
+        const void* object;
+        const Class* clazz;
+        std::size_t first;
+        std::size_t last;
+    };
+    
+    typedef std::map<const void*, Entry> Entry_Map;
+    
+    ChangeTracker(const ChangeTracker&);
+    ChangeTracker& operator=(const ChangeTracker&);
+    
+    // The tracked instances.
+    Entry_Map entries_;
+    
+    // The instances with changes, in order of first change.
+    std::vector<const void*> queue_;
+    
+    // The listeners.
+    std::vector<ChangeListener*> listeners_;
+    
+    // Buffers of the changes being delivered by flush().
+    std::vector<Pending> pending_;
+    std::vector<const Property*> changed_;
+    std::vector<const Property*> properties_;
+    
+    // Record a change, with the trackers lock held.
+    void markChanged_(const void* object, const Property& property);
+    
+    // Remove this tracker from the active ones, with the trackers lock held.
+    void deactivate();
+    
+    // The trackers with at least a tracked instance.
+    static std::vector<ChangeTracker*>& getActiveTrackers();
+};
+
+
+} // namespace xm
+
+#endif	/* XM_CHANGETRACKER_HPP */
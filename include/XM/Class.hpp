@@ -37,8 +37,15 @@
 namespace xm
 {
 
-typedef std::set<const RefCaster*, PtrCmpByVal<RefCaster> > Const_RefCaster_Set;
-typedef std::set<const Class*, PtrCmpByName<Class> > Const_Class_Set;
+class ClassLayout;
+
+typedef FlatSet<const RefCaster*, PtrCmpByVal<RefCaster> > Const_RefCaster_Set;
+typedef FlatSet<const Class*, PtrCmpByName<Class> > Const_Class_Set;
+
+// Get the address and the dynamic type of the most derived object of an
+// instance of a polymorphic class.
+typedef void* (*DynamicResolver)(void* object,
+                                 const std::type_info*& dynamicType);
 
 
 class Class : public Type, public Namespace
@@ -116,6 +123,11 @@ public:
     /**
      * Retrieve all the property descriptors of this class. Note that the
      * properties inherited form the base classes are not included.
+     * The set including the inherited properties is updated when members or
+     * bases are added to the class or to its base classes, which invalidates
+     * its iterators; a class with a single base and no properties of its
+     * own returns the set of the base, and switches to a set of its own,
+     * flattened on request, when it gets one.
      * 
      * @param inherited Whether to include inherited properties.
      * @return A set containing the pointers to the class property objects.
@@ -124,6 +136,8 @@ public:
     
     /**
      * Retrieve all the Methods of this class.
+     * The set including the inherited methods is updated like the one of
+     * getProperties().
      * 
      * @param inherited Whether to include inherited methods.
      * @return A set containing the pointers to the class method objects.
@@ -158,6 +172,17 @@ public:
      */
     bool hasMethod(const Method& method, bool inherited = true) const;
     
+    /**
+     * Get the method of the class, own or inherited, in a dispatch slot.
+     * Overrides are found in the slot of the overridden method, so that a
+     * slot resolved once on a base class can be used on every derived one.
+     * The lookup is a single array access.
+     * 
+     * @param slot The slot, see Method::getSlot().
+     * @return The method, NULL if the class has no method in the slot.
+     */
+    const Method* getMethodBySlot(std::size_t slot) const;
+    
     /**
      * Check whether or not the class inherits from a class with the given name.
      * 
@@ -168,12 +193,53 @@ public:
     
     /**
      * Check whether or not the class derives from a given class.
+     * The test is a constant time bit lookup.
      * 
      * @param baseClass The type of the derived class
      * @return true if the class derives from the given one, false otherwise. 
      */
     bool inheritsFrom(const Class& baseClass) const;
     
+    /**
+     * Ask if the class is polymorphic, that is if its instances carry their
+     * dynamic type.
+     * 
+     * @return True if the class is polymorphic, false otherwise.
+     */
+    bool isPolymorphic() const;
+    
+    /**
+     * Get the most derived registered class of an instance of this class,
+     * through its dynamic type, and the address of the most derived object.
+     * If the class is not polymorphic or the dynamic type is not registered
+     * this class is returned and the address is left unchanged.
+     * 
+     * @param object The address of the instance, set to the address of the
+     * most derived object.
+     * @return The most derived class.
+     */
+    const Class& getDynamicClass(void*& object) const;
+    
+    /**
+     * Get the offset of the given base class subobject within an instance of
+     * this class. The offset of the class itself is zero.
+     * If the offset is not constant (i.e. a virtual base is in the path) or
+     * the class does not derive from the given one, then -1 is returned.
+     * 
+     * @param baseClass The base class.
+     * @return The offset of the base class subobject.
+     */
+    std::ptrdiff_t getBaseOffset(const Class& baseClass) const;
+    
+    /**
+     * Get the flattened layout of the class data, built on first request.
+     * A layout stays valid as long as the class, even after a change of the
+     * properties makes the class build a new one.
+     * 
+     * @return The class layout.
+     */
+    const ClassLayout& getLayout() const;
+    
     /**
      * Get the Property with the given property name.
      * 
@@ -253,7 +319,7 @@ protected:
             bool isAbstract
      );
 
-    Namespace& walkTo(const std::string& path, bool create = false);
+    Namespace* walkTo_(const std::string& path, bool create);
     
     const Constructor* constructor_;
     
@@ -269,20 +335,113 @@ protected:
 
     Const_Class_Set derivedClasses_;
 
-    // The properties of this class.
-    Const_Property_Set properties_;
-    
     // The properties of this class except those inherited from base classes.
     Const_Property_Set ownProperties_;
     
-    // The methods of this class.
-    Const_Method_Set methods_;
-    
     // The methods of this class except those inherited form base classes.
     Const_Method_Set ownMethods_;
     
+    // The members of a class including the inherited ones, flattened for
+    // iteration. Own members hide the inherited ones with the same key.
+    struct MemberTable
+    {
+        Const_Property_Set properties;
+        Const_Method_Set methods;
+    };
+    
+    // The member table, built on the first request of the inherited
+    // properties or methods of a class with members of its own and bases,
+    // then kept up to date. NULL until then: the lookups by key go through
+    // the own members and then through the bases.
+    mutable std::atomic<MemberTable*> memberTable_;
+    
+    // The methods of the class, own or inherited, by slot. The slots of an
+    // overridden method hold the override.
+    std::vector<const Method*> dispatch_;
+    
     bool isAbstract_;
     
+    // The layout of the class data, built on first request under the
+    // Register::Lock.
+    mutable std::atomic<ClassLayout*> layout_;
+    
+    // The layouts replaced after a change of the properties, kept until the
+    // class is destroyed since they may still be referenced.
+    std::vector<ClassLayout*> oldLayouts_;
+    
+    // Resolves the dynamic type of the instances, NULL if the class is not
+    // polymorphic.
+    DynamicResolver dynamicResolver_;
+    
+    // The sequential number of the class, its bit in the ancestors_ rows.
+    std::size_t classIndex_;
+    
+    // Bit set of the indirect base classes, indexed by classIndex_, so that
+    // inheritsFrom() is a single bit test.
+    std::vector<std::uint64_t> ancestors_;
+    
+    // Assign the next sequential number to a newly created class.
+    static std::size_t makeClassIndex();
+    
+    // Add the ancestors of a base class to this class and to all the classes
+    // derived from it.
+    void addAncestors(const Class& baseClass);
+    
+    // Get the member table, building it on first request.
+    const MemberTable& getMemberTable() const;
+    
+    // Add the own members and those of the bases to a member table.
+    void fillMembers(MemberTable& table) const;
+    
+    // Refill the member tables already built of this class and of the
+    // classes derived from it, and retire their layouts if the properties
+    // changed. Called with the Register::Lock held.
+    void updateMembers(bool properties);
+    
+    // Look up a member, own or inherited, by key.
+    const Member* lookupMember_(const Item& keyItem) const;
+    
+    // Look up a method, own or inherited, with the key of another one.
+    const Method* findMethod_(const Method& keyMethod) const;
+    
+    // A method and a dispatch slot it takes.
+    typedef std::pair<const Method*, std::size_t> MethodSlot;
+    
+    // Put a method in a dispatch slot, collecting the clash if the slot
+    // holds a method with another key.
+    void putMethod(std::size_t slot, const Method* method,
+                   std::vector<MethodSlot>& clashes);
+    
+    // Put a method bound to the class in its slot, in this class and in
+    // the classes derived from it, as resolved by each of them.
+    void dispatchMethod(const Method& method,
+                        std::vector<MethodSlot>& clashes);
+    
+    // Rebuild the dispatch slots of this class and of the classes derived
+    // from it from the bases and the own methods.
+    void rebuildDispatch(std::vector<MethodSlot>& clashes);
+    
+    // Move the methods whose slots clash until no slot is taken twice.
+    void resolveClashes(std::vector<MethodSlot>& clashes);
+    
+    // Assign the dispatch slot of a method being bound to the class: the
+    // slot of the inherited method it overrides or the first slot free in
+    // the class and in the classes derived from it.
+    void assignSlot(Method& method) const;
+    
+    // Get the first slot free in the class and in the classes derived
+    // from it.
+    std::size_t getFreeSlot() const;
+    
+    // Move the methods with the key of a method and its clashing slot, in
+    // the whole hierarchy of the class, to a slot free in all of it, then
+    // rebuild the dispatch slots of the hierarchy.
+    void moveSlot(const MethodSlot& clash, std::vector<MethodSlot>& clashes);
+    
+    // Look up the members, including the inherited ones, then the other
+    // items of the class.
+    const Item* lookupItem_(const Item& keyItem) const;
+    
     // Factory function
     template<class T>
     friend Class& createClass();
@@ -290,6 +449,8 @@ protected:
     // The DefineClass needs to call the & operator.
     template<class T>
     friend struct DefineClass;
+    
+    friend class MemoryStatsCollector;
 };
 
 
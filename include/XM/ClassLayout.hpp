@@ -0,0 +1,188 @@
+/******************************************************************************      
+ *      Extended Mirror: ClassLayout.hpp                                      *
+ ******************************************************************************
+ *      Copyright (c) 2012-2015, Manuele Finocchiaro                          *
+ *      All rights reserved.                                                  *
+ ******************************************************************************
+ * Redistribution and use in source and binary forms, with or without         *
+ * modification, are permitted provided that the following conditions         *
+ * are met:                                                                   *
+ *                                                                            *
+ *    1. Redistributions of source code must retain the above copyright       *
+ *       notice, this list of conditions and the following disclaimer.        *
+ *                                                                            *
+ *    2. Redistributions in binary form must reproduce the above copyright    *
+ *       notice, this list of conditions and the following disclaimer in      *
+ *       the documentation and/or other materials provided with the           *
+ *       distribution.                                                        *
+ *                                                                            *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"* 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE  *
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE *
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE  *
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR        *
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF       *
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS   *
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN    *
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)    *
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF     *
+ * THE POSSIBILITY OF SUCH DAMAGE.                                            *
+ *****************************************************************************/
+
+
+#ifndef XM_CLASSLAYOUT_HPP
+#define	XM_CLASSLAYOUT_HPP
+
+namespace xm {
+
+
+/**
+ * Flattened description of the data of a Class, built from its properties,
+ * inherited ones included.
+ * 
+ * Properties bound to a field come first, sorted by their offset within an
+ * instance of the class; properties accessed through getters and setters
+ * follow, in name order. Adjacent fields of primitive type are grouped in runs
+ * so that they can be copied, compared or hashed as a single block of memory.
+ * 
+ * The layout of a class is built on first request by Class::getLayout().
+ */
+class ClassLayout
+{
+public:
+    
+    /**
+     * Describes where a Property lies within an instance of the class.
+     */
+    struct Field
+    {
+        /** The property. */
+        const Property* property;
+        
+        /**
+         * The offset of the field within an instance of the class, or -1 if
+         * the property must be accessed through its getter and setter.
+         */
+        std::ptrdiff_t offset;
+    };
+    
+    /**
+     * A sequence of adjacent fields of primitive type.
+     */
+    struct Run
+    {
+        /** The offset of the first byte of the run. */
+        std::size_t offset;
+        
+        /** The size in bytes of the run. */
+        std::size_t size;
+        
+        /** The index of the first field of the run. */
+        std::size_t firstField;
+        
+        /** The number of fields in the run. */
+        std::size_t fieldCount;
+    };
+    
+    typedef std::vector<Field> Field_Vector;
+    typedef std::vector<Run> Run_Vector;
+    
+    /**
+     * Build the layout of the given class.
+     * 
+     * @param clazz The class.
+     */
+    ClassLayout(const Class& clazz);
+    
+    /**
+     * Get the class this layout describes.
+     * 
+     * @return The class.
+     */
+    const Class& getClass() const;
+    
+    /**
+     * Get the fields, sorted as described in the class documentation.
+     * 
+     * @return The vector of fields.
+     */
+    const Field_Vector& getFields() const;
+    
+    /**
+     * Get the runs of adjacent primitive fields.
+     * 
+     * @return The vector of runs.
+     */
+    const Run_Vector& getRuns() const;
+    
+    /**
+     * Get the index of the given property within the fields vector, with a
+     * binary search over the fields sorted by property address.
+     * If the property is not part of the layout -1 is returned.
+     * 
+     * @param property The property.
+     * @return The field index.
+     */
+    int getFieldIndex(const Property& property) const;
+    
+    /**
+     * Get the index of the field whose property has the given unqualified
+     * name. The lookup is a binary search over a name sorted key table and
+     * does not require the name to be null terminated.
+     * If no field has the given name -1 is returned.
+     * 
+     * @param name The property name.
+     * @param length The length of the name.
+     * @return The field index.
+     */
+    int findField(const char* name, std::size_t length) const;
+    
+    /**
+     * Get the schema fingerprint of the class, a hash of the names and Types
+     * of the fields, in layout order. Nested classes contribute with their
+     * own fingerprint.
+     * 
+     * @return The schema fingerprint.
+     */
+    std::uint64_t getFingerprint() const;
+    
+    /**
+     * Ask whether data of the given type can be copied, compared and hashed
+     * as raw memory, that is if it is a primitive or an array of them.
+     * 
+     * @param type The type.
+     * @return true if the type is plain data, false otherwise.
+     */
+    static bool isPlainData(const Type& type);
+    
+    /**
+     * Get the number of bytes used by the layout, the object included.
+     * 
+     * @return The number of bytes.
+     */
+    std::size_t getMemorySize() const;
+    
+private:
+    // The described class.
+    const Class* class_;
+    
+    // The fields.
+    Field_Vector fields_;
+    
+    // The runs of primitive fields.
+    Run_Vector runs_;
+    
+    // The field indexes sorted by property name.
+    std::vector<std::size_t> keys_;
+    
+    // The properties with their field index, sorted by property address.
+    std::vector<std::pair<const Property*, std::size_t> > propertyIndexes_;
+    
+    // The schema fingerprint.
+    std::uint64_t fingerprint_;
+};
+
+
+} // namespace xm
+
+#endif	/* XM_CLASSLAYOUT_HPP */
@@ -0,0 +1,218 @@
+/******************************************************************************      
+ *      Extended Mirror: Columns.hpp                                          *
+ ******************************************************************************
+ *      Copyright (c) 2012-2015, Manuele Finocchiaro                          *
+ *      All rights reserved.                                                  *
+ ******************************************************************************
+ * Redistribution and use in source and binary forms, with or without         *
+ * modification, are permitted provided that the following conditions         *
+ * are met:                                                                   *
+ *                                                                            *
+ *    1. Redistributions of source code must retain the above copyright       *
+ *       notice, this list of conditions and the following disclaimer.        *
+ *                                                                            *
+ *    2. Redistributions in binary form must reproduce the above copyright    *
+ *       notice, this list of conditions and the following disclaimer in      *
+ *       the documentation and/or other materials provided with the           *
+ *       distribution.                                                        *
+ *                                                                            *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"* 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE  *
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE *
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE  *
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR        *
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF       *
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS   *
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN    *
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)    *
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF     *
+ * THE POSSIBILITY OF SUCH DAMAGE.                                            *
+ *****************************************************************************/
+
+
+#ifndef XM_COLUMNS_HPP
+#define	XM_COLUMNS_HPP
+
+#include <XM/Exceptions/VariantTypeException.hpp>
+
+namespace xm {
+
+
+/**
+ * A typed buffer holding the values of a property for a collection of
+ * instances, laid out contiguously (struct of arrays).
+ * 
+ * The buffer is aligned to Alignment bytes so that it can be processed with
+ * vector instructions. Only properties of plain data type are supported (see
+ * ClassLayout::isPlainData()).
+ */
+class Column
+{
+public:
+    /** The alignment of the column data. */
+    static const std::size_t Alignment = 64;
+    
+    /**
+     * Constructor.
+     * A NonCopyableException is thrown if the property is not of plain data
+     * type.
+     * 
+     * @param property The property.
+     * @param size The number of values.
+     */
+    Column(const Property& property, std::size_t size = 0);
+    
+    /**
+     * Get the property whose values are held.
+     * 
+     * @return The property.
+     */
+    const Property& getProperty() const;
+    
+    /**
+     * Get the type of the values.
+     * 
+     * @return The type.
+     */
+    const Type& getType() const;
+    
+    /**
+     * Get the number of values.
+     * 
+     * @return The number of values.
+     */
+    std::size_t getSize() const;
+    
+    /**
+     * Change the number of values. The content is not preserved.
+     * 
+     * @param size The number of values.
+     */
+    void resize(std::size_t size);
+    
+    /**
+     * Get the column data.
+     * 
+     * @return A pointer to the first value.
+     */
+    void* getData();
+    const void* getData() const;
+    
+    /**
+     * Get the column data as an array of T.
+     * A VariantTypeException is thrown if T is not the type of the values.
+     * 
+     * @return A pointer to the first value.
+     */
+    template<typename T>
+    T* as();
+    
+    template<typename T>
+    const T* as() const;
+    
+    ~Column();
+    
+private:
+    Column(const Column&);
+    Column& operator=(const Column&);
+    
+    // The property.
+    const Property* property_;
+    
+    // The allocated buffer and the aligned data within it.
+    char* buffer_;
+    char* data_;
+    
+    // The number of values.
+    std::size_t size_;
+};
+
+
+/**
+ * Copy the values of the column property from an array of instances of a
+ * class into the column, which is resized to the number of instances.
+ * 
+ * Properties bound to a field are read through their offset, with a strided
+ * loop specialized on the value size that the compiler can vectorize;
+ * properties accessed through getters are read one by one.
+ * 
+ * @param clazz The class of the instances.
+ * @param objects Pointer to the first instance of the array.
+ * @param count The number of instances.
+ * @param column The column.
+ */
+void gather(const Class& clazz,
+            const void* objects,
+            std::size_t count,
+            Column& column);
+
+
+/**
+ * Copy the values of a column back into an array of instances of a class.
+ * Properties accessed through setters are set one by one. Properties bound
+ * to a field are written directly, bypassing Property::setData(); the change
+ * of every instance written is then reported to the ChangeTracker objects
+ * observing it.
+ * 
+ * @param column The column, holding at least count values.
+ * @param clazz The class of the instances.
+ * @param objects Pointer to the first instance of the array.
+ * @param count The number of instances.
+ */
+void scatter(const Column& column,
+             const Class& clazz,
+             void* objects,
+             std::size_t count);
+
+
+template<typename T>
+void gather(const T* objects, std::size_t count, Column& column)
+{
+    gather(getClass<T>(), objects, count, column);
+}
+
+
+template<typename T>
+void gather(const std::vector<T>& objects, Column& column)
+{
+    gather(getClass<T>(), objects.empty() ? NULL : &objects[0],
+            objects.size(), column);
+}
+
+
+template<typename T>
+void scatter(const Column& column, T* objects, std::size_t count)
+{
+    scatter(column, getClass<T>(), objects, count);
+}
+
+
+template<typename T>
+void scatter(const Column& column, std::vector<T>& objects)
+{
+    scatter(column, getClass<T>(), objects.empty() ? NULL : &objects[0],
+            objects.size());
+}
+
+
+template<typename T>
+T* Column::as()
+{
+    if (&xm::getType<T>() != &getType())
+        throw VariantTypeException(xm::getType<T>(), getType());
+    return reinterpret_cast<T*>(data_);
+}
+
+
+template<typename T>
+const T* Column::as() const
+{
+    if (&xm::getType<T>() != &getType())
+        throw VariantTypeException(xm::getType<T>(), getType());
+    return reinterpret_cast<const T*>(data_);
+}
+
+
+} // namespace xm
+
+#endif	/* XM_COLUMNS_HPP */
@@ -81,6 +81,33 @@ public:
      * Set the template arguments.
      */
     void setTemplateArgs(const TemplArg_Vector& templateArgs);
+    
+    /**
+     * Get the sequence container interface of this class.
+     * 
+     * @return The sequence interface, or NULL if the class is not a sequence.
+     */
+    const Sequence* getSequence() const;
+    
+    /**
+     * Set the sequence container interface, the class takes its ownership.
+     */
+    void setSequence(const Sequence& sequence);
+    
+    /**
+     * Get the associative container interface of this class.
+     * 
+     * @return The associative interface, or NULL if the class is not an
+     *         associative container.
+     */
+    const Associative* getAssociative() const;
+    
+    /**
+     * Set the associative container interface, the class takes its ownership.
+     */
+    void setAssociative(const Associative& associative);
+    
+    ~CompoundClass();
         
 private:
     /**
@@ -116,6 +143,12 @@ private:
     // The the template arguments.
     TemplArg_Vector templateArgs_;
     
+    // The sequence container interface.
+    const Sequence* sequence_;
+    
+    // The associative container interface.
+    const Associative* associative_;
+    
     // Factory functions
     template<class T>
     friend Class& createClass();
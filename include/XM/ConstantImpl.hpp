@@ -45,7 +45,8 @@ public:
 
     virtual Variant getValue() const
     {
-        return Variant(val, Variant::Const);
+        T value = val;
+        return Variant(value, Variant::Const);
     }
 };
 
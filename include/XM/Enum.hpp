@@ -34,6 +34,19 @@
 
 namespace xm {
 
+/**
+ * A reflected enumeration.
+ * 
+ * Keys and values are indexed on the first lookup after they are added, so
+ * that both the lookup of a value from its key and the lookup of a key from
+ * its value take constant or logarithmic time: keys are placed in a
+ * collision free hash table and values in a dense table when their range is
+ * narrow, or in a sorted table otherwise.
+ * 
+ * Values are stored as long long, so that enumerations of any underlying
+ * integer type can be described. Enumerations marked as flag sets are
+ * formatted and parsed as keys separated by '|'.
+ */
 class Enum : public Item {
 public:
     Enum(const std::string& uName, const Namespace& name_space);
@@ -41,16 +54,123 @@ public:
     Enum(const std::string& uName);
     
     virtual
-    const std::map<std::string, int>& getValues() const;
+    const std::map<std::string, long long>& getValues() const;
 
     virtual
-    int getValue(const std::string& enumKey) const;
+    long long getValue(const std::string& enumKey) const;
+    
+    /**
+     * Get the value of the given key, without throwing when it is unknown.
+     * 
+     * @param enumKey The key.
+     * @param value Set to the value of the key, if found.
+     * @return True if the key was found.
+     */
+    bool tryGetValue(const std::string& enumKey, long long& value) const;
+    
+    /**
+     * Get the value of the key made of the given characters.
+     * 
+     * @param enumKey The characters of the key.
+     * @param length The number of characters.
+     * @param value Set to the value of the key, if found.
+     * @return True if the key was found.
+     */
+    bool tryGetValue(const char* enumKey, size_t length, long long& value)
+            const;
+
+    /**
+     * Get the key of the given value.
+     * 
+     * @param value The value.
+     * @return A pointer to the key, or NULL if no key has the given value.
+     */
+    const std::string* findKey(long long value) const;
+    
+    /**
+     * Format the given value as text.
+     * 
+     * The value is written as its key, or for flag sets as the keys of its
+     * set bits separated by '|'. Bits without a key are written as a number.
+     * 
+     * @param value The value.
+     * @return The text of the value.
+     */
+    std::string format(long long value) const;
+    
+    /**
+     * Parse a value from text written by format().
+     * 
+     * Flag sets accept any combination of keys and numbers separated by '|',
+     * other enumerations a single key or number.
+     * 
+     * @param text The text.
+     * @param value Set to the parsed value, on success.
+     * @return True if the whole text could be parsed.
+     */
+    bool parse(const std::string& text, long long& value) const;
+    
+    /**
+     * Parse a value from the given characters.
+     * 
+     * @param text The characters of the text.
+     * @param length The number of characters.
+     * @param value Set to the parsed value, on success.
+     * @return True if the whole text could be parsed.
+     */
+    bool parse(const char* text, size_t length, long long& value) const;
+    
+    /**
+     * Whether the values of this enumeration are combined as bit flags.
+     */
+    bool isFlags() const;
+    
+    Enum& setFlags(bool flags = true);
+    
+    /**
+     * Whether the underlying type of the enumeration is signed.
+     */
+    bool isSigned() const;
+    
+    Enum& setSigned(bool isSigned);
 
-    Enum& addValue(const std::string& enumKey, int val);
+    Enum& addValue(const std::string& enumKey, long long val);
+    
+    template<typename T>
+    Enum& addValue(const std::string& enumKey, T val)
+    {
+        return addValue(enumKey, static_cast<long long>(val));
+    }
 
 private:
+    typedef std::pair<long long, const std::string*> ValueKey;
+    
+    // Build the lookup tables if values were added since the last build.
+    void prepareTables() const;
+    
+    void buildTables() const;
+    
+    bool findSlot(const char* enumKey, size_t length, size_t& slot) const;
 
-    std::map<std::string, int> values_;
+    std::map<std::string, long long> values_;
+    
+    // Whether the tables below reflect values_. They are built on the first
+    // lookup after values are added, rather than on every addValue().
+    mutable std::atomic<bool> tablesBuilt_;
+    
+    // collision free hash table of the keys, addressed through the
+    // displacement of the bucket of each key
+    mutable std::vector<ValueKey> keySlots_;
+    mutable std::vector<std::uint32_t> displacements_;
+    mutable unsigned long long keySeed_;
+    
+    // keys by value, directly indexed from denseMin_ when dense
+    mutable std::vector<const std::string*> denseKeys_;
+    mutable long long denseMin_;
+    mutable std::vector<ValueKey> sortedKeys_;
+    
+    bool flags_;
+    bool signed_;
 };
 
 } // namespace xm
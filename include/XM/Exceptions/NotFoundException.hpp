@@ -36,6 +36,13 @@
 
 namespace xm{
 
+/**
+ * Thrown when an item or a type cannot be found.
+ * 
+ * Lookups are often probed for optional items, so the exception only records
+ * where the lookup failed and what was looked for. The message is formatted
+ * the first time it is requested.
+ */
 class NotFoundException : public std::exception
 {
 public:
@@ -48,7 +55,16 @@ public:
     
     ~NotFoundException() throw();
 protected:
-    std::string msg;
+    const Namespace* namespace_;
+    const std::type_info* cppType_;
+    Item::Category category_;
+    bool isClass_;
+    bool isSignature_;
+    
+    // the unqualified name or signature of the item, truncated
+    char key_[128];
+    
+    mutable std::string msg;
 };
 
 
@@ -0,0 +1,130 @@
+/******************************************************************************      
+ *      Extended Mirror: Hash.hpp                                             *
+ ******************************************************************************
+ *      Copyright (c) 2012-2015, Manuele Finocchiaro                          *
+ *      All rights reserved.                                                  *
+ ******************************************************************************
+ * Redistribution and use in source and binary forms, with or without         *
+ * modification, are permitted provided that the following conditions         *
+ * are met:                                                                   *
+ *                                                                            *
+ *    1. Redistributions of source code must retain the above copyright       *
+ *       notice, this list of conditions and the following disclaimer.        *
+ *                                                                            *
+ *    2. Redistributions in binary form must reproduce the above copyright    *
+ *       notice, this list of conditions and the following disclaimer in      *
+ *       the documentation and/or other materials provided with the           *
+ *       distribution.                                                        *
+ *                                                                            *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"* 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE  *
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE *
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE  *
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR        *
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF       *
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS   *
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN    *
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)    *
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF     *
+ * THE POSSIBILITY OF SUCH DAMAGE.                                            *
+ *****************************************************************************/
+
+
+#ifndef XM_HASH_HPP
+#define	XM_HASH_HPP
+
+namespace xm {
+
+
+/**
+ * Compute the hash of a value of a reflected type.
+ * 
+ * Instances of classes are hashed following the class layout: runs of
+ * adjacent primitive fields and arrays of plain data are hashed as blocks of
+ * memory, eight bytes at a time, nested classes recursively and properties
+ * accessed through getters through their returned value. As for
+ * serialization, pointers are not part of the value and are not hashed.
+ * 
+ * @param data Pointer to the value.
+ * @param type The type of the value.
+ * @return The hash.
+ */
+std::size_t hashOf(const void* data, const Type& type);
+
+
+/**
+ * Compute the hash of the value held by a variant, see hashOf(const void*,
+ * const Type&).
+ * 
+ * @param value The variant.
+ * @return The hash.
+ */
+std::size_t hashOf(const Variant& value);
+
+
+/**
+ * Compare two values of a reflected type.
+ * The comparison is consistent with hashOf(): primitives are compared
+ * bitwise, classes property by property and pointers are ignored.
+ * 
+ * @param data1 Pointer to the first value.
+ * @param data2 Pointer to the second value.
+ * @param type The type of the values.
+ * @return true if the values are equal, false otherwise.
+ */
+bool equals(const void* data1, const void* data2, const Type& type);
+
+
+/**
+ * Compare the values held by two variants, see equals(const void*,
+ * const void*, const Type&). Values of different types are never equal.
+ * 
+ * @param value1 The first variant.
+ * @param value2 The second variant.
+ * @return true if the values are equal, false otherwise.
+ */
+bool equals(const Variant& value1, const Variant& value2);
+
+
+/**
+ * Hash functor for reflected types, suitable for the unordered containers.
+ */
+template<typename T>
+class ReflectedHash
+{
+public:
+    ReflectedHash() : type_(&getType<T>()) {}
+    
+    std::size_t operator()(const T& value) const
+    {
+        return hashOf(&value, *type_);
+    }
+    
+private:
+    const Type* type_;
+};
+
+
+/**
+ * Equality functor for reflected types, suitable for the unordered
+ * containers.
+ */
+template<typename T>
+class ReflectedEqual
+{
+public:
+    ReflectedEqual() : type_(&getType<T>()) {}
+    
+    bool operator()(const T& value1, const T& value2) const
+    {
+        return equals(&value1, &value2, *type_);
+    }
+    
+private:
+    const Type* type_;
+};
+
+
+} // namespace xm
+
+#endif	/* XM_HASH_HPP */
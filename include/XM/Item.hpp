@@ -118,6 +118,14 @@ public:
 
     bool before(const Item& item) const;
 
+    /**
+     * Items created while a type is being registered are placed in the
+     * metadata arena, see Arena.
+     */
+    static void* operator new(std::size_t size);
+    
+    static void operator delete(void* ptr);
+    
     virtual ~Item();
     
 protected:
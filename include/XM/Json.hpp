@@ -0,0 +1,251 @@
+/******************************************************************************      
+ *      Extended Mirror: Json.hpp                                             *
+ ******************************************************************************
+ *      Copyright (c) 2012-2015, Manuele Finocchiaro                          *
+ *      All rights reserved.                                                  *
+ ******************************************************************************
+ * Redistribution and use in source and binary forms, with or without         *
+ * modification, are permitted provided that the following conditions         *
+ * are met:                                                                   *
+ *                                                                            *
+ *    1. Redistributions of source code must retain the above copyright       *
+ *       notice, this list of conditions and the following disclaimer.        *
+ *                                                                            *
+ *    2. Redistributions in binary form must reproduce the above copyright    *
+ *       notice, this list of conditions and the following disclaimer in      *
+ *       the documentation and/or other materials provided with the           *
+ *       distribution.                                                        *
+ *                                                                            *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"* 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE  *
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE *
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE  *
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR        *
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF       *
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS   *
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN    *
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)    *
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF     *
+ * THE POSSIBILITY OF SUCH DAMAGE.                                            *
+ *****************************************************************************/
+
+
+#ifndef XM_JSON_HPP
+#define	XM_JSON_HPP
+
+namespace xm {
+
+
+/**
+ * Writes class instances as JSON documents.
+ * 
+ * Objects are written following the class layout, with a key for each
+ * property. Enumeration values bound with bindEnum<T>() are written as their
+ * names, arrays and sequence containers as JSON arrays, null pointers as
+ * null, char pointers as strings and other pointers as the pointed value.
+ * Associative containers are written as JSON objects when their keys are
+ * strings, else sets as arrays of keys and maps as arrays of [key, value]
+ * pairs. Non finite floating point
+ * values are written as null. A SerializationException is thrown for pointers
+ * back to an object being written, as cycles cannot be represented.
+ */
+class JsonWriter
+{
+public:
+    /**
+     * Constructor.
+     * 
+     * @param out The stream to write the documents into.
+     */
+    JsonWriter(OutStream& out);
+    
+    /**
+     * Write the given class instance as a JSON object.
+     * 
+     * @param object A variant holding the instance.
+     */
+    void write(const Variant& object);
+    
+private:
+    class ElementWriter;
+    
+    void writeData(const char* data, const Type& type);
+    void writeObject(const char* obj, const Class& clazz);
+    void writeCompound(const char* data, const CompoundClass& clazz);
+    void writeString(const char* str, std::size_t length);
+    void put(char c);
+    void put(const char* str, std::size_t length);
+    void flush();
+    
+    // The stream the documents are written into.
+    OutStream* out_;
+    
+    // Output is buffered to limit the calls to the stream.
+    char buffer_[1024];
+    std::size_t size_;
+    
+    // The objects on the current chain of followed pointers.
+    std::vector<const void*> pointed_;
+};
+
+
+/**
+ * A pull parser for JSON documents.
+ * 
+ * The document is tokenized on request by next(), without building any tree.
+ * Strings are returned as pointers into the parsed data, unless they contain
+ * escape sequences, in which case they are decoded into an internal buffer
+ * that is reused across tokens.
+ * 
+ * read() binds the keys of a JSON object to the properties of a class,
+ * through the key table of the class layout, and stores the values straight
+ * into the fields of the instance. Properties accessed through getters and
+ * setters are set with Property::setData(). Unknown keys and properties that
+ * are not settable are skipped. Containers are read in the format written by
+ * JsonWriter and replace the previous content.
+ * 
+ * A SerializationException is thrown for malformed documents or values that
+ * do not fit the property they are read into, an EnumKeyNotFoundException for
+ * unknown enumeration names.
+ */
+class JsonReader
+{
+public:
+    /**
+     * The tokens of a JSON document.
+     */
+    enum Token
+    {
+        BeginObject,
+        EndObject,
+        BeginArray,
+        EndArray,
+        Key,
+        String,
+        Number,
+        True,
+        False,
+        Null,
+        End
+    };
+    
+    /**
+     * Constructor.
+     * The data must outlive the reader.
+     * 
+     * @param data The JSON document.
+     * @param size The document size.
+     */
+    JsonReader(const char* data, std::size_t size);
+    
+    /**
+     * Parse the next token. End is returned once the whole document has been
+     * parsed.
+     * 
+     * @return The token.
+     */
+    Token next();
+    
+    /**
+     * Get the last parsed token.
+     * 
+     * @return The token.
+     */
+    Token getToken() const;
+    
+    /**
+     * Get the text of the last Key, String or Number token. The text is not
+     * null terminated and it is valid until the next call to next().
+     * 
+     * @return The token text.
+     */
+    const char* getText() const;
+    
+    /**
+     * Get the length of the text of the last Key, String or Number token.
+     * 
+     * @return The text length.
+     */
+    std::size_t getTextLength() const;
+    
+    /**
+     * Get the value of the last Number token.
+     * 
+     * @return The number.
+     */
+    double getNumber() const;
+    
+    /**
+     * Skip the next value, with all of its content if it is an object or an
+     * array.
+     */
+    void skipValue();
+    
+    /**
+     * Read the next value, which must be a JSON object, into the given class
+     * instance.
+     * 
+     * @param object A reference variant to the instance to read into.
+     */
+    void read(const Variant& object);
+    
+    /**
+     * Get the position of the parser within the document.
+     * 
+     * @return The number of characters parsed so far.
+     */
+    std::size_t getPosition() const;
+    
+private:
+    // The parser state, which tells the expected tokens.
+    enum State
+    {
+        ValueState,
+        FirstKeyState,
+        KeyState,
+        FirstElementState,
+        AfterValueState,
+        DoneState
+    };
+    
+    Token closeContainer();
+    void parseString();
+    void parseNumber();
+    void parseLiteral(const char* literal, std::size_t length);
+    void skipWhitespace();
+    void error(const std::string& msg) const;
+    
+    void skipContent(Token token);
+    void readObject(Token token, char* obj, const Class& clazz);
+    void readCompound(Token token, char* data, const CompoundClass& clazz);
+    void readField(char* obj, const Class& clazz,
+                   const ClassLayout::Field& field);
+    void readData(Token token, char* data, const Type& type,
+                  const Property* property);
+    void readPrimitive(Token token, char* data, const PrimitiveType& type,
+                       const Property* property);
+    
+    // The parsed document.
+    const char* begin_;
+    const char* end_;
+    const char* pos_;
+    
+    // The last token.
+    Token token_;
+    State state_;
+    
+    // The containers enclosing the current position, '{' or '['.
+    std::string stack_;
+    
+    // The text of the last token.
+    const char* text_;
+    std::size_t textLength_;
+    
+    // The buffer strings with escape sequences are decoded into.
+    std::string scratch_;
+};
+
+
+} // namespace xm
+
+#endif	/* XM_JSON_HPP */
@@ -0,0 +1,92 @@
+/******************************************************************************      
+ *      Extended Mirror: MemoryStats.hpp                                      *
+ ******************************************************************************
+ *      Copyright (c) 2012-2015, Manuele Finocchiaro                          *
+ *      All rights reserved.                                                  *
+ ******************************************************************************
+ * Redistribution and use in source and binary forms, with or without         *
+ * modification, are permitted provided that the following conditions         *
+ * are met:                                                                   *
+ *                                                                            *
+ *    1. Redistributions of source code must retain the above copyright       *
+ *       notice, this list of conditions and the following disclaimer.        *
+ *                                                                            *
+ *    2. Redistributions in binary form must reproduce the above copyright    *
+ *       notice, this list of conditions and the following disclaimer in      *
+ *       the documentation and/or other materials provided with the           *
+ *       distribution.                                                        *
+ *                                                                            *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"* 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE  *
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE *
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE  *
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR        *
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF       *
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS   *
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN    *
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)    *
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF     *
+ * THE POSSIBILITY OF SUCH DAMAGE.                                            *
+ *****************************************************************************/
+
+
+#ifndef XM_MEMORYSTATS_HPP
+#define	XM_MEMORYSTATS_HPP
+
+namespace xm {
+
+
+/**
+ * The memory used by the registered metadata, in bytes, by category.
+ * Object sizes are those of the base descriptor classes, so the figures are
+ * a close lower bound of the actual footprint.
+ */
+struct MemoryStats
+{
+    MemoryStats()
+        : items(0), types(0), members(0), namespaces(0), names(0),
+          containers(0), memberTables(0), layouts(0), total(0)
+    {
+    }
+    
+    /** The number of registered items, members included. */
+    std::size_t items;
+    
+    /** The type descriptors. */
+    std::size_t types;
+    
+    /** The member descriptors: properties, methods, casters, parameters. */
+    std::size_t members;
+    
+    /** The namespaces and the other items. */
+    std::size_t namespaces;
+    
+    /** The names not fitting in the string objects. */
+    std::size_t names;
+    
+    /** The containers of the namespaces and of the classes. */
+    std::size_t containers;
+    
+    /** The dispatch slots and the member tables flattened so far. */
+    std::size_t memberTables;
+    
+    /** The class layouts built so far. */
+    std::size_t layouts;
+    
+    /** The sum of all the categories. */
+    std::size_t total;
+};
+
+
+/**
+ * Measure the memory used by the metadata of the registered items.
+ * The registry is walked from the root namespace, each item is counted once.
+ * 
+ * @return The memory used, by category.
+ */
+MemoryStats memoryStats();
+
+
+} // namespace xm
+
+#endif	/* XM_MEMORYSTATS_HPP */
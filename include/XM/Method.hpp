@@ -100,9 +100,24 @@ public:
      * @return True if the method is constant, false otherwise.
      */
     virtual bool isConst() const;
+    
+    /**
+     * Get the dispatch slot of the method. Slots are numbered within each
+     * class hierarchy like the entries of a virtual table: the slots of the
+     * base classes come first and a derived class extends them, while an
+     * override takes the slot of the method it overrides. Methods may be
+     * moved to a new slot when a base class is added to a class whose slots
+     * would clash with the ones of the base. See Class::getMethodBySlot().
+     * 
+     * @return The slot, NoSlot if the method is not bound.
+     */
+    std::size_t getSlot() const;
 
     Item::Category getItemCategory() const;
     
+    /** The slot of the methods not bound to a class. */
+    static const std::size_t NoSlot = std::size_t(-1);
+    
 protected:
     bool before_(const Item& item) const;
 
@@ -111,6 +126,11 @@ protected:
     /// Whether the method is constant.
     bool constant_;
     
+    // The dispatch slot, assigned by the class the method is bound to.
+    std::size_t slot_;
+    
+    friend class Class;
+    
     friend bool operator<(const Method& m1, const Method& m2);
 };
 
@@ -123,7 +143,7 @@ bool inline operator<(const Method& m1, const Method& m2)
 
 
 typedef std::set<Method*, PtrCmpByVal<Method> > Method_Set;
-typedef std::set<const Method*, PtrCmpByVal<Method> > Const_Method_Set;
+typedef FlatSet<const Method*, PtrCmpByVal<Method> > Const_Method_Set;
 
 } // namespace xm
 
@@ -35,6 +35,8 @@
 
 namespace xm {
 
+class MemoryStatsCollector;
+
 typedef std::set<Item*, ::PtrCmpByVal<Item> > Item_Set;
 typedef std::set<const Item*, ::PtrCmpByVal<Item> > Const_Item_Set;
 typedef void (*ItemInspector)(const Item& item);
@@ -54,6 +56,22 @@ public:
     template<typename T = Item>
     const T& getItem(const std::string& path, const T& keyItem) const;
     
+    /**
+     * Find an item by name, without throwing when there is none.
+     * 
+     * @param name The name of the item, possibly qualified.
+     * @return A pointer to the item, or NULL if no item of type T has the
+     *     given name.
+     */
+    template<typename T = Item>
+    const T* findItem(const std::string& name) const;
+
+    template<typename T = Item>
+    const T* findItem(const T& keyItem) const;
+
+    template<typename T = Item>
+    const T* findItem(const std::string& path, const T& keyItem) const;
+    
     void walkItems(ItemInspector fnc, bool recursive = false) const;
     
     Namespace& defineNamespace(const std::string& path);
@@ -77,13 +95,28 @@ protected:
 
     template<typename T = Item>
     T& getItem_(const std::string& path, const T& keyItem);
+    
+    template<typename T = Item>
+    T* findItem_(const std::string& name);
+    
+    template<typename T = Item>
+    T* findItem_(const std::string& path, const T& keyItem);
 
-    virtual Namespace& walkTo(const std::string& path, bool create = false);
+    Namespace& walkTo(const std::string& path, bool create = false);
+    
+    // Walk to the namespace at the given path, NULL if there is none and
+    // it is not created.
+    virtual Namespace* walkTo_(const std::string& path, bool create);
+    
+    // Find an item of this namespace by key, NULL if there is none.
+    virtual const Item* lookupItem_(const Item& keyItem) const;
     
     static bool addNamespace_(Namespace& where, const std::string& what);
     
     Const_Item_Set items_;
     Const_Item_Set ownItems_;
+    
+    friend class MemoryStatsCollector;
 };
 
 
@@ -0,0 +1,275 @@
+/******************************************************************************      
+ *      Extended Mirror: ObjectStore.hpp                                      *
+ ******************************************************************************
+ *      Copyright (c) 2012-2015, Manuele Finocchiaro                          *
+ *      All rights reserved.                                                  *
+ ******************************************************************************
+ * Redistribution and use in source and binary forms, with or without         *
+ * modification, are permitted provided that the following conditions         *
+ * are met:                                                                   *
+ *                                                                            *
+ *    1. Redistributions of source code must retain the above copyright       *
+ *       notice, this list of conditions and the following disclaimer.        *
+ *                                                                            *
+ *    2. Redistributions in binary form must reproduce the above copyright    *
+ *       notice, this list of conditions and the following disclaimer in      *
+ *       the documentation and/or other materials provided with the           *
+ *       distribution.                                                        *
+ *                                                                            *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"* 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE  *
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE *
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE  *
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR        *
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF       *
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS   *
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN    *
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)    *
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF     *
+ * THE POSSIBILITY OF SUCH DAMAGE.                                            *
+ *****************************************************************************/
+
+
+#ifndef XM_OBJECTSTORE_HPP
+#define	XM_OBJECTSTORE_HPP
+
+namespace xm {
+
+
+/**
+ * The kinds of secondary index of an ObjectStore.
+ */
+enum IndexKind
+{
+    /** Supports point lookups only. */
+    HashIndex,
+    
+    /** Supports point and range lookups, returned in key order. */
+    OrderedIndex
+};
+
+
+/**
+ * A collection of instances of a class, not owned by the store, with
+ * secondary indexes on properties chosen at runtime.
+ * 
+ * Indexed properties must be of primitive or enumeration type. Index keys
+ * are the values converted by getSortKey(), so that the ordered indexes
+ * sort as the values; properties bound to a field are read through their
+ * offset in the class layout.
+ * 
+ * The stored instances are observed with a ChangeTracker: the indexes follow
+ * the changes made through Property::setData(), which are applied in a batch
+ * before the next lookup, or when refresh() is called. Changes made writing
+ * the fields directly, or calling the setters directly, must be reported
+ * with update().
+ * 
+ * A QueryException is thrown looking up a property without a suitable
+ * index, a VariantTypeException if the value looked up is not of the type of
+ * the property.
+ */
+class ObjectStore : private ChangeListener
+{
+public:
+    /**
+     * Create an empty store.
+     * 
+     * @param clazz The class of the stored instances.
+     */
+    ObjectStore(const Class& clazz);
+    
+    /**
+     * Get the class of the stored instances.
+     * 
+     * @return The class.
+     */
+    const Class& getClass() const;
+    
+    /**
+     * Add an index on a property, indexing the instances already stored.
+     * A QueryException is thrown if the property is not of primitive type
+     * or is already indexed.
+     * 
+     * @param property The property name.
+     * @param kind The kind of index.
+     */
+    void addIndex(const std::string& property, IndexKind kind);
+    
+    /**
+     * Add an instance. Nothing is done if the instance is already stored.
+     * A VariantTypeException is thrown if the instance is not of the class
+     * of the store.
+     * 
+     * @param object A reference variant to the instance.
+     */
+    void insert(const Variant& object);
+    
+    /**
+     * Remove an instance. Nothing is done if the instance is not stored.
+     * 
+     * @param object A reference variant to the instance.
+     */
+    void erase(const Variant& object);
+    
+    /**
+     * Ask whether an instance is stored.
+     * 
+     * @param object A reference variant to the instance.
+     * @return true if the instance is stored.
+     */
+    bool contains(const Variant& object) const;
+    
+    /**
+     * Get the number of stored instances.
+     * 
+     * @return The number of instances.
+     */
+    std::size_t getSize() const;
+    
+    /**
+     * Re-index an instance whose properties were changed without going
+     * through Property::setData().
+     * 
+     * @param object A reference variant to the instance.
+     */
+    void update(const Variant& object);
+    
+    /**
+     * Apply to the indexes the pending changes made through
+     * Property::setData().
+     */
+    void refresh();
+    
+    /**
+     * Find the instances with the given value of an indexed property.
+     * 
+     * @param property The property name.
+     * @param value The value.
+     * @param result Filled with the addresses of the instances, in no
+     * particular order.
+     */
+    void find(const std::string& property,
+              const Variant& value,
+              std::vector<void*>& result);
+    
+    /**
+     * Find the instances with the value of a property with an ordered index
+     * within a closed range.
+     * 
+     * @param property The property name.
+     * @param low The lower bound.
+     * @param high The upper bound.
+     * @param result Filled with the addresses of the instances, in increasing
+     * order of the property value.
+     */
+    void findRange(const std::string& property,
+                   const Variant& low,
+                   const Variant& high,
+                   std::vector<void*>& result);
+    
+    template<class T>
+    void find(const std::string& property,
+              const Variant& value,
+              std::vector<T*>& result);
+    
+    template<class T>
+    void findRange(const std::string& property,
+                   const Variant& low,
+                   const Variant& high,
+                   std::vector<T*>& result);
+    
+    ~ObjectStore();
+    
+private:
+    // Instances with the same key of a hash index.
+    typedef std::vector<void*> Bucket;
+    
+    // An index on a property.
+    struct Index
+    {
+        const Property* property;
+        const PrimitiveType* type;
+        
+        // The offset of the property, -1 if it is accessed through getter.
+        std::ptrdiff_t offset;
+        
+        IndexKind kind;
+        std::unordered_map<std::uint64_t, Bucket> buckets;
+        std::set<std::pair<std::uint64_t, void*> > entries;
+        
+        // The key of each slot.
+        std::vector<std::uint64_t> keys;
+    };
+    
+    typedef std::unordered_map<void*, std::size_t> Slot_Map;
+    
+    ObjectStore(const ObjectStore&);
+    ObjectStore& operator=(const ObjectStore&);
+    
+    // Look up an index by property name.
+    Index& getIndex(const std::string& property);
+    
+    // Compute the key of an instance for an index.
+    std::uint64_t getKey(const Index& index, void* object) const;
+    
+    // Compute the key of a value looked up on an index.
+    std::uint64_t getKey(const Index& index, const Variant& value) const;
+    
+    // Add and remove an instance to an index.
+    void addEntry(Index& index, void* object, std::size_t slot);
+    void removeEntry(Index& index, void* object, std::size_t slot);
+    
+    // Re-index an instance on a changed property.
+    void propertiesChanged(const Variant& object,
+                           const std::vector<const Property*>& properties);
+    
+    // The class of the instances.
+    const Class& clazz_;
+    
+    // The indexes.
+    std::vector<Index*> indexes_;
+    
+    // The stored instances and their slots in the index keys.
+    Slot_Map slots_;
+    
+    // The released slots.
+    std::vector<std::size_t> freeSlots_;
+    
+    // The number of allocated slots.
+    std::size_t slotCount_;
+    
+    // Observes the instances.
+    ChangeTracker tracker_;
+};
+
+
+template<class T>
+void ObjectStore::find(const std::string& property,
+                       const Variant& value,
+                       std::vector<T*>& result)
+{
+    std::vector<void*> addresses;
+    find(property, value, addresses);
+    result.clear();
+    for (std::size_t i = 0; i < addresses.size(); i++)
+        result.push_back(static_cast<T*>(addresses[i]));
+}
+
+
+template<class T>
+void ObjectStore::findRange(const std::string& property,
+                            const Variant& low,
+                            const Variant& high,
+                            std::vector<T*>& result)
+{
+    std::vector<void*> addresses;
+    findRange(property, low, high, addresses);
+    result.clear();
+    for (std::size_t i = 0; i < addresses.size(); i++)
+        result.push_back(static_cast<T*>(addresses[i]));
+}
+
+
+} // namespace xm
+
+#endif	/* XM_OBJECTSTORE_HPP */
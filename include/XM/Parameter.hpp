@@ -44,6 +44,16 @@ struct Parameter
     : type(type), byNcReference(byNcReference)
     {};
     
+    static void* operator new(std::size_t size)
+    {
+        return allocateMetadata(size);
+    }
+    
+    static void operator delete(void* ptr)
+    {
+        releaseMetadata(ptr);
+    }
+    
     /** The parameter type. */
     const Type& type;
     
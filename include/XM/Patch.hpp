@@ -0,0 +1,76 @@
+/******************************************************************************      
+ *      Extended Mirror: Patch.hpp                                            *
+ ******************************************************************************
+ *      Copyright (c) 2012-2015, Manuele Finocchiaro                          *
+ *      All rights reserved.                                                  *
+ ******************************************************************************
+ * Redistribution and use in source and binary forms, with or without         *
+ * modification, are permitted provided that the following conditions         *
+ * are met:                                                                   *
+ *                                                                            *
+ *    1. Redistributions of source code must retain the above copyright       *
+ *       notice, this list of conditions and the following disclaimer.        *
+ *                                                                            *
+ *    2. Redistributions in binary form must reproduce the above copyright    *
+ *       notice, this list of conditions and the following disclaimer in      *
+ *       the documentation and/or other materials provided with the           *
+ *       distribution.                                                        *
+ *                                                                            *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"* 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE  *
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE *
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE  *
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR        *
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF       *
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS   *
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN    *
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)    *
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF     *
+ * THE POSSIBILITY OF SUCH DAMAGE.                                            *
+ *****************************************************************************/
+
+
+#ifndef XM_PATCH_HPP
+#define	XM_PATCH_HPP
+
+namespace xm {
+
+
+/**
+ * Write a patch with the properties that differ between two instances of a
+ * class.
+ * 
+ * Properties are compared following the class layout: runs of adjacent
+ * primitive fields are compared with a single memcmp, nested classes are
+ * compared recursively and only their changed properties are written.
+ * Containers and the other template instances, and properties accessed
+ * through getters and setters, are compared as a whole and written as a
+ * whole. Pointers are not compared.
+ * 
+ * The patch is binary: the schema fingerprint of the class, then each changed
+ * property as a variable length field index followed by its value, encoded as
+ * in serialize(), and a zero terminator.
+ * 
+ * @param from A variant holding the old instance.
+ * @param to A variant holding the new instance, of the same class.
+ * @param out The stream to write the patch into.
+ * @return true if the instances differ, false if the patch is empty.
+ */
+bool diff(const Variant& from, const Variant& to, OutStream& out);
+
+
+/**
+ * Apply a patch written by diff() to an instance of the class.
+ * Properties that cannot be set are read and discarded.
+ * A SerializationException is thrown if the patch was written for a
+ * different class schema.
+ * 
+ * @param patch The stream to read the patch from.
+ * @param target A reference variant to the instance to patch.
+ */
+void apply(InStream& patch, const Variant& target);
+
+
+} // namespace xm
+
+#endif	/* XM_PATCH_HPP */
@@ -35,18 +35,70 @@
 
 namespace xm {
 
+class Enum;
+
 
 class PrimitiveType : public Type
 {
 public:
+    /**
+     * The fundamental type the primitive corresponds to. Primitives that are
+     * not one of the builtin ones, such as enumerations, are of kind Other.
+     */
+    enum Kind
+    {
+        Other,
+        Bool,
+        Char,
+        WChar,
+        Short,
+        Int,
+        Long,
+        Float,
+        Double,
+        UChar,
+        UShort,
+        UInt,
+        ULong
+    };
+    
     Category getCategory() const;
     
+    /**
+     * Get the fundamental type the primitive corresponds to.
+     * 
+     * @return The primitive kind.
+     */
+    Kind getKind() const;
+    
+    /**
+     * Get the Enum describing the values of this type, if the type is an
+     * enumeration bound with bindEnum<T>(), NULL otherwise.
+     * 
+     * @return The Enum or NULL.
+     */
+    const Enum* getEnum() const;
+    
+    /**
+     * Set the Enum describing the values of this type.
+     * 
+     * @param xmEnum The Enum.
+     */
+    void setEnum(const Enum& xmEnum);
+    
     virtual ~PrimitiveType();
     
 private:
     PrimitiveType(const std::string& name,
                   std::size_t size,
-                  const std::type_info& cppType);
+                  const std::type_info& cppType,
+                  Kind kind = Other);
+    
+    // The fundamental type.
+    Kind kind_;
+    
+    // The Enum of the type if it is an enumeration.
+    const Enum* enum_;
     
     // Factory class
     template<typename T>
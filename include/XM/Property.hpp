@@ -181,10 +181,27 @@ public:
      * @param data Variant containing the data to be set.
      */
     virtual void setData(const Variant& self, const Variant& data) const;
+    
+    /**
+     * Get the offset of the property field within an instance of the owner
+     * Class.
+     * If the property is not bound to a field then -1 is returned.
+     * 
+     * @return The field offset.
+     */
+    virtual std::ptrdiff_t getOffset() const;
 
     Category getItemCategory() const;
 
 protected:
+    /**
+     * Report the setting of the property on an instance to the change
+     * trackers. Must be called by the setData() implementations.
+     * 
+     * @param self Reference variant of the instance.
+     */
+    void notifySet(const Variant& self) const;
+    
     // The property Type.
     const Type* type_;
     
@@ -199,7 +216,7 @@ bool inline operator<(const Property& p1, const Property& p2)
 }
 
 typedef std::set<Property*, PtrCmpByVal<Property> > Property_Set;
-typedef std::set<const Property*, PtrCmpByVal<Property> > Const_Property_Set;
+typedef FlatSet<const Property*, PtrCmpByVal<Property> > Const_Property_Set;
 
 } // namespace xm
 
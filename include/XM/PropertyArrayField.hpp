@@ -125,6 +125,12 @@ public:
     }
     
     
+    std::ptrdiff_t getOffset() const
+    {
+        return offset;
+    }
+    
+    
 private:
     
     /// The offset of the field within the object.
@@ -195,6 +195,13 @@ public:
         
         // the field is assigned the new data
         fieldRef = extractedValue;
+        notifySet(self);
+    }
+    
+    
+    std::ptrdiff_t getOffset() const
+    {
+        return offset_;
     }
     
 private:
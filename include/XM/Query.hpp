@@ -0,0 +1,296 @@
+/******************************************************************************      
+ *      Extended Mirror: Query.hpp                                            *
+ ******************************************************************************
+ *      Copyright (c) 2012-2015, Manuele Finocchiaro                          *
+ *      All rights reserved.                                                  *
+ ******************************************************************************
+ * Redistribution and use in source and binary forms, with or without         *
+ * modification, are permitted provided that the following conditions         *
+ * are met:                                                                   *
+ *                                                                            *
+ *    1. Redistributions of source code must retain the above copyright       *
+ *       notice, this list of conditions and the following disclaimer.        *
+ *                                                                            *
+ *    2. Redistributions in binary form must reproduce the above copyright    *
+ *       notice, this list of conditions and the following disclaimer in      *
+ *       the documentation and/or other materials provided with the           *
+ *       distribution.                                                        *
+ *                                                                            *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"* 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE  *
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE *
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE  *
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR        *
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF       *
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS   *
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN    *
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)    *
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF     *
+ * THE POSSIBILITY OF SUCH DAMAGE.                                            *
+ *****************************************************************************/
+
+
+#ifndef XM_QUERY_HPP
+#define	XM_QUERY_HPP
+
+namespace xm {
+
+
+/**
+ * A predicate over the instances of a class, compiled once from its textual
+ * form and then evaluated over collections of instances.
+ * 
+ * The predicate is made of comparisons combined with &&, || and !, with
+ * parenthesis. A comparison is made of two operands and one of the operators
+ * ==, !=, <, <=, >, >=; a single operand is true if it is not zero.
+ * Operands are property paths, such as "position.x", numbers, true, false
+ * and, when compared with a property of enumeration type, enumeration keys,
+ * either bare or quoted:
+ * 
+ *     width > 10 && (kind == Proton || !isMouseOver)
+ * 
+ * Compiling resolves the property paths into field offsets and getter calls,
+ * the enumeration keys into their values and selects, for each operand, a
+ * loader for its primitive kind; comparisons are then made between integers,
+ * unsigned if any of the operands is of unsigned kind or a literal above the
+ * range of long long, or, if any of the operands is a floating point value,
+ * between doubles.
+ * 
+ * Once the instances are filtered, project() extracts the values of property
+ * paths from them into columns, resolving the paths the same way.
+ * 
+ * A QueryException is thrown if the predicate is malformed or refers to
+ * unknown properties.
+ */
+class Query
+{
+public:
+    /**
+     * The minimum number of instances filter() processes in parallel.
+     */
+    static const std::size_t ParallelThreshold = 16384;
+    
+    /**
+     * Compile a predicate.
+     * 
+     * @param clazz The class of the instances the query is evaluated on.
+     * @param predicate The predicate.
+     */
+    Query(const Class& clazz, const std::string& predicate);
+    
+    /**
+     * Get the class the query is evaluated on.
+     * 
+     * @return The class.
+     */
+    const Class& getClass() const;
+    
+    /**
+     * Evaluate the predicate on an instance.
+     * 
+     * @param object Pointer to the instance.
+     * @return true if the instance matches the predicate.
+     */
+    bool matches(const void* object) const;
+    
+    /**
+     * Evaluate the predicate on an instance.
+     * A QueryException is thrown if the variant does not hold an instance of
+     * the class of the query.
+     * 
+     * @param object A variant holding the instance.
+     * @return true if the instance matches the predicate.
+     */
+    bool matches(const Variant& object) const;
+    
+    /**
+     * Find the instances of an array that match the predicate.
+     * Arrays of at least ParallelThreshold instances are split among the
+     * given number of threads.
+     * 
+     * @param objects Pointer to the first instance of the array.
+     * @param count The number of instances.
+     * @param indexes Filled with the indexes of the matching instances, in
+     * increasing order.
+     * @param threads The number of threads, 0 to use one per hardware thread.
+     */
+    void filter(const void* objects,
+                std::size_t count,
+                std::vector<std::size_t>& indexes,
+                unsigned threads = 0) const;
+    
+    /**
+     * Find the instances of a vector that match the predicate.
+     * A QueryException is thrown if T is not the class of the query.
+     * 
+     * @param objects The instances.
+     * @param matches Filled with pointers to the matching instances.
+     * @param threads The number of threads, 0 to use one per hardware thread.
+     */
+    template<class T>
+    void filter(const std::vector<T>& objects,
+                std::vector<const T*>& matches,
+                unsigned threads = 0) const
+    {
+        checkClass(xm::getClass<T>());
+        std::vector<std::size_t> indexes;
+        filter(objects.empty() ? NULL : &objects[0], objects.size(), indexes,
+                threads);
+        matches.resize(indexes.size());
+        for (std::size_t i = 0; i < indexes.size(); i++)
+            matches[i] = &objects[indexes[i]];
+    }
+    
+    /**
+     * Extract the values of a property path from some instances of an array,
+     * typically the ones found by filter().
+     * The path is resolved as the operands of the predicate are, so it must
+     * lead to a property of primitive type.
+     * 
+     * @param path The property path, such as "position.x".
+     * @param objects Pointer to the first instance of the array.
+     * @param indexes The indexes of the instances.
+     * @param column Filled with the value of the path for each instance.
+     */
+    void project(const std::string& path,
+                 const void* objects,
+                 const std::vector<std::size_t>& indexes,
+                 std::vector<long long>& column) const;
+    
+    /**
+     * Extract the values of a property path from some instances of an array.
+     * 
+     * @param path The property path.
+     * @param objects Pointer to the first instance of the array.
+     * @param indexes The indexes of the instances.
+     * @param column Filled with the value of the path for each instance.
+     */
+    void project(const std::string& path,
+                 const void* objects,
+                 const std::vector<std::size_t>& indexes,
+                 std::vector<unsigned long long>& column) const;
+    
+    /**
+     * Extract the values of a property path from some instances of an array.
+     * 
+     * @param path The property path.
+     * @param objects Pointer to the first instance of the array.
+     * @param indexes The indexes of the instances.
+     * @param column Filled with the value of the path for each instance.
+     */
+    void project(const std::string& path,
+                 const void* objects,
+                 const std::vector<std::size_t>& indexes,
+                 std::vector<double>& column) const;
+    
+    /**
+     * Extract the values of property paths from the instances of a vector
+     * that match the predicate, one column per path.
+     * A QueryException is thrown if T is not the class of the query.
+     * 
+     * @param objects The instances.
+     * @param paths The property paths.
+     * @param columns Filled with one column for each path.
+     * @param threads The number of threads filtering the instances, 0 to use
+     * one per hardware thread.
+     */
+    template<class T, typename ValueT>
+    void project(const std::vector<T>& objects,
+                 const std::vector<std::string>& paths,
+                 std::vector<std::vector<ValueT> >& columns,
+                 unsigned threads = 0) const
+    {
+        checkClass(xm::getClass<T>());
+        std::vector<std::size_t> indexes;
+        const T* data = objects.empty() ? NULL : &objects[0];
+        filter(data, objects.size(), indexes, threads);
+        columns.resize(paths.size());
+        for (std::size_t i = 0; i < paths.size(); i++)
+            project(paths[i], data, indexes, columns[i]);
+    }
+    
+private:
+    // A step to reach a value from an instance: an offset or, if getter is
+    // not NULL, a getter call on an instance of owner.
+    struct Step
+    {
+        std::ptrdiff_t offset;
+        const Property* getter;
+        const Class* owner;
+    };
+    
+    // A property path or a constant.
+    struct Operand
+    {
+        std::vector<Step> steps;
+        bool constant;
+        bool floating;
+        bool isUnsigned;
+        long long integerValue;
+        double floatingValue;
+        long long (*loadInteger)(const char* data);
+        double (*loadFloating)(const char* data);
+        const PrimitiveType* type;
+        
+        // the text of a not yet resolved identifier or string
+        std::string key;
+    };
+    
+    enum NodeKind
+    {
+        AndNode,
+        OrNode,
+        NotNode,
+        CompareNode,
+        TestNode
+    };
+    
+    enum Comparison
+    {
+        Equal,
+        NotEqual,
+        Less,
+        LessEqual,
+        Greater,
+        GreaterEqual
+    };
+    
+    // A node of the predicate tree.
+    struct Node
+    {
+        NodeKind kind;
+        std::size_t left;
+        std::size_t right;
+        Comparison comparison;
+        bool floating;
+        bool isUnsigned;
+        Operand lhs;
+        Operand rhs;
+    };
+    
+    class Parser;
+    
+    void checkClass(const Type& type) const;
+    bool evaluate(std::size_t node, const char* object) const;
+    long long evaluateInteger(const Operand& operand, const char* obj) const;
+    double evaluateFloating(const Operand& operand, const char* obj) const;
+    const char* resolve(const Operand& operand,
+                        const char* obj,
+                        Variant& holder) const;
+    template<typename T>
+    void project_(const std::string& path,
+                  const void* objects,
+                  const std::vector<std::size_t>& indexes,
+                  std::vector<T>& column) const;
+    
+    // The class of the instances.
+    const Class* class_;
+    
+    // The nodes, the root being the last one.
+    std::vector<Node> nodes_;
+};
+
+
+} // namespace xm
+
+#endif	/* XM_QUERY_HPP */
@@ -73,24 +73,67 @@ template<typename T>
 XM_DEFINE_CLASS(std::greater_equal<T>){}
 
 
+XM_DECLARE_TEMPLATE_1(std::hash)
+template<typename T>
+XM_DEFINE_CLASS(std::hash<T>){}
+
+
+XM_DECLARE_TEMPLATE_2(std::pair)
+template<typename T1, typename T2>
+XM_DEFINE_CLASS(std::pair<T1, T2>)
+{
+    bindProperty(XM_MNP(first));
+    bindProperty(XM_MNP(second));
+}
+
+
 XM_DECLARE_TEMPLATE_2(std::vector)
 template<typename T, typename Allocator>
-XM_DEFINE_CLASS(std::vector<T, Allocator>){}
+XM_DEFINE_CLASS(std::vector<T, Allocator>)
+{
+    bindSequence<ClassT>();
+}
 
 
 XM_DECLARE_TEMPLATE_3(std::basic_string)
 template<typename CharT, typename Traits, typename Allocator>
-XM_DEFINE_CLASS(std::basic_string<CharT, Traits, Allocator>){}
+XM_DEFINE_CLASS(std::basic_string<CharT, Traits, Allocator>)
+{
+    bindSequence<ClassT>();
+}
 
 
 XM_DECLARE_TEMPLATE_3(std::set)
 template<typename Key, typename Compare, typename Allocator>
-XM_DEFINE_CLASS(std::set<Key, Compare, Allocator>){}
+XM_DEFINE_CLASS(std::set<Key, Compare, Allocator>)
+{
+    bindAssociative<ClassT>();
+}
 
 
 XM_DECLARE_TEMPLATE_4(std::map)
 template<typename Key, typename T, typename Compare, typename Allocator>
-XM_DEFINE_CLASS(std::map<Key, T, Compare, Allocator>){}
+XM_DEFINE_CLASS(std::map<Key, T, Compare, Allocator>)
+{
+    bindAssociative<ClassT>();
+}
+
+
+XM_DECLARE_TEMPLATE_4(std::unordered_set)
+template<typename Key, typename Hash, typename KeyEqual, typename Allocator>
+XM_DEFINE_CLASS(std::unordered_set<Key, Hash, KeyEqual, Allocator>)
+{
+    bindAssociative<ClassT>();
+}
+
+
+XM_DECLARE_TEMPLATE_5(std::unordered_map)
+template<typename Key, typename T, typename Hash, typename KeyEqual,
+         typename Allocator>
+XM_DEFINE_CLASS(std::unordered_map<Key, T, Hash, KeyEqual, Allocator>)
+{
+    bindAssociative<ClassT>();
+}
         
 #endif	/* XM_REFLECTSTD_HPP */
 
@@ -49,6 +49,8 @@ public:
     
     const Type& getType(const std::type_info& cppType) const;
     
+    const Type* findType(const std::type_info& cppType) const;
+    
     const Class& getClass(const std::type_info& cppType) const;
     
     template<typename T>
@@ -85,7 +87,73 @@ public:
     
     static Register& getSingleton();
     
+    /**
+     * Queue the registration of a type, to be performed by initialize().
+     * XM_REGISTER_TYPE queues the types instead of registering them when
+     * XM_DEFERRED_REGISTRATION is defined.
+     * 
+     * @param registerFnc The function registering the type.
+     */
+    void enqueueType(const Type& (*registerFnc)());
+    
+    /**
+     * Register the queued types, defining the classes on the given number of
+     * threads.
+     * 
+     * A class registering a base class or the type of a property waits until
+     * the thread defining it is done, so the dependencies of a class are
+     * complete when it uses them. Cyclic dependencies get the partially
+     * defined type, as when registering serially.
+     * 
+     * @param threads The number of threads, 0 to use one per hardware thread.
+     */
+    void initialize(unsigned threads = 0);
+    
+    /**
+     * Serializes the changes to the register and to the items it holds
+     * against each other and against the lookups of items, so that types can
+     * be registered lazily from any thread as well as by initialize().
+     * Lookups take the lock shared and run in parallel, changes take it
+     * exclusive. The lock is recursive, a shared lock within an exclusive one
+     * is granted, while a shared lock cannot be turned into an exclusive one.
+     * It is not held while waiting for a type defined by another thread.
+     */
+    class Lock
+    {
+    public:
+        enum Mode
+        {
+            Exclusive,
+            Shared
+        };
+        
+        explicit Lock(Mode mode = Exclusive);
+        
+        ~Lock();
+        
+    private:
+        Lock(const Lock&);
+        Lock& operator=(const Lock&);
+        
+        Mode mode_;
+    };
+    
 private:
+    
+    // Registration state of a type.
+    struct TypeSlot
+    {
+        TypeSlot();
+        
+        // set once the type is completely defined
+        std::atomic<Type*> type;
+        
+        // set once the type is created, while its class is being defined
+        Type* partial;
+        
+        bool claimed;
+        std::thread::id owner;
+    };
 
      /*
       * Singleton restrictions.
@@ -105,6 +173,25 @@ private:
      */
     template<typename T> Type& registerType_();
     
+    /**
+     * Claim the registration of a type for the calling thread, waiting while
+     * another thread defines it.
+     * 
+     * @return The registered type, or NULL if the calling thread has to
+     *     register it.
+     */
+    Type* claimType_(TypeSlot& slot);
+    
+    /**
+     * Add a created type to the register, before its class is defined.
+     */
+    void addType_(TypeSlot& slot, Type& type);
+    
+    /**
+     * Mark a type as completely defined, waking the threads waiting for it.
+     */
+    void releaseType_(TypeSlot& slot, Type& type);
+    
     /**
      * Return the function pointer of the callback function to call after each
      * type registration.
@@ -117,6 +204,12 @@ private:
     Type_SetByVal types_;
     Class_SetByVal classes_;
     
+    // types hashed by type id, for constant time lookup.
+    std::unordered_map<std::type_index, Type*> typesById_;
+    
+    // registrations queued for initialize()
+    std::vector<const Type& (*)()> queuedTypes_;
+    
     // this class needs to add Templates to the register
     friend class CompoundClass;
 };
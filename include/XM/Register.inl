@@ -90,28 +90,42 @@ template<typename T>
 Type& Register::registerType_()
 {
     // store registered type for subsequent calls
-    static Type* type = NULL;
+    static TypeSlot slot;
     
     // check for already registered type
+    Type* type = slot.type.load(std::memory_order_acquire);
     if (type) return *type;
     
-    type = &CreateType<T>()();
+    // claim the type, or get it once registered by another thread
+    type = claimType_(slot);
+    if (type) return *type;
     
-    // add Type to its Namespace
-    addItem(*type);
+    // place the type metadata in the arena
+    Arena::Scope arenaScope;
     
-    types_.insert(type);
+    type = &CreateType<T>()();
+    
+    // add Type to its Namespace and to the register
+    addType_(slot, *type);
     
     Class* clazz = dynamic_cast<Class*>(type);
     if (clazz)
-    {   
-        classes_.insert(clazz);
-        
+    {
         // build class members
-        DefineClass<T> buildClass;
-        buildClass();
+        try
+        {
+            DefineClass<T> buildClass;
+            buildClass();
+        }
+        catch (...)
+        {
+            releaseType_(slot, *type);
+            throw;
+        }
     }
     
+    releaseType_(slot, *type);
+    
     XM_DEBUG_MSG("type \"" << type->getName() << "\" registered")
     
     // return the type
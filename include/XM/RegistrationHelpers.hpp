@@ -109,6 +109,16 @@ struct GetTypeName<void>
 };
 
 
+template<typename T>
+struct GetTypeName<const T>
+{
+    std::string operator()()
+    {
+        return "const " + GetTypeName<T>()();
+    }
+};
+
+
 template<typename T>
 struct GetTypeName<T*>
 {
@@ -134,12 +144,44 @@ struct GetTypeName<T(*)[size]>
 };
 
 
+/**
+ * The value member is the PrimitiveType::Kind of T.
+ */
+template<typename T>
+struct PrimitiveKind
+{
+    static const PrimitiveType::Kind value = PrimitiveType::Other;
+};
+
+
+#define _XM_SPECIALIZE_PRIMITIVE_KIND(_type_, _kind_)                          \
+template<>                                                                     \
+struct PrimitiveKind<_type_>                                                   \
+{                                                                              \
+    static const PrimitiveType::Kind value = PrimitiveType::_kind_;            \
+};
+
+_XM_SPECIALIZE_PRIMITIVE_KIND(bool, Bool)
+_XM_SPECIALIZE_PRIMITIVE_KIND(char, Char)
+_XM_SPECIALIZE_PRIMITIVE_KIND(wchar_t, WChar)
+_XM_SPECIALIZE_PRIMITIVE_KIND(short, Short)
+_XM_SPECIALIZE_PRIMITIVE_KIND(int, Int)
+_XM_SPECIALIZE_PRIMITIVE_KIND(long, Long)
+_XM_SPECIALIZE_PRIMITIVE_KIND(float, Float)
+_XM_SPECIALIZE_PRIMITIVE_KIND(double, Double)
+_XM_SPECIALIZE_PRIMITIVE_KIND(uchar, UChar)
+_XM_SPECIALIZE_PRIMITIVE_KIND(ushort, UShort)
+_XM_SPECIALIZE_PRIMITIVE_KIND(uint, UInt)
+_XM_SPECIALIZE_PRIMITIVE_KIND(ulong, ULong)
+
+
 template<typename T>
 struct CreateType
 {
     Type& operator()()
     {
-        return *new PrimitiveType(GetTypeName<T>()(), sizeof(T), typeid(T));
+        return *new PrimitiveType(GetTypeName<T>()(), sizeof(T), typeid(T),
+                PrimitiveKind<T>::value);
     }
 };
 
@@ -180,6 +222,23 @@ struct CreateType<void>
 };
 
 
+template<>
+struct GetTypeName<std::string>
+{
+    std::string operator()()
+    {
+        return "std::string";
+    }
+};
+
+
+template<>
+struct CreateType<std::string>
+{
+    Type& operator()();
+};
+
+
 template<class T>
 struct IsAbstract : public FalseType {};
 
@@ -191,6 +250,37 @@ struct DefineClass
 };
 
 
+/**
+ * Get the resolver of the dynamic type of the instances of a class, NULL if
+ * the class is not polymorphic.
+ */
+template<class T, bool = IsPolymorphic<T>::value>
+struct GetDynamicResolver
+{
+    DynamicResolver operator()()
+    {
+        return NULL;
+    }
+};
+
+
+template<class T>
+struct GetDynamicResolver<T, true>
+{
+    static void* resolve(void* object, const std::type_info*& dynamicType)
+    {
+        T* instance = static_cast<T*>(object);
+        dynamicType = &typeid(*instance);
+        return dynamic_cast<void*>(instance);
+    }
+    
+    DynamicResolver operator()()
+    {
+        return &resolve;
+    }
+};
+
+
 /**
  * This helper function is called from the CreateType functor when registering
  * a class. This function is provided to keep the all the possible
@@ -216,45 +306,52 @@ Class& createClass()
     if (templArgListPos == std::string::npos) {
 
         // Allocate memory for class
-        Class* clazz = reinterpret_cast<Class*>(::operator new(sizeof(Class)));
+        Class* clazz =
+                reinterpret_cast<Class*>(allocateMetadata(sizeof(Class)));
 
         // Call constructor
-        return *new (clazz) Class(name_space, nameParts.second, sizeof(T),
+        ::new (clazz) Class(name_space, nameParts.second, sizeof(T),
                 typeid(T), *new ConstructorImpl<T>(*clazz),
                 *new CopyConstructorImpl<T>(*clazz),
                 *new DestructorImpl<T>(*clazz), IsAbstract<T>::value);
+        clazz->dynamicResolver_ = GetDynamicResolver<T>()();
+        return *clazz;
     } else {
 
         // Allocate memory for class
         CompoundClass* clazz = reinterpret_cast<CompoundClass*>(
-                ::operator new(sizeof(CompoundClass)));
+                allocateMetadata(sizeof(CompoundClass)));
 
         // Get the template name
         const std::string tempjateName = typeName.substr(0, templArgListPos);
 
         // Get or create template
-        const Template* tempjate;
         Register& typeReg = Register::getSingleton();
-        try
-        {
-            tempjate = &typeReg.getItem<Template>(tempjateName);
-        }
-        catch(const NotFoundException& e)
+        const Template* tempjate;
         {
-            std::pair<std::string, std::string> nameParts
-                    = splitName(tempjateName, NameTail);
-            Namespace& name_space = xm::defineNamespace(nameParts.first);
-
-            Template* ncTemplate = new Template(nameParts.second, name_space);
-
-            typeReg.addItem(*ncTemplate);
-            tempjate = ncTemplate;
+            Register::Lock lock;
+            tempjate = typeReg.findItem<Template>(tempjateName);
+            if (!tempjate)
+            {
+                std::pair<std::string, std::string> nameParts
+                        = splitName(tempjateName, NameTail);
+                Namespace& name_space = xm::defineNamespace(nameParts.first);
+
+                Template* ncTemplate =
+                        new Template(nameParts.second, name_space);
+
+                typeReg.addItem(*ncTemplate);
+                tempjate = ncTemplate;
+            }
         }
 
-        return *new (clazz) CompoundClass(name_space, nameParts.second, sizeof(T),
+        ::new (clazz) CompoundClass(name_space, nameParts.second, sizeof(T),
                 typeid(T), *new ConstructorImpl<T>(*clazz),
                 *new CopyConstructorImpl<T>(*clazz), *new DestructorImpl<T>(*clazz),
                 IsAbstract<T>::value, *tempjate);
+        static_cast<Class*>(clazz)->dynamicResolver_ =
+                GetDynamicResolver<T>()();
+        return *clazz;
 
     }
 }
@@ -296,6 +393,25 @@ template<class T>
 TypeRegisterer<T> TypeRegisterer<T>::autoregisterer;
 
 
+/**
+ * Like TypeRegisterer, but only queues the registration, which is performed
+ * by Register::initialize().
+ */
+template<class T>
+class DeferredTypeRegisterer
+{
+    DeferredTypeRegisterer()
+    {
+        Register::getSingleton().enqueueType(&registerType<T>);
+    }
+    
+    static DeferredTypeRegisterer autoregisterer;
+};
+
+template<class T>
+DeferredTypeRegisterer<T> DeferredTypeRegisterer<T>::autoregisterer;
+
+
 } //namespace xm
 
 #endif	/* XM_REGISTRATIONHELPERS_HPP */
@@ -54,6 +54,14 @@ struct GetTypeName<_primitive_type_>                                         \
 } // namespace xm
 
 
+/**
+ * \def XM_DECLARE_ENUM(_enum_)
+ * Enables reflection for the enumeration type \a _enum_, which is registered
+ * as a primitive type. Bind its values with bindEnum<_enum_>().
+ */
+#define XM_DECLARE_ENUM(_enum_) XM_DECLARE_PRIMITIVE(_enum_)
+
+
 /**
  * \def XM_DECLARE_CLASS(_class_)
  * 
@@ -155,10 +163,20 @@ XM_ASSUME_NON_COPYABLE(_class_)
  * Ensure the type will be registered at program startup, or when the shared
  * object is loaded dynamically, with no extra code.
  * \a relfected_class is the class to be registered.
+ * 
+ * When XM_DEFERRED_REGISTRATION is defined the type is only queued, and
+ * registered by xm::initialize().
  */
+#ifdef XM_DEFERRED_REGISTRATION
+#define XM_REGISTER_TYPE(...)                                                \
+template class xm::DeferredTypeRegisterer<__VA_ARGS__>;                      \
+
+#else
 #define XM_REGISTER_TYPE(...)                                                \
 template class xm::TypeRegisterer<__VA_ARGS__>;                              \
 
+#endif
+
 
 #define XM_BIND_FREE_ITEMS                                                   \
 _XM_BIND_FREE_ITEMS(__LINE__)
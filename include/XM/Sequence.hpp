@@ -0,0 +1,141 @@
+/******************************************************************************      
+ *      Extended Mirror: Sequence.hpp                                         *
+ ******************************************************************************
+ *      Copyright (c) 2012-2015, Manuele Finocchiaro                          *
+ *      All rights reserved.                                                  *
+ ******************************************************************************
+ * Redistribution and use in source and binary forms, with or without         *
+ * modification, are permitted provided that the following conditions         *
+ * are met:                                                                   *
+ *                                                                            *
+ *    1. Redistributions of source code must retain the above copyright       *
+ *       notice, this list of conditions and the following disclaimer.        *
+ *                                                                            *
+ *    2. Redistributions in binary form must reproduce the above copyright    *
+ *       notice, this list of conditions and the following disclaimer in      *
+ *       the documentation and/or other materials provided with the           *
+ *       distribution.                                                        *
+ *                                                                            *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"* 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE  *
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE *
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE  *
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR        *
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF       *
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS   *
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN    *
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)    *
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF     *
+ * THE POSSIBILITY OF SUCH DAMAGE.                                            *
+ *****************************************************************************/
+
+
+#ifndef XM_SEQUENCE_HPP
+#define	XM_SEQUENCE_HPP
+
+namespace xm {
+
+
+/**
+ * Reflects the interface of a sequence container, such as std::vector, so
+ * that its elements can be accessed without knowing its C++ type.
+ * 
+ * The containers are always passed as Variant, their constness is honored.
+ */
+class Sequence
+{
+public:
+    /**
+     * Constructor.
+     * 
+     * @param elementType The type of the elements.
+     * @param contiguous Whether the elements are stored contiguously.
+     */
+    Sequence(const Type& elementType, bool contiguous);
+    
+    /**
+     * Get the type of the elements.
+     * 
+     * @return The element type.
+     */
+    const Type& getElementType() const;
+    
+    /**
+     * Checks whether the elements are stored in a single block of memory,
+     * which can be retrieved with getData().
+     * 
+     * @return True if the sequence is contiguous.
+     */
+    bool isContiguous() const;
+    
+    /**
+     * Get the number of elements.
+     * 
+     * @param sequence The sequence.
+     * @return The number of elements.
+     */
+    virtual std::size_t getSize(const Variant& sequence) const = 0;
+    
+    /**
+     * Get an element, throws SequenceIndexException if the index is out of
+     * range.
+     * 
+     * @param sequence The sequence.
+     * @param index The index of the element.
+     * @return A reference Variant to the element, const if the sequence is.
+     */
+    virtual Variant at(const Variant& sequence, std::size_t index) const = 0;
+    
+    /**
+     * Reserve memory for a number of elements.
+     * 
+     * @param sequence The non const sequence.
+     * @param size The number of elements.
+     */
+    virtual void reserve(const Variant& sequence, std::size_t size) const = 0;
+    
+    /**
+     * Append a copy of an element.
+     * 
+     * @param sequence The non const sequence.
+     * @param element The element, of the sequence element type.
+     */
+    virtual void pushBack(const Variant& sequence,
+                          const Variant& element) const = 0;
+    
+    /**
+     * Append a default constructed element.
+     * 
+     * @param sequence The non const sequence.
+     * @return A reference Variant to the new element.
+     */
+    virtual Variant emplaceBack(const Variant& sequence) const = 0;
+    
+    /**
+     * Remove all the elements.
+     * 
+     * @param sequence The non const sequence.
+     */
+    virtual void clear(const Variant& sequence) const = 0;
+    
+    /**
+     * Get the address of the first element of a contiguous sequence. The
+     * memory must not be written if the sequence is const.
+     * 
+     * @param sequence The sequence.
+     * @return The address of the elements, or NULL if the sequence is empty
+     *         or not contiguous.
+     */
+    virtual void* getData(const Variant& sequence) const = 0;
+    
+    virtual ~Sequence();
+    
+private:
+    const Type* elementType_;
+    bool contiguous_;
+};
+
+
+} // namespace xm
+
+#endif	/* XM_SEQUENCE_HPP */
@@ -0,0 +1,115 @@
+/******************************************************************************      
+ *      Extended Mirror: SequenceImpl.hpp                                     *
+ ******************************************************************************
+ *      Copyright (c) 2012-2015, Manuele Finocchiaro                          *
+ *      All rights reserved.                                                  *
+ ******************************************************************************
+ * Redistribution and use in source and binary forms, with or without         *
+ * modification, are permitted provided that the following conditions         *
+ * are met:                                                                   *
+ *                                                                            *
+ *    1. Redistributions of source code must retain the above copyright       *
+ *       notice, this list of conditions and the following disclaimer.        *
+ *                                                                            *
+ *    2. Redistributions in binary form must reproduce the above copyright    *
+ *       notice, this list of conditions and the following disclaimer in      *
+ *       the documentation and/or other materials provided with the           *
+ *       distribution.                                                        *
+ *                                                                            *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"* 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE  *
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE *
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE  *
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR        *
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF       *
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS   *
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN    *
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)    *
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF     *
+ * THE POSSIBILITY OF SUCH DAMAGE.                                            *
+ *****************************************************************************/
+
+
+#ifndef XM_SEQUENCEIMPL_HPP
+#define	XM_SEQUENCEIMPL_HPP
+
+#include <XM/Exceptions/SequenceIndexException.hpp>
+
+namespace xm {
+
+
+template<class C>
+class SequenceImpl : public Sequence
+{
+public:
+    typedef typename C::value_type ElementT;
+    
+    SequenceImpl()
+        : Sequence(registerType<ElementT>(), IsContiguous<C>::value) {}
+    
+    std::size_t getSize(const Variant& sequence) const
+    {
+        return get(sequence).size();
+    }
+    
+    Variant at(const Variant& sequence, std::size_t index) const
+    {
+        const C& container = get(sequence);
+        if (index >= container.size())
+            throw SequenceIndexException(index, container.size());
+        
+        ElementT& element = const_cast<ElementT&>(container[index]);
+        if (sequence.isConst())
+            return Variant(element, Variant::Reference | Variant::Const);
+        return Variant(element, Variant::Reference);
+    }
+    
+    void reserve(const Variant& sequence, std::size_t size) const
+    {
+        getNonConst(sequence).reserve(size);
+    }
+    
+    void pushBack(const Variant& sequence, const Variant& element) const
+    {
+        getNonConst(sequence).push_back(
+                const_cast<Variant&>(element).as<const ElementT>());
+    }
+    
+    Variant emplaceBack(const Variant& sequence) const
+    {
+        C& container = getNonConst(sequence);
+        container.push_back(ElementT());
+        return Variant(container.back(), Variant::Reference);
+    }
+    
+    void clear(const Variant& sequence) const
+    {
+        getNonConst(sequence).clear();
+    }
+    
+    void* getData(const Variant& sequence) const
+    {
+        if (!IsContiguous<C>::value)
+            return NULL;
+        const C& container = get(sequence);
+        if (container.empty())
+            return NULL;
+        return const_cast<ElementT*>(&container[0]);
+    }
+    
+private:
+    static const C& get(const Variant& sequence)
+    {
+        return const_cast<Variant&>(sequence).as<const C>();
+    }
+    
+    static C& getNonConst(const Variant& sequence)
+    {
+        return const_cast<Variant&>(sequence).as<C>();
+    }
+};
+
+
+} // namespace xm
+
+#endif	/* XM_SEQUENCEIMPL_HPP */
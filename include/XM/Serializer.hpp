@@ -0,0 +1,196 @@
+/******************************************************************************      
+ *      Extended Mirror: Serializer.hpp                                       *
+ ******************************************************************************
+ *      Copyright (c) 2012-2015, Manuele Finocchiaro                          *
+ *      All rights reserved.                                                  *
+ ******************************************************************************
+ * Redistribution and use in source and binary forms, with or without         *
+ * modification, are permitted provided that the following conditions         *
+ * are met:                                                                   *
+ *                                                                            *
+ *    1. Redistributions of source code must retain the above copyright       *
+ *       notice, this list of conditions and the following disclaimer.        *
+ *                                                                            *
+ *    2. Redistributions in binary form must reproduce the above copyright    *
+ *       notice, this list of conditions and the following disclaimer in      *
+ *       the documentation and/or other materials provided with the           *
+ *       distribution.                                                        *
+ *                                                                            *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"* 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE  *
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE *
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE  *
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR        *
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF       *
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS   *
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN    *
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)    *
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF     *
+ * THE POSSIBILITY OF SUCH DAMAGE.                                            *
+ *****************************************************************************/
+
+
+#ifndef XM_SERIALIZER_HPP
+#define	XM_SERIALIZER_HPP
+
+namespace xm {
+
+
+/**
+ * A sink of bytes the serializer writes into.
+ */
+class OutStream
+{
+public:
+    /**
+     * Write the given bytes.
+     * 
+     * @param data The bytes to write.
+     * @param size The number of bytes.
+     */
+    virtual void write(const void* data, std::size_t size) = 0;
+    
+    virtual ~OutStream();
+};
+
+
+/**
+ * A source of bytes the deserializer reads from.
+ */
+class InStream
+{
+public:
+    /**
+     * Read the given number of bytes.
+     * 
+     * @param data Where to store the bytes read.
+     * @param size The number of bytes.
+     */
+    virtual void read(void* data, std::size_t size) = 0;
+    
+    /**
+     * Get the number of bytes left to read, which bounds the memory
+     * reserved for the element counts read from the stream. Streams that
+     * don't know it return the maximum size.
+     * 
+     * @return The number of bytes left.
+     */
+    virtual std::size_t getRemaining() const;
+    
+    virtual ~InStream();
+};
+
+
+/**
+ * An OutStream writing into a caller supplied buffer.
+ * A SerializationException is thrown if the buffer is exhausted.
+ */
+class BufferOutStream : public OutStream
+{
+public:
+    /**
+     * Constructor.
+     * 
+     * @param buffer The buffer to write into.
+     * @param capacity The buffer size.
+     */
+    BufferOutStream(void* buffer, std::size_t capacity);
+    
+    void write(const void* data, std::size_t size);
+    
+    /**
+     * Get the number of bytes written so far.
+     * 
+     * @return The number of bytes written.
+     */
+    std::size_t getSize() const;
+    
+private:
+    char* buffer_;
+    std::size_t capacity_;
+    std::size_t size_;
+};
+
+
+/**
+ * An InStream reading from a caller supplied buffer.
+ * A SerializationException is thrown if the buffer is exhausted.
+ */
+class BufferInStream : public InStream
+{
+public:
+    /**
+     * Constructor.
+     * 
+     * @param buffer The buffer to read from.
+     * @param size The buffer size.
+     */
+    BufferInStream(const void* buffer, std::size_t size);
+    
+    void read(void* data, std::size_t size);
+    
+    std::size_t getRemaining() const;
+    
+    /**
+     * Get the number of bytes read so far.
+     * 
+     * @return The number of bytes read.
+     */
+    std::size_t getPosition() const;
+    
+private:
+    const char* buffer_;
+    std::size_t size_;
+    std::size_t position_;
+};
+
+
+/**
+ * Write the data of a class instance in a compact binary format.
+ * 
+ * The properties are written following the class layout, preceded by the
+ * class schema fingerprint. Primitives are written in their native
+ * representation, runs of adjacent primitive fields with a single write,
+ * nested classes recursively and arrays as a length prefixed sequence of
+ * elements. Pointers are not serialized.
+ * 
+ * @param object A variant holding the instance.
+ * @param out The stream to write into.
+ */
+void serialize(const Variant& object, OutStream& out);
+
+
+/**
+ * Read the data of a class instance written by serialize().
+ * Properties that cannot be set are read and discarded.
+ * A SerializationException is thrown if the data was written with a
+ * different class schema.
+ * 
+ * @param object A reference variant to the instance to read into.
+ * @param in The stream to read from.
+ */
+void deserialize(const Variant& object, InStream& in);
+
+
+/**
+ * Write a value of any type in the format used by serialize(), with no
+ * fingerprint.
+ * 
+ * @param value A variant holding the value.
+ * @param out The stream to write into.
+ */
+void serializeValue(const Variant& value, OutStream& out);
+
+
+/**
+ * Read a value written by serializeValue().
+ * 
+ * @param value A reference variant to the value to read into.
+ * @param in The stream to read from.
+ */
+void deserializeValue(const Variant& value, InStream& in);
+
+
+} // namespace xm
+
+#endif	/* XM_SERIALIZER_HPP */
@@ -55,6 +55,18 @@ const Class& registerClass()
 }
 
 
+/**
+ * Register the types queued by XM_REGISTER_TYPE, see Register::initialize().
+ * 
+ * @param threads The number of threads, 0 to use one per hardware thread.
+ */
+inline
+void initialize(unsigned threads = 0)
+{
+    Register::getSingleton().initialize(threads);
+}
+
+
 inline
 Namespace& defineNamespace(const std::string& path)
 {
@@ -0,0 +1,152 @@
+/******************************************************************************      
+ *      Extended Mirror: Sort.hpp                                             *
+ ******************************************************************************
+ *      Copyright (c) 2012-2015, Manuele Finocchiaro                          *
+ *      All rights reserved.                                                  *
+ ******************************************************************************
+ * Redistribution and use in source and binary forms, with or without         *
+ * modification, are permitted provided that the following conditions         *
+ * are met:                                                                   *
+ *                                                                            *
+ *    1. Redistributions of source code must retain the above copyright       *
+ *       notice, this list of conditions and the following disclaimer.        *
+ *                                                                            *
+ *    2. Redistributions in binary form must reproduce the above copyright    *
+ *       notice, this list of conditions and the following disclaimer in      *
+ *       the documentation and/or other materials provided with the           *
+ *       distribution.                                                        *
+ *                                                                            *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"* 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE  *
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE *
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE  *
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR        *
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF       *
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS   *
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN    *
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)    *
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF     *
+ * THE POSSIBILITY OF SUCH DAMAGE.                                            *
+ *****************************************************************************/
+
+
+#ifndef XM_SORT_HPP
+#define	XM_SORT_HPP
+
+namespace xm {
+
+
+/**
+ * The order of a sort key.
+ */
+enum SortOrder
+{
+    Ascending,
+    Descending
+};
+
+
+/**
+ * A property to sort by, with its order.
+ */
+struct SortKey
+{
+    SortKey(const std::string& property, SortOrder order = Ascending)
+        : property(property), order(order)
+    {
+    }
+    
+    /** The property name. */
+    std::string property;
+    
+    /** The sort order. */
+    SortOrder order;
+};
+
+
+/**
+ * Convert a primitive value into an unsigned integer with the same ordering,
+ * the conversion applied by sortIndexes() to the key values.
+ * 
+ * @param value The address of the value.
+ * @param type The primitive type of the value.
+ * @return The key of the value.
+ */
+std::uint64_t getSortKey(const void* value, const PrimitiveType& type);
+
+
+/**
+ * Compute the permutation that sorts an array of instances of a class by the
+ * given keys, the first being the most significant one.
+ * 
+ * Each key property is resolved once and its values are extracted into a
+ * Column. The values are converted into unsigned integers with the same
+ * ordering, according to the kind of the primitive type, and the indexes are
+ * sorted with a stable least significant digit radix sort, one byte at a
+ * time, skipping the bytes that are equal for all the values. Arrays sort
+ * lexicographically. Keys must be of plain data type.
+ * 
+ * @param clazz The class of the instances.
+ * @param objects Pointer to the first instance of the array.
+ * @param count The number of instances.
+ * @param keys The sort keys.
+ * @param indexes Filled with the indexes of the instances in sorted order.
+ */
+void sortIndexes(const Class& clazz,
+                 const void* objects,
+                 std::size_t count,
+                 const std::vector<SortKey>& keys,
+                 std::vector<std::size_t>& indexes);
+
+
+/**
+ * Sort an array of instances of a reflected class by the given keys.
+ * The sort is stable. The instances are moved once, after the permutation
+ * has been computed with sortIndexes().
+ * 
+ * @param objects Pointer to the first instance of the array.
+ * @param count The number of instances.
+ * @param keys The sort keys.
+ */
+template<class T>
+void sortBy(T* objects, std::size_t count, const std::vector<SortKey>& keys)
+{
+    std::vector<std::size_t> indexes;
+    sortIndexes(getClass<T>(), objects, count, keys, indexes);
+    
+    std::vector<T> sorted;
+    sorted.reserve(count);
+    for (std::size_t i = 0; i < count; i++)
+        sorted.push_back(std::move(objects[indexes[i]]));
+    for (std::size_t i = 0; i < count; i++)
+        objects[i] = std::move(sorted[i]);
+}
+
+
+template<class T>
+void sortBy(std::vector<T>& objects, const std::vector<SortKey>& keys)
+{
+    if (!objects.empty())
+        sortBy(&objects[0], objects.size(), keys);
+}
+
+
+/**
+ * Sort a vector of instances of a reflected class by a property.
+ * 
+ * @param objects The instances.
+ * @param property The property name.
+ * @param order The sort order.
+ */
+template<class T>
+void sortBy(std::vector<T>& objects,
+            const std::string& property,
+            SortOrder order = Ascending)
+{
+    sortBy(objects, std::vector<SortKey>(1, SortKey(property, order)));
+}
+
+
+} // namespace xm
+
+#endif	/* XM_SORT_HPP */
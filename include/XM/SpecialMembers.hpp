@@ -49,6 +49,10 @@ class CopyConstructor : public Member
 public:
     CopyConstructor(const Class& owner = getClass<void>());
     virtual void copy(Variant& copy, const Variant& orig) const;
+    
+    // Assign a copy of orig to the already constructed copy; a class without
+    // a copy assignment operator needs a non-throwing move constructor.
+    virtual void assign(Variant& copy, const Variant& orig) const;
 };
 
 
@@ -70,12 +74,23 @@ public:
     const Class& getDstClass() const;
     CastDirection getCastDirection() const;
 
+    /**
+     * Get the constant offset to add to the address of an instance of the
+     * owner class to get the address of its destination class subobject.
+     * The offset is known only for upcasts to non virtual bases, otherwise
+     * -1 is returned.
+     *
+     * @return The offset of the destination class subobject.
+     */
+    std::ptrdiff_t getOffset() const;
+
     virtual
     Variant cast(const Variant& var) const;
 
 protected:
     const Class* dstClass_;
     CastDirection castDir_;
+    std::ptrdiff_t offset_;
         
     friend bool operator<(const RefCaster&, const RefCaster&);
 };
@@ -16,6 +16,50 @@ public:
 };
 
 
+/**
+ * Assigns an object through its copy assignment operator or, if it has none,
+ * by copy constructing a temporary and moving it into the destroyed
+ * destination. The move must not throw, as the destination could be neither
+ * restored nor left destroyed: without a non-throwing move constructor a
+ * NonCopyableException is thrown and the destination is left untouched.
+ */
+template<class C, bool = std::is_copy_assignable<C>::value,
+         bool = std::is_nothrow_move_constructible<C>::value>
+struct CopyAssign
+{
+    void operator()(C& copy, const C& orig, const Class& owner)
+    {
+        (void)(owner);
+        copy = orig;
+    }
+};
+
+
+template<class C>
+struct CopyAssign<C, false, true>
+{
+    void operator()(C& copy, const C& orig, const Class& owner)
+    {
+        (void)(owner);
+        C temp(orig);
+        copy.~C();
+        new (&copy) C(std::move(temp));
+    }
+};
+
+
+template<class C>
+struct CopyAssign<C, false, false>
+{
+    void operator()(C& copy, const C& orig, const Class& owner)
+    {
+        (void)(copy);
+        (void)(orig);
+        throw NonCopyableException(owner);
+    }
+};
+
+
 template<class C>
 class CopyConstructorImpl : public CopyConstructor
 {
@@ -24,7 +68,12 @@ public:
     void copy(Variant& copy, const Variant& orig) const
     {
         Variant& nc_orig = const_cast<Variant&>(orig);
-        new (&copy.as<C>()) C(nc_orig.as<C>());
+        new (&copy.as<C>()) C(nc_orig.as<const C>());
+    }
+    void assign(Variant& copy, const Variant& orig) const
+    {
+        Variant& nc_orig = const_cast<Variant&>(orig);
+        CopyAssign<C>()(copy.as<C>(), nc_orig.as<const C>(), getOwner());
     }
 };
 
@@ -41,6 +90,34 @@ public:
 };
 
 
+/**
+ * Computes the constant offset of the D subobject within an S object, or -1
+ * if the offset is not constant (i.e. D is a virtual base of S).
+ */
+template<typename S, typename D, bool = IsStaticCastable<S, D>::value>
+struct StaticCastOffset
+{
+    std::ptrdiff_t operator()()
+    {
+        return -1;
+    }
+};
+
+
+template<typename S, typename D>
+struct StaticCastOffset<S, D, true>
+{
+    std::ptrdiff_t operator()()
+    {
+        // a null pointer would be converted to a null pointer, so a fake
+        // non null address is used, it is never dereferenced
+        S* src = reinterpret_cast<S*>(0x1000);
+        return reinterpret_cast<char*>(static_cast<D*>(src))
+                - reinterpret_cast<char*>(src);
+    }
+};
+
+
 template<typename S, typename D>
 class RefCasterImpl : public RefCaster
 {
@@ -49,12 +126,22 @@ public:
         : Item("", getClass<S>()),
           RefCaster(getClass<D>(), getClass<S>())
     {
+        if (castDir_ == UpCast)
+            offset_ = StaticCastOffset<S, D>()();
     }
 
     Variant cast(const Variant& var) const
     {
         Variant& nc_var = const_cast<Variant&>(var);
-        D* casted = dynamic_cast<D*>(&nc_var.as<S>());
+        S& src = nc_var.as<S>();
+        
+        // upcasts to non virtual bases just add the constant offset
+        if (offset_ >= 0)
+            return Variant(*reinterpret_cast<D*>(
+                    reinterpret_cast<char*>(&src) + offset_),
+                    Variant::Reference);
+        
+        D* casted = dynamic_cast<D*>(&src);
         if (casted)
             return Variant(*casted, Variant::Reference);
         else
@@ -82,7 +82,12 @@ public:
         /**
          *  A template instance.
          */
-        CompoundClass = 24
+        CompoundClass = 24,
+        
+        /**
+         * A std::string.
+         */
+        String = 32
     };
     
     /**
@@ -34,6 +34,7 @@
 #define	XM_TYPETRAITS_HPP
 
 #include <sstream>
+#include <type_traits>
 
 namespace xm{
 
@@ -99,6 +100,76 @@ struct IsNonConstReference<const T&> : public FalseType {};
 template<typename T>
 struct IsNonConstReference<T&> : public TrueType {};
 
+/**
+ * The value member is true if T is a class with virtual functions, whose
+ * dynamic type can be retrieved with typeid.
+ */
+template<class T>
+struct IsPolymorphic
+{
+    static const bool value = std::is_polymorphic<T>::value;
+};
+
+/**
+ * The value member is true if a pointer to S can be converted to a pointer to
+ * D and back through a static_cast, that is if S and D are related by a non
+ * virtual, accessible inheritance.
+ */
+template<class S, class D>
+struct IsStaticCastable
+{
+private:
+    typedef char Yes;
+    typedef long No;
+
+    template<class S2, class D2>
+    static Yes test(decltype(static_cast<D2*>((S2*)0))*,
+                    decltype(static_cast<S2*>((D2*)0))*);
+
+    template<class S2, class D2>
+    static No test(...);
+
+public:
+    static const bool value = sizeof(test<S, D>(0, 0)) == sizeof(Yes);
+};
+
+/**
+ * The value member is true if the elements of the container C are stored in
+ * a single contiguous block of memory.
+ */
+template<class C>
+struct IsContiguous : public FalseType {};
+
+
+template<typename T, typename Allocator>
+struct IsContiguous<std::vector<T, Allocator> > : public TrueType {};
+
+
+template<typename Allocator>
+struct IsContiguous<std::vector<bool, Allocator> > : public FalseType {};
+
+
+template<typename CharT, typename Traits, typename Allocator>
+struct IsContiguous<std::basic_string<CharT, Traits, Allocator> >
+        : public TrueType {};
+
+/**
+ * The value member is true if the associative container C is a hash table.
+ */
+template<class C>
+struct IsHashed : public FalseType {};
+
+
+template<typename Key, typename T, typename Hash, typename KeyEqual,
+         typename Allocator>
+struct IsHashed<std::unordered_map<Key, T, Hash, KeyEqual, Allocator> >
+        : public TrueType {};
+
+
+template<typename Key, typename Hash, typename KeyEqual, typename Allocator>
+struct IsHashed<std::unordered_set<Key, Hash, KeyEqual, Allocator> >
+        : public TrueType {};
+
 // Type modifications
 
 template<typename T>
@@ -0,0 +1,166 @@
+/******************************************************************************      
+ *      Extended Mirror: Arena.hpp                                            *
+ ******************************************************************************
+ *      Copyright (c) 2012-2015, Manuele Finocchiaro                          *
+ *      All rights reserved.                                                  *
+ ******************************************************************************
+ * Redistribution and use in source and binary forms, with or without         *
+ * modification, are permitted provided that the following conditions         *
+ * are met:                                                                   *
+ *                                                                            *
+ *    1. Redistributions of source code must retain the above copyright       *
+ *       notice, this list of conditions and the following disclaimer.        *
+ *                                                                            *
+ *    2. Redistributions in binary form must reproduce the above copyright    *
+ *       notice, this list of conditions and the following disclaimer in      *
+ *       the documentation and/or other materials provided with the           *
+ *       distribution.                                                        *
+ *                                                                            *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"* 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE  *
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE *
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE  *
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR        *
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF       *
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS   *
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN    *
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)    *
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF     *
+ * THE POSSIBILITY OF SUCH DAMAGE.                                            *
+ *****************************************************************************/
+
+
+#ifndef XM_UTILS_ARENA_HPP
+#define XM_UTILS_ARENA_HPP
+
+#include <XM/Utils/Utils.hpp>
+
+namespace xm {
+
+/**
+ * Monotonic allocator used for the reflection metadata.
+ * 
+ * Memory is handed out by bumping a pointer inside large blocks; single
+ * allocations are never given back and the whole arena is released at once
+ * when it is destroyed.
+ */
+class Arena
+{
+public:
+    /** Size of the blocks the arena reserves from the heap. */
+    static const std::size_t BlockSize = 64 * 1024;
+    
+    Arena();
+    
+    /**
+     * Allocates a suitably aligned chunk of memory.
+     * 
+     * @param size The size of the chunk.
+     * @return The allocated memory.
+     */
+    void* allocate(std::size_t size);
+    
+    /**
+     * Checks whether a pointer has been allocated by this arena.
+     * 
+     * @param ptr The pointer to check.
+     * @return True if the pointer belongs to one of the arena blocks.
+     */
+    bool owns(const void* ptr) const;
+    
+    /**
+     * Get the number of bytes reserved from the heap by this arena.
+     * 
+     * @return The reserved size.
+     */
+    std::size_t getReservedSize() const;
+    
+    /**
+     * Get the number of bytes handed out by this arena.
+     * 
+     * @return The used size.
+     */
+    std::size_t getUsedSize() const;
+    
+    /**
+     * Get the arena holding the registration metadata. It is never
+     * destroyed, so that the register can be torn down by the process exit.
+     * 
+     * @return The metadata arena.
+     */
+    static Arena& getMetadataArena();
+    
+    /**
+     * While an instance of this class is alive, the metadata allocated by the
+     * current thread is placed in the metadata arena.
+     */
+    class Scope
+    {
+    public:
+        Scope();
+        ~Scope();
+        
+    private:
+        Scope(const Scope&);
+        Scope& operator=(const Scope&);
+    };
+    
+    /**
+     * Checks whether an arena scope is active on the current thread.
+     * 
+     * @return True if the metadata goes to the arena.
+     */
+    static bool isScopeActive();
+    
+    ~Arena();
+    
+private:
+    Arena(const Arena&);
+    Arena& operator=(const Arena&);
+    
+    struct Block
+    {
+        char* begin;
+        char* end;
+    };
+    
+    struct BlockCmp
+    {
+        bool operator()(const Block& a, const Block& b) const
+        {
+            return std::less<const char*>()(a.begin, b.begin);
+        }
+    };
+    
+    char* allocateBlock(std::size_t size);
+    
+    std::vector<Block> blocks_;
+    char* current_;
+    char* limit_;
+    std::size_t reserved_;
+    std::size_t used_;
+    mutable std::mutex mutex_;
+};
+
+
+/**
+ * Allocates memory for a metadata object. Inside an arena scope the memory
+ * comes from the metadata arena, otherwise from the heap.
+ * 
+ * @param size The size of the object.
+ * @return The allocated memory.
+ */
+void* allocateMetadata(std::size_t size);
+
+
+/**
+ * Releases memory allocated with allocateMetadata(). Memory belonging to the
+ * metadata arena is left in place until the arena goes away.
+ * 
+ * @param ptr The memory to release.
+ */
+void releaseMetadata(void* ptr);
+
+} // namespace xm
+
+#endif	/* XM_UTILS_ARENA_HPP */
@@ -56,6 +56,146 @@ struct PtrCmpByVal
 };
 
 
+/**
+ * A set stored as a sorted vector, with the subset of the std::set interface
+ * used for the metadata. Compared to std::set it takes a single allocation
+ * and one pointer per element instead of a tree node, at the cost of linear
+ * insertions, so it suits small sets built once and then only looked up.
+ * Insertions and erasures invalidate the iterators.
+ */
+template<class T, class C = std::less<T> >
+class FlatSet : private C
+{
+public:
+    typedef T key_type;
+    typedef T value_type;
+    typedef C key_compare;
+    typedef std::size_t size_type;
+    typedef typename std::vector<T>::const_iterator iterator;
+    typedef typename std::vector<T>::const_iterator const_iterator;
+    
+    iterator begin() const
+    {
+        return elements_.begin();
+    }
+    
+    iterator end() const
+    {
+        return elements_.end();
+    }
+    
+    size_type size() const
+    {
+        return elements_.size();
+    }
+    
+    bool empty() const
+    {
+        return elements_.empty();
+    }
+    
+    void clear()
+    {
+        elements_.clear();
+    }
+    
+    iterator lower_bound(const T& value) const
+    {
+        return std::lower_bound(elements_.begin(), elements_.end(), value,
+                static_cast<const C&>(*this));
+    }
+    
+    iterator find(const T& value) const
+    {
+        iterator ite = lower_bound(value);
+        if (ite != end() && !C::operator()(value, *ite))
+            return ite;
+        return end();
+    }
+    
+    size_type count(const T& value) const
+    {
+        return find(value) != end() ? 1 : 0;
+    }
+    
+    std::pair<iterator, bool> insert(const T& value)
+    {
+        iterator ite = lower_bound(value);
+        if (ite != end() && !C::operator()(value, *ite))
+            return std::make_pair(ite, false);
+        return std::make_pair(elements_.insert(ite, value), true);
+    }
+    
+    /**
+     * Insert a range of elements with a single merge. Of the equivalent
+     * elements the one already in the set, or else the first in the range,
+     * is kept.
+     */
+    template<class I>
+    void insert(I first, I last)
+    {
+        const C& cmp = static_cast<const C&>(*this);
+        std::size_t size = elements_.size();
+        elements_.insert(elements_.end(), first, last);
+        std::stable_sort(elements_.begin() + size, elements_.end(), cmp);
+        std::inplace_merge(elements_.begin(), elements_.begin() + size,
+                           elements_.end(), cmp);
+        elements_.erase(std::unique(elements_.begin(), elements_.end(),
+                                    Equivalent(cmp)),
+                        elements_.end());
+    }
+    
+    iterator erase(iterator position)
+    {
+        return elements_.erase(position);
+    }
+    
+    size_type erase(const T& value)
+    {
+        iterator ite = find(value);
+        if (ite == end())
+            return 0;
+        elements_.erase(ite);
+        return 1;
+    }
+    
+    /**
+     * Get the number of bytes allocated for the elements.
+     * 
+     * @return The number of bytes.
+     */
+    size_type getMemorySize() const
+    {
+        return elements_.capacity() * sizeof(T);
+    }
+    
+    /**
+     * Release the memory reserved for elements not yet inserted.
+     */
+    void shrink()
+    {
+        elements_.shrink_to_fit();
+    }
+    
+private:
+
+    // Tells whether two elements are equivalent through the comparer.
+    struct Equivalent
+    {
+        Equivalent(const C& cmp) : cmp(cmp) {}
+
+        bool operator()(const T& value1, const T& value2) const
+        {
+            return !cmp(value1, value2) && !cmp(value2, value1);
+        }
+
+        const C& cmp;
+    };
+
+    std::vector<T> elements_;
+};
+
+
 namespace ptrSet {
 
     
@@ -99,10 +239,48 @@ void deleteAll(std::set<T*, C>& set)
     while(ite != set.end())
     {
         T* element = *ite;
-        set.erase(ite);
+        set.erase(ite++);
         delete element;
+    }
+}
+
+
+template<class T, class C, typename K>
+T* findByKey(const FlatSet<T*, C>& set, const K& key)
+{
+    typename ThrowawayKeyClass<T>::Type keyObj(key);
+    typename FlatSet<T*, C>::const_iterator ite;
+    ite = set.find(&keyObj);
+    if (ite == set.end())
+        return NULL;
+    return *ite;
+}
+
+
+template<class T, class C, typename K>
+T* removeByKey(FlatSet<T*, C>& set, const K& key)
+{
+    typename ThrowawayKeyClass<T>::Type keyObj(key);
+    typename FlatSet<T*, C>::iterator ite;
+    ite = set.find(&keyObj);
+    if (ite == set.end())
+        return NULL;
+    T* value = *ite;
+    set.erase(ite);
+    return value;
+}
+
+
+template<class T, class C>
+void deleteAll(FlatSet<T*, C>& set)
+{
+    typename FlatSet<T*, C>::iterator ite = set.begin();
+    while(ite != set.end())
+    {
+        delete *ite;
         ite ++;
     }
+    set.clear();
 }
 
 
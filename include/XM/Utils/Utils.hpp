@@ -33,6 +33,9 @@
 #ifndef XM_UTILS_UTILS_HPP
 #define XM_UTILS_UTILS_HPP
 
+#include<algorithm>
+#include<functional>
+#include<mutex>
 #include<iostream>
 #include<string>
 #include<sstream>
@@ -44,6 +47,7 @@
 #include <XM/Utils/Debug.hpp>
 #include <XM/Utils/Containers.hpp>
 #include <XM/Utils/Names.hpp>
+#include <XM/Utils/Arena.hpp>
 
 #endif	/* XM_UTILS_UTILS_HPP */
 
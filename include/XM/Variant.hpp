@@ -62,7 +62,13 @@ public:
         Const = 2,
         
         // Variant get copied by ref.
-        CopyByRef = 8
+        CopyByRef = 8,
+        
+        // A reference variant takes the most derived class of the data.
+        Dynamic = 16,
+        
+        // The variant shares the ownership of the referenced data.
+        Shared = 32
     };
     
     /**
@@ -92,6 +98,53 @@ public:
     template<typename T>
     Variant(T& data, char flags);
     
+    /**
+     * Construct a string variant taking the content of the given string.
+     * 
+     * @param str The string to move.
+     */
+    Variant(std::string&& str);
+    
+    /**
+     * Construct a string variant from a string literal. The variant holds a
+     * std::string, not a pointer to the characters.
+     * 
+     * @param str The string literal.
+     */
+    template<std::size_t size>
+    Variant(const char (&str)[size]);
+    
+    /**
+     * Construct a variant sharing the ownership of the pointed object. The
+     * variant references the object, copies of the variant share the
+     * ownership instead of copying the object. A null pointer gives a void
+     * variant.
+     * 
+     * @param ptr The shared pointer.
+     */
+    template<typename T>
+    Variant(const std::shared_ptr<T>& ptr);
+    
+    /**
+     * Construct a variant taking the ownership of the pointed object, which
+     * is then shared as for shared pointers.
+     * 
+     * @param ptr The unique pointer.
+     */
+    template<typename T, typename D>
+    Variant(std::unique_ptr<T, D>&& ptr);
+    
+    /**
+     * Construct a reference variant to the data of the given Type stored at
+     * the given address.
+     * The data is never copied, the Reference flag is always set.
+     * 
+     * @param data The address of the data.
+     * @param type The Type of the data.
+     * @param flags The variant flags.
+     */
+    Variant(void* data, const Type& type, char flags);
+    
     /**
      * Get the Type for the data.
      * 
@@ -106,6 +159,23 @@ public:
      */
     Variant getRefVariant() const;
     
+    /**
+     * Create a reference variant to the most derived object of the content,
+     * with the most derived registered class as type, see
+     * Class::getDynamicClass(). Constness is preserved.
+     * 
+     * @return The reference variant.
+     */
+    Variant toDynamic() const;
+    
+    /**
+     * Get the address of the variant data, no type or constness check is
+     * performed.
+     * 
+     * @return The address of the data.
+     */
+    void* getAddress() const;
+    
     /**
      * Ask if this variant data is a reference to an external data.
      * 
@@ -113,6 +183,23 @@ public:
      */
     bool isReference() const;
     
+    /**
+     * Ask if this variant shares the ownership of its data.
+     * 
+     * @return true if the variant shares the ownership, false otherwise.
+     */
+    bool isShared() const;
+    
+    /**
+     * Get a shared pointer to the data, sharing the ownership with the
+     * variant. Type and constness are checked as by as().
+     * 
+     * @return The shared pointer, empty if the variant does not share the
+     *         ownership of its data.
+     */
+    template<typename T>
+    std::shared_ptr<T> asShared();
+    
     /**
      * Ask if this variant holds constant data.
      * 
@@ -150,7 +237,8 @@ public:
     Variant(const Variant& orig);
     
     /**
-     * Move constructor. The data of the variants is swapped.
+     * Move constructor. The data of the variants is swapped, strings held
+     * inline are moved.
      * 
      * @param orig The variant to move.
      */
@@ -171,12 +259,10 @@ public:
     
     /**
      * Operator for assignment.
-     * The data of the rvalue is stored into the variant after it has been
-     * copied through the assignment operator of the specified type.
-     * If current type of the variant is different form that of the rvalue then
-     * the previous data is deallocated with the destructor and a new object of
-     * the new type is allocated with its default constructor.
-     * The assignment is then performed.
+     * If the variant holds data of the same type of the rvalue, the rvalue is
+     * assigned to it through the assignment operator of the type, otherwise
+     * the previous data is released and the variant takes a copy of the
+     * rvalue.
      * 
      * @param rvalue The rvalue object
      * @return A reference to the rvalue
@@ -225,6 +311,42 @@ private:
     // Some flags
     char flags_;
     
+    // Inline storage of the strings held by value, data_ then points to it,
+    // or of the owner of the shared data.
+    std::aligned_storage<sizeof(std::string),
+                         alignof(std::string)>::type storage_;
+    
+    /**
+     * Checks whether the variant holds a string in its inline storage.
+     */
+    bool holdsString() const;
+    
+    /**
+     * Store a copy of a string in the inline storage.
+     */
+    void initString(const std::string& str);
+    
+    /**
+     * Get the owner of the shared data, in the inline storage.
+     */
+    std::shared_ptr<const void>& getOwner() const;
+    
+    /**
+     * Reference the data of a shared pointer, sharing its ownership.
+     */
+    template<typename T>
+    void initShared(const std::shared_ptr<T>& ptr);
+    
+    /**
+     * Take the data of another variant, leaving it void.
+     */
+    void moveFrom(Variant& orig);
+    
+    /**
+     * Destroy and deallocate the data held by value.
+     */
+    void release();
+    
     /**
      * Initialize a variant.
      */
@@ -53,6 +53,16 @@ const Type& Variant::getType() const
 }
     
 
+inline
+void* Variant::getAddress() const
+{
+    if ((flags_ & Reference) || (type_->getSize() > sizeof(data_)))
+        return data_;
+    else
+        return const_cast<void**>(&data_);
+}
+    
+
 inline
 bool Variant::isReference() const
 {
@@ -60,6 +70,13 @@ bool Variant::isReference() const
 }
     
 
+inline
+bool Variant::isShared() const
+{
+    return flags_ & Shared;
+}
+    
+
 inline
 bool Variant::isConst() const
 {
@@ -74,10 +91,22 @@ void Variant::setConst()
 }
     
 
+inline
+bool Variant::holdsString() const
+{
+    return data_ == static_cast<const void*>(&storage_);
+}
+
+
 template<typename T>    
 Variant::Initialize<T>::Initialize(Variant& variant) : variant_(variant){};
 
 
+// strings held by value are stored inline
+template<>
+void Variant::Initialize<std::string>::operator()(std::string& data);
+
+
 template<typename T>
 void Variant::Initialize<T>::operator()(T& data)
 {
@@ -88,6 +117,11 @@ void Variant::Initialize<T>::operator()(T& data)
     {
         // store pointer to data
         variant_.data_ = &data;
+        
+        // resolve the dynamic type if requested
+        const Class* clazz = dynamic_cast<const Class*>(variant_.type_);
+        if (clazz && (variant_.flags_ & Dynamic))
+            variant_.type_ = &clazz->getDynamicClass(variant_.data_);
     }
     else
     {
@@ -167,6 +201,69 @@ Variant::Variant(const T& data)
 }
 
 
+template<std::size_t size>
+Variant::Variant(const char (&str)[size])
+: flags_(0)
+{
+    type_ = &registerType<std::string>();
+    initString(std::string(str));
+}
+
+
+template<typename T>
+Variant::Variant(const std::shared_ptr<T>& ptr)
+: data_(NULL), type_(&xm::getType<void>()), flags_(0)
+{
+    if (ptr)
+        initShared(ptr);
+}
+
+
+template<typename T, typename D>
+Variant::Variant(std::unique_ptr<T, D>&& ptr)
+: data_(NULL), type_(&xm::getType<void>()), flags_(0)
+{
+    if (ptr)
+        initShared(std::shared_ptr<T>(std::move(ptr)));
+}
+
+
+inline
+std::shared_ptr<const void>& Variant::getOwner() const
+{
+    void* storage = const_cast<void*>(static_cast<const void*>(&storage_));
+    return *static_cast<std::shared_ptr<const void>*>(storage);
+}
+
+
+template<typename T>
+void Variant::initShared(const std::shared_ptr<T>& ptr)
+{
+    static_assert(sizeof(std::shared_ptr<const void>) <= sizeof(storage_),
+                  "The owner does not fit the inline storage");
+    
+    typedef typename RemoveConst<T>::Type NonConstT;
+    type_ = &registerType<NonConstT>();
+    data_ = const_cast<NonConstT*>(ptr.get());
+    flags_ = Reference | Shared;
+    if (IsConst<T>::value)
+        flags_ |= Const;
+    new (&storage_) std::shared_ptr<const void>(ptr);
+}
+
+
+template<typename T>
+std::shared_ptr<T> Variant::asShared()
+{
+    T& data = as<T>();
+    if (!(flags_ & Shared))
+        return std::shared_ptr<T>();
+    
+    // alias the owner, the data may be a base subobject of it
+    return std::shared_ptr<T>(getOwner(), &data);
+}
+
+
 template<typename T>
 Variant::Variant(T& data, char flags)
 : flags_(flags)
@@ -226,6 +323,13 @@ inline T& Variant::as()
         
         // cast type objects to class objects
         const Class& targetClass = dynamic_cast<const Class&>(targetType);
+        
+        // upcasts through non virtual bases are a constant offset
+        const Class& srcClass = dynamic_cast<const Class&>(*type_);
+        std::ptrdiff_t offset = srcClass.getBaseOffset(targetClass);
+        if (offset >= 0)
+            return *reinterpret_cast<T*>(
+                    static_cast<char*>(getAddress()) + offset);
 
         Variant result;
         if (recursiveCast(*this, result, targetClass))
@@ -244,51 +348,18 @@ Empty& Variant::as<Empty>();
 
 template<typename T>
 const T& Variant::operator=(const T& rvalue)
-{       
-    // get the Type
-    const Type& rtype = xm::getType<T>();
-    const Class* clazz = dynamic_cast<const Class*>(type_);
-    
-    // check if types are the same
-    if (!type_ || rtype != *type_)
+{
+    if (*type_ == xm::getType<T>())
     {
-        // call destructor if class
-        if (clazz)
-        {
-            const Destructor& destructor = clazz->getDestructor();
-            destructor.destroy(*this);
-        }
-        
-        // free memory
-        ::operator delete(data_); // TODO: allow custom deallocator
-        
-        // set the new Type
-        type_ = &rtype;
-        
-        // allocate new memory
-        ::operator new(sizeof(T)); // TODO: allow custom allocator
-        
-        // call copy constructor if any
-        clazz = dynamic_cast<const Class*>(type_);
-        if (clazz)
-        {
-            const CopyConstructor& cpyC = clazz->getCopyConstructor();
-            cpyC.copy(*this, RefVariant(rvalue));
-        }
+        // assign in place through the assignment operator of the type
+        if (flags_ & Const)
+            throw VariantCostnessException(*type_);
+        *static_cast<T*>(getAddress()) = rvalue;
     }
     else
     {
-        // call copy constructor if class
-        if (clazz)
-        {
-            const CopyConstructor& cpyC = clazz->getCopyConstructor();
-            cpyC.copy(*this, RefVariant(rvalue));
-        }
-        else
-        {
-            // raw copy memory
-            std::memcpy(data_, &rvalue, sizeof(T));
-        }
+        // take a copy of the rvalue, releasing the previous data
+        *this = Variant(rvalue);
     }
     
     // return the rvalue
@@ -34,11 +34,19 @@
 #define	EXTENDEDMIRROR_HPP
 
 #include <typeinfo>
+#include <typeindex>
 #include <limits>
+#include <cstdint>
 #include <set>
 #include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <memory>
 #include <vector>
 #include <utility>
+#include <initializer_list>
+#include <atomic>
+#include <thread>
 
 #include <XM/Typedefs.hpp>
 #include <XM/Utils/Utils.hpp>
@@ -59,6 +67,7 @@ _XM_DEFINE_POINTER_COMPARER_BY_METHOD(getId, PtrCmpById)
 #include <XM/Type.hpp>
 #include <XM/PrimitiveType.hpp>
 #include <XM/PointerType.hpp>
+#include <XM/StringType.hpp>
 #include <XM/ArrayType.hpp>
 #include <XM/Member.hpp>
 #include <XM/Property.hpp>
@@ -70,13 +79,18 @@ _XM_DEFINE_POINTER_COMPARER_BY_METHOD(getId, PtrCmpById)
 #include <XM/SpecialMembers.hpp>
 #include <XM/Template.hpp>
 #include <XM/Class.hpp>
+#include <XM/Sequence.hpp>
+#include <XM/Associative.hpp>
 #include <XM/TemplArg.hpp>
 #include <XM/CompoundClass.hpp>
+#include <XM/ClassLayout.hpp>
 #include <XM/PropertyField.hpp>
 #include <XM/PropertyArrayField.hpp>
 #include <XM/PropertyGetterNSetter.hpp>
 #include <XM/Variant.inl>
 #include <XM/SpecialMembersImpl.hpp>
+#include <XM/SequenceImpl.hpp>
+#include <XM/AssociativeImpl.hpp>
 #include <XM/ConstantImpl.hpp>
 #include <XM/FunctionImpl.hpp>
 #include <XM/VariableImpl.hpp>
@@ -85,6 +99,18 @@ _XM_DEFINE_POINTER_COMPARER_BY_METHOD(getId, PtrCmpById)
 #include <XM/Bind.hpp>
 #include <XM/RegistrationMacros.hpp>
 #include <XM/MakeSign.hpp>
+#include <XM/Serializer.hpp>
+#include <XM/Json.hpp>
+#include <XM/Archive.hpp>
+#include <XM/Patch.hpp>
+#include <XM/ChangeTracker.hpp>
+#include <XM/Columns.hpp>
+#include <XM/Hash.hpp>
+#include <XM/Sort.hpp>
+#include <XM/Query.hpp>
+#include <XM/ArrayView.hpp>
+#include <XM/ObjectStore.hpp>
+#include <XM/MemoryStats.hpp>
 
 
 // Specialize the type recognizer for each primitive type
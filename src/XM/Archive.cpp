@@ -0,0 +1,498 @@
+/******************************************************************************      
+ *      Extended Mirror: Archive.cpp                                          *
+ ******************************************************************************
+ *      Copyright (c) 2012-2015, Manuele Finocchiaro                          *
+ *      All rights reserved.                                                  *
+ ******************************************************************************
+ * Redistribution and use in source and binary forms, with or without         *
+ * modification, are permitted provided that the following conditions         *
+ * are met:                                                                   *
+ *                                                                            *
+ *    1. Redistributions of source code must retain the above copyright       *
+ *       notice, this list of conditions and the following disclaimer.        *
+ *                                                                            *
+ *    2. Redistributions in binary form must reproduce the above copyright    *
+ *       notice, this list of conditions and the following disclaimer in      *
+ *       the documentation and/or other materials provided with the           *
+ *       distribution.                                                        *
+ *                                                                            *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"* 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE  *
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE *
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE  *
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR        *
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF       *
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS   *
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN    *
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)    *
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF     *
+ * THE POSSIBILITY OF SUCH DAMAGE.                                            *
+ *****************************************************************************/
+
+
+#include <XM/xMirror.hpp>
+#include <XM/Archive.hpp>
+#include <XM/Exceptions/SerializationException.hpp>
+#include <XM/Exceptions/VariantCostnessException.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+using namespace xm;
+
+
+namespace {
+
+const char archiveMagic[4] = {'X', 'M', 'A', 'R'};
+const uint32_t archiveVersion = 1;
+
+// magic, version, field count, record size, record count and fingerprint
+const size_t archiveHeaderSize = 4 + 4 + 4 + 4 + 8 + 8;
+
+// offset, size, path length and type name length
+const size_t archiveFieldHeaderSize = 4 + 4 + 2 + 2;
+
+// records start at a multiple of this
+const size_t archiveAlignment = 8;
+
+
+// Bounds checked reading of the archive schema.
+class SchemaReader
+{
+public:
+    SchemaReader(const char* data, size_t size)
+        : data_(data), size_(size), position_(0)
+    {
+    }
+    
+    template<typename T>
+    T read()
+    {
+        T value;
+        memcpy(&value, get(sizeof(T)), sizeof(T));
+        return value;
+    }
+    
+    string readString(size_t length)
+    {
+        return string(get(length), length);
+    }
+    
+    size_t getPosition() const
+    {
+        return position_;
+    }
+    
+private:
+    const char* get(size_t size)
+    {
+        if (size_ - position_ < size)
+            throw SerializationException("Truncated archive");
+        const char* data = data_ + position_;
+        position_ += size;
+        return data;
+    }
+    
+    const char* data_;
+    size_t size_;
+    size_t position_;
+};
+
+
+// An archived field.
+struct ArchivedField
+{
+    uint32_t offset;
+    uint32_t size;
+    string typeName;
+};
+
+
+template<class ColumnT>
+bool columnBefore(const ColumnT& c1, const ColumnT& c2)
+{
+    return c1.path < c2.path;
+}
+
+
+const Class& checkObjectClass(const Variant& object, const Class& clazz)
+{
+    if (&object.getType() != &clazz)
+        throw SerializationException("Expected an instance of class "
+                + clazz.getName() + ", got " + object.getType().getName());
+    return clazz;
+}
+
+} // namespace
+
+
+ArchiveWriter::ArchiveWriter(const Class& clazz,
+                             size_t recordCount,
+                             OutStream& out)
+    : class_(&clazz),
+      out_(&out),
+      record_(clazz.getSize()),
+      remaining_(recordCount)
+{
+    addColumns(clazz, "", 0, columns_);
+    
+    uint32_t fieldCount = columns_.size();
+    uint32_t recordSize = clazz.getSize();
+    uint64_t count = recordCount;
+    uint64_t fingerprint = clazz.getLayout().getFingerprint();
+    out.write(archiveMagic, sizeof(archiveMagic));
+    out.write(&archiveVersion, sizeof(archiveVersion));
+    out.write(&fieldCount, sizeof(fieldCount));
+    out.write(&recordSize, sizeof(recordSize));
+    out.write(&count, sizeof(count));
+    out.write(&fingerprint, sizeof(fingerprint));
+    
+    size_t size = archiveHeaderSize;
+    for (size_t i = 0; i < columns_.size(); i++)
+    {
+        const Column& column = columns_[i];
+        const string& typeName = column.type->getName();
+        uint32_t offset = column.offset;
+        uint32_t fieldSize = column.type->getSize();
+        uint16_t pathLength = column.path.size();
+        uint16_t typeNameLength = typeName.size();
+        out.write(&offset, sizeof(offset));
+        out.write(&fieldSize, sizeof(fieldSize));
+        out.write(&pathLength, sizeof(pathLength));
+        out.write(&typeNameLength, sizeof(typeNameLength));
+        out.write(column.path.data(), pathLength);
+        out.write(typeName.data(), typeNameLength);
+        size += archiveFieldHeaderSize + pathLength + typeNameLength;
+    }
+    
+    // align the records
+    const char padding[archiveAlignment] = {0};
+    out.write(padding, (archiveAlignment - size % archiveAlignment)
+            % archiveAlignment);
+}
+
+
+void ArchiveWriter::write(const Variant& object)
+{
+    checkObjectClass(object, *class_);
+    if (remaining_ == 0)
+        throw SerializationException("Too many records written to the "
+                "archive of class " + class_->getName());
+    
+    const char* obj = static_cast<const char*>(object.getAddress());
+    fill(record_.begin(), record_.end(), 0);
+    for (size_t i = 0; i < columns_.size(); i++)
+    {
+        const Column& column = columns_[i];
+        memcpy(&record_[column.offset], obj + column.offset,
+                column.type->getSize());
+    }
+    
+    out_->write(&record_[0], record_.size());
+    remaining_ --;
+}
+
+
+void ArchiveWriter::addColumns(const Class& clazz,
+                               const string& prefix,
+                               size_t offset,
+                               Column_Vector& columns)
+{
+    const ClassLayout::Field_Vector& fields = clazz.getLayout().getFields();
+    for (size_t i = 0; i < fields.size() && fields[i].offset >= 0; i++)
+    {
+        const Type& type = fields[i].property->getType();
+        string path = prefix + fields[i].property->getUnqualifiedName();
+        size_t fieldOffset = offset + fields[i].offset;
+        
+        if (ClassLayout::isPlainData(type))
+        {
+            Column column;
+            column.path = path;
+            column.type = &type;
+            column.offset = fieldOffset;
+            columns.push_back(column);
+        }
+        else if (type.getCategory() & Type::Class)
+        {
+            addColumns(dynamic_cast<const Class&>(type), path + ".",
+                    fieldOffset, columns);
+        }
+    }
+}
+
+
+RecordView::RecordView(const MappedArchive& archive, const char* record)
+    : archive_(&archive), record_(record)
+{
+}
+
+
+Variant RecordView::getData(const Property& property) const
+{
+    int index = archive_->class_->getLayout().getFieldIndex(property);
+    if (index < 0 || archive_->fieldColumns_[index] < 0)
+        return Variant::Void;
+    
+    const MappedArchive::Column& column =
+            archive_->columns_[archive_->fieldColumns_[index]];
+    if (column.archiveOffset < 0)
+        return Variant::Void;
+    
+    return Variant(const_cast<char*>(record_ + column.archiveOffset),
+            *column.type, Variant::Const);
+}
+
+
+Variant RecordView::getData(const string& path) const
+{
+    const MappedArchive::Column* column = archive_->findColumn(path);
+    if (!column || column->archiveOffset < 0)
+        return Variant::Void;
+    
+    return Variant(const_cast<char*>(record_ + column->archiveOffset),
+            *column->type, Variant::Const);
+}
+
+
+void RecordView::load(const Variant& object) const
+{
+    checkObjectClass(object, *archive_->class_);
+    if (object.isConst())
+        throw VariantCostnessException(object.getType());
+    
+    char* obj = static_cast<char*>(object.getAddress());
+    const MappedArchive::Column_Vector& columns = archive_->columns_;
+    for (size_t i = 0; i < columns.size(); i++)
+    {
+        if (columns[i].archiveOffset >= 0)
+            memcpy(obj + columns[i].offset, record_ + columns[i].archiveOffset,
+                    columns[i].type->getSize());
+    }
+}
+
+
+MappedArchive::MappedArchive(const string& path, const Class& clazz)
+    : class_(&clazz),
+      data_(NULL),
+      size_(0),
+      mapping_(NULL),
+      fileMapping_(NULL),
+      records_(NULL),
+      recordSize_(0),
+      recordCount_(0),
+      schemaCurrent_(false)
+{
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+            NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        throw SerializationException("Cannot open archive " + path);
+    
+    LARGE_INTEGER fileSize;
+    GetFileSizeEx(file, &fileSize);
+    size_ = fileSize.QuadPart;
+    fileMapping_ = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (fileMapping_)
+        mapping_ = MapViewOfFile(fileMapping_, FILE_MAP_READ, 0, 0, 0);
+    if (!mapping_)
+    {
+        if (fileMapping_)
+            CloseHandle(fileMapping_);
+        throw SerializationException("Cannot map archive " + path);
+    }
+#else
+    int file = ::open(path.c_str(), O_RDONLY);
+    if (file < 0)
+        throw SerializationException("Cannot open archive " + path);
+    
+    struct stat fileStat;
+    if (fstat(file, &fileStat) == 0)
+    {
+        size_ = fileStat.st_size;
+        mapping_ = mmap(NULL, size_, PROT_READ, MAP_PRIVATE, file, 0);
+        if (mapping_ == MAP_FAILED)
+            mapping_ = NULL;
+    }
+    close(file);
+    if (!mapping_)
+        throw SerializationException("Cannot map archive " + path);
+#endif
+    
+    data_ = static_cast<const char*>(mapping_);
+    try
+    {
+        parse();
+    }
+    catch (...)
+    {
+        unmap();
+        throw;
+    }
+}
+
+
+MappedArchive::MappedArchive(const void* data, size_t size, const Class& clazz)
+    : class_(&clazz),
+      data_(static_cast<const char*>(data)),
+      size_(size),
+      mapping_(NULL),
+      fileMapping_(NULL),
+      records_(NULL),
+      recordSize_(0),
+      recordCount_(0),
+      schemaCurrent_(false)
+{
+    parse();
+}
+
+
+const Class& MappedArchive::getClass() const
+{
+    return *class_;
+}
+
+
+size_t MappedArchive::getRecordCount() const
+{
+    return recordCount_;
+}
+
+
+RecordView MappedArchive::getRecord(size_t index) const
+{
+    if (index >= recordCount_)
+        throw SerializationException("Archive record index out of range");
+    return RecordView(*this, records_ + index * recordSize_);
+}
+
+
+bool MappedArchive::isSchemaCurrent() const
+{
+    return schemaCurrent_;
+}
+
+
+MappedArchive::~MappedArchive()
+{
+    unmap();
+}
+
+
+void MappedArchive::unmap()
+{
+    if (!mapping_)
+        return;
+    
+#ifdef _WIN32
+    UnmapViewOfFile(mapping_);
+    CloseHandle(fileMapping_);
+#else
+    munmap(mapping_, size_);
+#endif
+    mapping_ = NULL;
+}
+
+
+void MappedArchive::parse()
+{
+    SchemaReader reader(data_, size_);
+    
+    if (reader.readString(sizeof(archiveMagic))
+            != string(archiveMagic, sizeof(archiveMagic)))
+        throw SerializationException("Not an archive");
+    if (reader.read<uint32_t>() != archiveVersion)
+        throw SerializationException("Unsupported archive version");
+    
+    uint32_t fieldCount = reader.read<uint32_t>();
+    recordSize_ = reader.read<uint32_t>();
+    recordCount_ = reader.read<uint64_t>();
+    uint64_t fingerprint = reader.read<uint64_t>();
+    
+    map<string, ArchivedField> archivedFields;
+    for (uint32_t i = 0; i < fieldCount; i++)
+    {
+        ArchivedField field;
+        field.offset = reader.read<uint32_t>();
+        field.size = reader.read<uint32_t>();
+        uint16_t pathLength = reader.read<uint16_t>();
+        uint16_t typeNameLength = reader.read<uint16_t>();
+        string path = reader.readString(pathLength);
+        field.typeName = reader.readString(typeNameLength);
+        if (field.size > recordSize_
+            || field.offset > recordSize_ - field.size)
+            throw SerializationException("Corrupted archive field " + path);
+        archivedFields[path] = field;
+    }
+    
+    size_t position = reader.getPosition();
+    position += (archiveAlignment - position % archiveAlignment)
+            % archiveAlignment;
+    if (position > size_ || recordSize_ == 0
+        || (size_ - position) / recordSize_ < recordCount_)
+        throw SerializationException("Truncated archive");
+    records_ = data_ + position;
+    
+    // reconcile the current fields with the archived ones
+    ArchiveWriter::Column_Vector currentColumns;
+    ArchiveWriter::addColumns(*class_, "", 0, currentColumns);
+    
+    schemaCurrent_ = fingerprint == class_->getLayout().getFingerprint()
+            && recordSize_ == class_->getSize()
+            && fieldCount == currentColumns.size();
+    
+    for (size_t i = 0; i < currentColumns.size(); i++)
+    {
+        Column column;
+        column.path = currentColumns[i].path;
+        column.type = currentColumns[i].type;
+        column.offset = currentColumns[i].offset;
+        column.archiveOffset = -1;
+        
+        map<string, ArchivedField>::const_iterator ite =
+                archivedFields.find(column.path);
+        if (ite != archivedFields.end()
+            && ite->second.size == column.type->getSize()
+            && ite->second.typeName == column.type->getName())
+            column.archiveOffset = ite->second.offset;
+        
+        if (column.archiveOffset != static_cast<ptrdiff_t>(column.offset))
+            schemaCurrent_ = false;
+        columns_.push_back(column);
+    }
+    sort(columns_.begin(), columns_.end(), columnBefore<Column>);
+    
+    // index the columns of the class properties
+    const ClassLayout::Field_Vector& fields = class_->getLayout().getFields();
+    fieldColumns_.assign(fields.size(), -1);
+    for (size_t i = 0; i < fields.size(); i++)
+    {
+        const Column* column =
+                findColumn(fields[i].property->getUnqualifiedName());
+        if (column)
+            fieldColumns_[i] = column - &columns_[0];
+    }
+}
+
+
+const MappedArchive::Column* MappedArchive::findColumn(const string& path) const
+{
+    Column key;
+    key.path = path;
+    Column_Vector::const_iterator ite = lower_bound(columns_.begin(),
+            columns_.end(), key, columnBefore<Column>);
+    if (ite == columns_.end() || ite->path != path)
+        return NULL;
+    return &*ite;
+}
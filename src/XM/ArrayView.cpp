@@ -0,0 +1,288 @@
+/******************************************************************************      
+ *      Extended Mirror: ArrayView.cpp                                        *
+ ******************************************************************************
+ *      Copyright (c) 2012-2015, Manuele Finocchiaro                          *
+ *      All rights reserved.                                                  *
+ ******************************************************************************
+ * Redistribution and use in source and binary forms, with or without         *
+ * modification, are permitted provided that the following conditions         *
+ * are met:                                                                   *
+ *                                                                            *
+ *    1. Redistributions of source code must retain the above copyright       *
+ *       notice, this list of conditions and the following disclaimer.        *
+ *                                                                            *
+ *    2. Redistributions in binary form must reproduce the above copyright    *
+ *       notice, this list of conditions and the following disclaimer in      *
+ *       the documentation and/or other materials provided with the           *
+ *       distribution.                                                        *
+ *                                                                            *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"* 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE  *
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE *
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE  *
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR        *
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF       *
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS   *
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN    *
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)    *
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF     *
+ * THE POSSIBILITY OF SUCH DAMAGE.                                            *
+ *****************************************************************************/
+
+
+#include <XM/xMirror.hpp>
+#include <XM/Exceptions/SequenceIndexException.hpp>
+
+#include <cstring>
+
+using namespace std;
+using namespace xm;
+
+
+ArrayView::ArrayView(void* data, const ArrayType& type, bool isConst)
+    : data_(static_cast<char*>(data)), isConst_(isConst)
+{
+    init(type);
+}
+
+
+ArrayView::ArrayView(void* data,
+                     const Type& elementType,
+                     const Extent_Vector& extents,
+                     const Stride_Vector& strides,
+                     bool isConst)
+    : data_(static_cast<char*>(data)),
+      elementType_(&elementType),
+      extents_(extents),
+      strides_(strides),
+      isConst_(isConst),
+      plainData_(ClassLayout::isPlainData(elementType))
+{
+}
+
+
+ArrayView::ArrayView(const Variant& self, const Property& property)
+{
+    const ArrayType* type = dynamic_cast<const ArrayType*>(
+            &property.getType());
+    if (!type)
+        throw VariantTypeException(property.getType(), property.getType());
+    
+    // arrays are returned as a pointer to their first element
+    Variant value = property.getData(self);
+    data_ = *static_cast<char**>(value.getAddress());
+    isConst_ = value.isConst() || self.isConst();
+    init(*type);
+}
+
+
+void ArrayView::init(const ArrayType& type)
+{
+    // collect the extents of the nested arrays
+    const Type* elementType = &type;
+    const ArrayType* arrayType;
+    while ((arrayType = dynamic_cast<const ArrayType*>(elementType)))
+    {
+        extents_.push_back(arrayType->getArraySize());
+        elementType = &arrayType->getArrayElementType();
+    }
+    elementType_ = elementType;
+    plainData_ = ClassLayout::isPlainData(*elementType);
+    
+    // row-major strides
+    strides_.resize(extents_.size());
+    ptrdiff_t stride = elementType->getSize();
+    for (size_t i = extents_.size(); i > 0; i--)
+    {
+        strides_[i - 1] = stride;
+        stride *= extents_[i - 1];
+    }
+}
+
+
+const Type& ArrayView::getElementType() const
+{
+    return *elementType_;
+}
+
+
+size_t ArrayView::getRank() const
+{
+    return extents_.size();
+}
+
+
+const ArrayView::Extent_Vector& ArrayView::getExtents() const
+{
+    return extents_;
+}
+
+
+const ArrayView::Stride_Vector& ArrayView::getStrides() const
+{
+    return strides_;
+}
+
+
+size_t ArrayView::getSize() const
+{
+    size_t size = 1;
+    for (size_t i = 0; i < extents_.size(); i++)
+        size *= extents_[i];
+    return size;
+}
+
+
+bool ArrayView::isContiguous() const
+{
+    ptrdiff_t stride = elementType_->getSize();
+    for (size_t i = extents_.size(); i > 0; i--)
+    {
+        if (extents_[i - 1] > 1 && strides_[i - 1] != stride)
+            return false;
+        stride *= extents_[i - 1];
+    }
+    return true;
+}
+
+
+bool ArrayView::isConst() const
+{
+    return isConst_;
+}
+
+
+void* ArrayView::getAddress(const size_t* index) const
+{
+    char* address = data_;
+    for (size_t i = 0; i < extents_.size(); i++)
+    {
+        if (index[i] >= extents_[i])
+            throw SequenceIndexException(index[i], extents_[i]);
+        address += index[i] * strides_[i];
+    }
+    return address;
+}
+
+
+void* ArrayView::getAddress(initializer_list<size_t> index) const
+{
+    // the tuple must have one index per dimension
+    if (index.size() != extents_.size())
+        throw SequenceIndexException(index.size(), extents_.size());
+    return getAddress(index.begin());
+}
+
+
+Variant ArrayView::at(const size_t* index) const
+{
+    return Variant(getAddress(index), *elementType_, isConst_ ? Variant::Const
+                                                              : 0);
+}
+
+
+Variant ArrayView::at(initializer_list<size_t> index) const
+{
+    return Variant(getAddress(index), *elementType_, isConst_ ? Variant::Const
+                                                              : 0);
+}
+
+
+ArrayView ArrayView::slice(size_t index) const
+{
+    if (extents_.empty() || index >= extents_[0])
+        throw SequenceIndexException(index, extents_.empty() ? 0
+                                                             : extents_[0]);
+    return ArrayView(data_ + index * strides_[0], *elementType_,
+            Extent_Vector(extents_.begin() + 1, extents_.end()),
+            Stride_Vector(strides_.begin() + 1, strides_.end()), isConst_);
+}
+
+
+void ArrayView::copyTo(void* buffer) const
+{
+    char* dst = static_cast<char*>(buffer);
+    if (plainData_ && isContiguous())
+        memcpy(dst, data_, getSize() * elementType_->getSize());
+    else
+        copy(data_, dst, 0, true);
+}
+
+
+void ArrayView::copyFrom(const void* buffer) const
+{
+    if (isConst_)
+        throw VariantCostnessException(*elementType_);
+    
+    char* src = static_cast<char*>(const_cast<void*>(buffer));
+    if (plainData_ && isContiguous())
+        memcpy(data_, src, getSize() * elementType_->getSize());
+    else
+        copy(data_, src, 0, false);
+}
+
+
+void ArrayView::checkElementType(const Type& type) const
+{
+    if (type != *elementType_)
+        throw VariantTypeException(type, *elementType_);
+}
+
+
+void ArrayView::copy(char* data, char*& buffer, size_t dim, bool toBuffer)
+        const
+{
+    size_t elementSize = elementType_->getSize();
+    if (dim == extents_.size())
+    {
+        if (toBuffer)
+            assign(buffer, data);
+        else
+            assign(data, buffer);
+        buffer += elementSize;
+        return;
+    }
+    
+    // dense innermost rows are copied at once
+    if (plainData_ && dim + 1 == extents_.size()
+        && strides_[dim] == static_cast<ptrdiff_t>(elementSize))
+    {
+        size_t size = extents_[dim] * elementSize;
+        if (toBuffer)
+            memcpy(buffer, data, size);
+        else
+            memcpy(data, buffer, size);
+        buffer += size;
+        return;
+    }
+    
+    for (size_t i = 0; i < extents_[dim]; i++)
+        copy(data + i * strides_[dim], buffer, dim + 1, toBuffer);
+}
+
+
+void ArrayView::assign(char* dst, const char* src) const
+{
+    switch (elementType_->getCategory())
+    {
+        case Type::String:
+            *reinterpret_cast<string*>(dst) =
+                    *reinterpret_cast<const string*>(src);
+            break;
+            
+        case Type::Class:
+        case Type::CompoundClass:
+        {
+            // objects are copy assigned, a failed copy leaves dst intact
+            const Class& clazz = dynamic_cast<const Class&>(*elementType_);
+            Variant dstVar(dst, clazz, 0);
+            Variant srcVar(const_cast<char*>(src), clazz, Variant::Const);
+            clazz.getCopyConstructor().assign(dstVar, srcVar);
+            break;
+        }
+            
+        default:
+            memcpy(dst, src, elementType_->getSize());
+            break;
+    }
+}
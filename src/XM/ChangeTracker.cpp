@@ -0,0 +1,262 @@
+/******************************************************************************      
+ *      Extended Mirror: ChangeTracker.cpp                                    *
+ ******************************************************************************
+ *      Copyright (c) 2012-2015, Manuele Finocchiaro                          *
+ *      All rights reserved.                                                  *
+ ******************************************************************************
+ * Redistribution and use in source and binary forms, with or without         *
+ * modification, are permitted provided that the following conditions         *
+ * are met:                                                                   *
+ *                                                                            *
+ *    1. Redistributions of source code must retain the above copyright       *
+ *       notice, this list of conditions and the following disclaimer.        *
+ *                                                                            *
+ *    2. Redistributions in binary form must reproduce the above copyright    *
+ *       notice, this list of conditions and the following disclaimer in      *
+ *       the documentation and/or other materials provided with the           *
+ *       distribution.                                                        *
+ *                                                                            *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"* 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE  *
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE *
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE  *
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR        *
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF       *
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS   *
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN    *
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)    *
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF     *
+ * THE POSSIBILITY OF SUCH DAMAGE.                                            *
+ *****************************************************************************/
+
+
+#include <XM/xMirror.hpp>
+#include <XM/ChangeTracker.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+
+using namespace std;
+using namespace xm;
+
+
+namespace {
+
+// Guards the list of the active trackers and their tracked instances.
+mutex& getTrackersMutex()
+{
+    static mutex trackersMutex;
+    return trackersMutex;
+}
+
+
+// The number of active trackers, to skip the lock when there are none.
+atomic<size_t> activeTrackers(0);
+
+} // namespace
+
+
+ChangeListener::~ChangeListener()
+{
+}
+
+
+ChangeTracker::ChangeTracker()
+{
+}
+
+
+void ChangeTracker::track(const Variant& object)
+{
+    const Class* clazz = dynamic_cast<const Class*>(&object.getType());
+    if (!clazz)
+        return;
+    
+    // reserve the room to record every property, so that recording a change
+    // never allocates
+    size_t properties = clazz->getProperties().size();
+    
+    lock_guard<mutex> lock(getTrackersMutex());
+    Entry& entry = entries_[object.getAddress()];
+    if (entry.clazz == clazz)
+        return;
+    entry.clazz = clazz;
+    entry.changed.clear();
+    entry.changed.reserve(properties);
+    
+    // and to queue every instance
+    queue_.reserve(entries_.size());
+    
+    vector<ChangeTracker*>& trackers = getActiveTrackers();
+    if (find(trackers.begin(), trackers.end(), this) == trackers.end())
+    {
+        trackers.push_back(this);
+        activeTrackers = trackers.size();
+    }
+}
+
+
+void ChangeTracker::untrack(const Variant& object)
+{
+    lock_guard<mutex> lock(getTrackersMutex());
+    Entry_Map::iterator ite = entries_.find(object.getAddress());
+    if (ite == entries_.end())
+        return;
+    
+    // a queued address is skipped by flush() once the entry is gone
+    entries_.erase(ite);
+    
+    if (entries_.empty())
+        deactivate();
+}
+
+
+void ChangeTracker::markChanged(const void* object, const Property& property)
+{
+    lock_guard<mutex> lock(getTrackersMutex());
+    markChanged_(object, property);
+}
+
+
+bool ChangeTracker::isChanged(const Variant& object,
+                              const Property& property) const
+{
+    lock_guard<mutex> lock(getTrackersMutex());
+    Entry_Map::const_iterator ite = entries_.find(object.getAddress());
+    if (ite == entries_.end())
+        return false;
+    
+    const vector<const Property*>& changed = ite->second.changed;
+    return find(changed.begin(), changed.end(), &property) != changed.end();
+}
+
+
+void ChangeTracker::addListener(ChangeListener& listener)
+{
+    listeners_.push_back(&listener);
+}
+
+
+void ChangeTracker::removeListener(ChangeListener& listener)
+{
+    vector<ChangeListener*>::iterator ite =
+            find(listeners_.begin(), listeners_.end(), &listener);
+    if (ite != listeners_.end())
+        listeners_.erase(ite);
+}
+
+
+void ChangeTracker::flush()
+{
+    // the changes are collected with the lock held, then delivered without
+    // it; changes made by the listeners are queued and delivered at the
+    // next flush
+    pending_.clear();
+    changed_.clear();
+    {
+        lock_guard<mutex> lock(getTrackersMutex());
+        for (size_t i = 0; i < queue_.size(); i++)
+        {
+            Entry_Map::iterator ite = entries_.find(queue_[i]);
+            if (ite == entries_.end() || ite->second.changed.empty())
+                continue;
+            
+            Entry& entry = ite->second;
+            Pending pending;
+            pending.object = queue_[i];
+            pending.clazz = entry.clazz;
+            pending.first = changed_.size();
+            changed_.insert(changed_.end(), entry.changed.begin(),
+                            entry.changed.end());
+            pending.last = changed_.size();
+            pending_.push_back(pending);
+            entry.changed.clear();
+        }
+        queue_.clear();
+    }
+    
+    for (size_t i = 0; i < pending_.size(); i++)
+    {
+        const Pending& pending = pending_[i];
+        properties_.assign(changed_.begin() + pending.first,
+                           changed_.begin() + pending.last);
+        Variant ref(const_cast<void*>(pending.object), *pending.clazz, 0);
+        for (size_t j = 0; j < listeners_.size(); j++)
+            listeners_[j]->propertiesChanged(ref, properties_);
+    }
+}
+
+
+void ChangeTracker::notifySet(const void* object, const Property& property)
+{
+    if (activeTrackers == 0)
+        return;
+    
+    lock_guard<mutex> lock(getTrackersMutex());
+    vector<ChangeTracker*>& trackers = getActiveTrackers();
+    for (size_t i = 0; i < trackers.size(); i++)
+        trackers[i]->markChanged_(object, property);
+}
+
+
+void ChangeTracker::notifySet(const void* objects, size_t stride,
+                              size_t count, const Property& property)
+{
+    if (activeTrackers == 0)
+        return;
+    
+    lock_guard<mutex> lock(getTrackersMutex());
+    vector<ChangeTracker*>& trackers = getActiveTrackers();
+    const char* object = static_cast<const char*>(objects);
+    for (size_t i = 0; i < count; i++, object += stride)
+    {
+        for (size_t j = 0; j < trackers.size(); j++)
+            trackers[j]->markChanged_(object, property);
+    }
+}
+
+
+ChangeTracker::~ChangeTracker()
+{
+    lock_guard<mutex> lock(getTrackersMutex());
+    if (!entries_.empty())
+        deactivate();
+}
+
+
+void ChangeTracker::markChanged_(const void* object, const Property& property)
+{
+    Entry_Map::iterator ite = entries_.find(object);
+    if (ite == entries_.end())
+        return;
+    
+    // an instance can share the address of its first member, whose
+    // properties are not its own
+    Entry& entry = ite->second;
+    const Class& owner = property.getOwner();
+    if (entry.clazz != &owner && !entry.clazz->inheritsFrom(owner))
+        return;
+    
+    vector<const Property*>& changed = entry.changed;
+    if (find(changed.begin(), changed.end(), &property) != changed.end())
+        return;
+    if (changed.empty())
+        queue_.push_back(object);
+    changed.push_back(&property);
+}
+
+
+void ChangeTracker::deactivate()
+{
+    vector<ChangeTracker*>& trackers = getActiveTrackers();
+    trackers.erase(find(trackers.begin(), trackers.end(), this));
+    activeTrackers = trackers.size();
+}
+
+
+vector<ChangeTracker*>& ChangeTracker::getActiveTrackers()
+{
+    static vector<ChangeTracker*> trackers;
+    return trackers;
+}
@@ -34,6 +34,9 @@
 #include <XM/xMirror.hpp>
 #include <XM/Exceptions/NotFoundException.hpp>
 
+#include <algorithm>
+#include <atomic>
+
 using namespace std;
 using namespace xm;
 
@@ -43,7 +46,11 @@ Class::Class(const string& uName) :
         Type(uName),
         constructor_(new Constructor(*this)),
         copyConstructor_(new CopyConstructor(*this)),
-        destructor_(new Destructor(*this))
+        destructor_(new Destructor(*this)),
+        memberTable_(NULL),
+        layout_(NULL),
+        dynamicResolver_(NULL),
+        classIndex_(makeClassIndex())
 {
 }
 
@@ -53,7 +60,11 @@ Class::Class(const string& uName, const Namespace& name_space) :
         Type(uName, name_space),
         constructor_(new Constructor(*this)),
         copyConstructor_(new CopyConstructor(*this)),
-        destructor_(new Destructor(*this))
+        destructor_(new Destructor(*this)),
+        memberTable_(NULL),
+        layout_(NULL),
+        dynamicResolver_(NULL),
+        classIndex_(makeClassIndex())
 {
 }
 
@@ -74,7 +85,11 @@ Class::Class
     constructor_(&constructor),
     copyConstructor_(&copyConstructor),
     destructor_(&destructor),
-    isAbstract_(isAbstract)
+    memberTable_(NULL),
+    isAbstract_(isAbstract),
+    layout_(NULL),
+    dynamicResolver_(NULL),
+    classIndex_(makeClassIndex())
 {
 }
 
@@ -125,7 +140,9 @@ const Const_Class_Set& Class::getDerivedClasses() const
 
 
 void Class::addBaseClass(Class& baseClass)
-{    
+{
+    Register::Lock lock;
+    
     // put this class into the derived list of the base Class
     baseClass.derivedClasses_.insert(this);
     
@@ -133,42 +150,41 @@ void Class::addBaseClass(Class& baseClass)
     baseClasses_.insert(&baseClass);
     indirectBaseClasses_.insert(&baseClass);
 
-    // add indirect base classes of the base as undirect base classes
-    indirectBaseClasses_.insert(baseClass.indirectBaseClasses_.begin(),
-                                baseClass.indirectBaseClasses_.end());
-    
-    // insert all the base class properties into the properties set
-    const Const_Property_Set& baseClassProperties = baseClass.getProperties();
-    properties_.insert(baseClassProperties.begin(), baseClassProperties.end());
-    items_.insert(baseClassProperties.begin(), baseClassProperties.end());
+    // add the base and its indirect base classes as indirect base classes of
+    // this class and of the classes already derived from it
+    addAncestors(baseClass);
     
-    // insert all the base class method descriptors into the methods set
-    const Const_Method_Set& baseClassMethods = baseClass.getMethods();
-    methods_.insert(baseClassMethods.begin(), baseClassMethods.end());
-    items_.insert(baseClassMethods.begin(), baseClassMethods.end());
+    // the inherited slots, members and layout must be rebuilt
+    vector<MethodSlot> clashes;
+    rebuildDispatch(clashes);
+    resolveClashes(clashes);
+    updateMembers(true);
 }
 
 
 void Class::addMember(Member& member)
 {
+    Register::Lock lock;
     if (&member.getOwner() == this)
     {
         Property* property = dynamic_cast<Property*>(&member);
         if (property)
         {
-            properties_.erase(property);
-            properties_.insert(property);
             ownProperties_.insert(property);
             addItem(*property);
+            updateMembers(true);
             return;
         }
         Method* method = dynamic_cast<Method*>(&member);
         if (method)
         {
-            methods_.erase(method);
-            methods_.insert(method);
+            assignSlot(*method);
             ownMethods_.insert(method);
             addItem(*method);
+            vector<MethodSlot> clashes;
+            dispatchMethod(*method, clashes);
+            resolveClashes(clashes);
+            updateMembers(false);
             return;
         }
         RefCaster* refCaster = dynamic_cast<RefCaster*>(&member);
@@ -185,56 +201,79 @@ void Class::addMember(Member& member)
 
 const Const_Property_Set& Class::getProperties(bool inherited) const
 {
-    if (inherited)
-    {
-        return properties_;
-    }
-    return ownProperties_;
+    if (!inherited || baseClasses_.empty())
+        return ownProperties_;
+    if (baseClasses_.size() == 1 && ownProperties_.empty())
+        return (*baseClasses_.begin())->getProperties();
+    return getMemberTable().properties;
 }
 
 
 const Const_Method_Set& Class::getMethods(bool inherited) const
 {
-    if (inherited)
-    {
-        return methods_;
-    }
-    return ownMethods_;
+    if (!inherited || baseClasses_.empty())
+        return ownMethods_;
+    if (baseClasses_.size() == 1 && ownMethods_.empty())
+        return (*baseClasses_.begin())->getMethods();
+    return getMemberTable().methods;
 }
 
 
 bool Class::hasProperty(const string& propertyName, bool inherited) const
 {
-    if (inherited)
-        return ptrSet::findByKey(properties_, propertyName);
-    else
-        return ptrSet::findByKey(ownProperties_, propertyName);
+    if (ptrSet::findByKey(ownProperties_, propertyName))
+        return true;
+    if (!inherited)
+        return false;
+    
+    Const_Class_Set::const_iterator ite = baseClasses_.begin();
+    for (; ite != baseClasses_.end(); ++ite)
+    {
+        if ((*ite)->hasProperty(propertyName))
+            return true;
+    }
+    return false;
 }
 
 
 bool Class::hasMethod(const string& methodName, bool inherited) const
 {
-    if (inherited)
-        return ptrSet::findByKey(methods_, methodName);
-    else
-        return ptrSet::findByKey(ownMethods_, methodName);
+    if (ptrSet::findByKey(ownMethods_, methodName))
+        return true;
+    if (!inherited)
+        return false;
+    
+    Const_Class_Set::const_iterator ite = baseClasses_.begin();
+    for (; ite != baseClasses_.end(); ++ite)
+    {
+        if ((*ite)->hasMethod(methodName))
+            return true;
+    }
+    return false;
 }
 
 
 bool Class::hasMethod(const Method& method, bool inherited) const
 {
     if (inherited)
-        return (methods_.find(&method) != methods_.end());
+        return findMethod_(method) != NULL;
     else
         return (ownMethods_.find(&method) != ownMethods_.end());
 }
 
 
+const Method* Class::getMethodBySlot(size_t slot) const
+{
+    return slot < dispatch_.size() ? dispatch_[slot] : NULL;
+}
+
+
 bool Class::inheritsFrom(const string& baseClassName) const
 {
+    // the name is resolved once, then the test is the ancestor bit lookup
     const Type& baseClass = getType(baseClassName);
     
-    if (baseClass.getCategory() != Type::Class)
+    if (!(baseClass.getCategory() & Type::Class))
         return false;
     else
         return inheritsFrom(dynamic_cast<const Class&>(baseClass));
@@ -243,12 +282,74 @@ bool Class::inheritsFrom(const string& baseClassName) const
 
 bool Class::inheritsFrom(const Class& baseClass) const
 {
-    Const_Class_Set::iterator ite;
-    ite = indirectBaseClasses_.find(&baseClass);
-    if (ite == indirectBaseClasses_.end())
-        return false;
-    else
-        return true;
+    size_t word = baseClass.classIndex_ / 64;
+    return word < ancestors_.size() &&
+            (ancestors_[word] >> (baseClass.classIndex_ % 64)) & 1;
+}
+
+
+bool Class::isPolymorphic() const
+{
+    return dynamicResolver_ != NULL;
+}
+
+
+const Class& Class::getDynamicClass(void*& object) const
+{
+    if (!dynamicResolver_)
+        return *this;
+    
+    const type_info* dynamicType;
+    void* mostDerived = dynamicResolver_(object, dynamicType);
+    if (*dynamicType == getId())
+        return *this;
+    
+    const Type* type = Register::getSingleton().findType(*dynamicType);
+    if (!type || !(type->getCategory() & Type::Class))
+        return *this;
+    
+    object = mostDerived;
+    return dynamic_cast<const Class&>(*type);
+}
+
+
+std::ptrdiff_t Class::getBaseOffset(const Class& baseClass) const
+{
+    if (&baseClass == this)
+        return 0;
+    
+    // follow the upcasters with a known offset
+    Const_RefCaster_Set::const_iterator ite = refCasters_.begin();
+    while(ite != refCasters_.end())
+    {
+        const RefCaster& caster = **ite;
+        if (caster.getCastDirection() == UpCast && caster.getOffset() >= 0)
+        {
+            ptrdiff_t offset = caster.getDstClass().getBaseOffset(baseClass);
+            if (offset >= 0)
+                return caster.getOffset() + offset;
+        }
+        ite ++;
+    }
+    
+    return -1;
+}
+
+
+const ClassLayout& Class::getLayout() const
+{
+    ClassLayout* layout = layout_.load(memory_order_acquire);
+    if (!layout)
+    {
+        Register::Lock lock;
+        layout = layout_.load(memory_order_relaxed);
+        if (!layout)
+        {
+            layout = new ClassLayout(*this);
+            layout_.store(layout, memory_order_release);
+        }
+    }
+    return *layout;
 }
 
 
@@ -276,7 +377,7 @@ Type::Category Class::getCategory() const
 }
 
 
-Namespace& Class::walkTo(const std::string& path, bool create)
+Namespace* Class::walkTo_(const std::string& path, bool create)
 {
     pair<string, string> pathParts = splitName(path, NameHead);
     if (pathParts.first == "")
@@ -284,22 +385,296 @@ Namespace& Class::walkTo(const std::string& path, bool create)
         string name = Item::getNamespace().getName() + "::" + pathParts.second;
         const Class* found = ptrSet::findByKey(indirectBaseClasses_, name);
         if (found)
-            return const_cast<Class&>(*found);
+            return const_cast<Class*>(found);
         else
-            return Namespace::walkTo(path, create);
+            return Namespace::walkTo_(path, create);
     }
     else
     {
         string name = Item::getNamespace().getName() + "::" + pathParts.first;
         const Class* found = ptrSet::findByKey(baseClasses_, name);
         if (found)
-            return const_cast<Class&>(*found).walkTo(pathParts.second, create);
+            return const_cast<Class&>(*found).walkTo_(pathParts.second,
+                                                      create);
         else
-            return Namespace::walkTo(path, create);
+            return Namespace::walkTo_(path, create);
+    }
+}
+
+
+size_t Class::makeClassIndex()
+{
+    static atomic<size_t> count(0);
+    return count++;
+}
+
+
+void Class::addAncestors(const Class& baseClass)
+{
+    indirectBaseClasses_.insert(&baseClass);
+    indirectBaseClasses_.insert(baseClass.indirectBaseClasses_.begin(),
+                                baseClass.indirectBaseClasses_.end());
+    
+    size_t words = max(baseClass.ancestors_.size(),
+                       baseClass.classIndex_ / 64 + 1);
+    if (ancestors_.size() < words)
+        ancestors_.resize(words, 0);
+    for (size_t i = 0; i < baseClass.ancestors_.size(); i++)
+        ancestors_[i] |= baseClass.ancestors_[i];
+    ancestors_[baseClass.classIndex_ / 64] |=
+            uint64_t(1) << (baseClass.classIndex_ % 64);
+    
+    Const_Class_Set::iterator ite = derivedClasses_.begin();
+    while(ite != derivedClasses_.end())
+    {
+        const_cast<Class*>(*ite)->addAncestors(baseClass);
+        ite ++;
+    }
+}
+
+
+const Class::MemberTable& Class::getMemberTable() const
+{
+    MemberTable* table = memberTable_.load(memory_order_acquire);
+    if (!table)
+    {
+        Register::Lock lock;
+        table = memberTable_.load(memory_order_relaxed);
+        if (!table)
+        {
+            table = new MemberTable();
+            fillMembers(*table);
+            memberTable_.store(table, memory_order_release);
+        }
+    }
+    return *table;
+}
+
+
+void Class::fillMembers(MemberTable& table) const
+{
+    // the own members are inserted first and hide the inherited ones
+    table.properties.insert(ownProperties_.begin(), ownProperties_.end());
+    table.methods.insert(ownMethods_.begin(), ownMethods_.end());
+    
+    Const_Class_Set::const_iterator ite = baseClasses_.begin();
+    for (; ite != baseClasses_.end(); ++ite)
+        (*ite)->fillMembers(table);
+}
+
+
+void Class::updateMembers(bool properties)
+{
+    // the layouts handed out are kept, a new one is built on request
+    ClassLayout* layout = layout_.load(memory_order_relaxed);
+    if (properties && layout)
+    {
+        oldLayouts_.push_back(layout);
+        layout_.store(NULL, memory_order_release);
+    }
+    
+    // an existing table is refilled in place, so that the sets returned by
+    // getProperties() and getMethods() stay valid
+    MemberTable* table = memberTable_.load(memory_order_relaxed);
+    if (table)
+    {
+        table->properties.clear();
+        table->methods.clear();
+        fillMembers(*table);
+    }
+    
+    Const_Class_Set::iterator ite = derivedClasses_.begin();
+    for (; ite != derivedClasses_.end(); ++ite)
+        const_cast<Class*>(*ite)->updateMembers(properties);
+}
+
+
+const Member* Class::lookupMember_(const Item& keyItem) const
+{
+    // a key without the full signature matches all the overloads, of which
+    // the first in order is taken; an inherited member takes the place of
+    // an own one only if it comes strictly first, so the own ones hide the
+    // inherited ones with the same key
+    const Member* member =
+            dynamic_cast<const Member*>(Namespace::lookupItem_(keyItem));
+    
+    Const_Class_Set::const_iterator ite = baseClasses_.begin();
+    for (; ite != baseClasses_.end(); ++ite)
+    {
+        const Member* inherited = (*ite)->lookupMember_(keyItem);
+        if (inherited && (!member || *inherited < *member))
+            member = inherited;
+    }
+    return member;
+}
+
+
+const Method* Class::findMethod_(const Method& keyMethod) const
+{
+    Const_Method_Set::const_iterator method = ownMethods_.find(&keyMethod);
+    if (method != ownMethods_.end())
+        return *method;
+    
+    Const_Class_Set::const_iterator ite = baseClasses_.begin();
+    for (; ite != baseClasses_.end(); ++ite)
+    {
+        const Method* found = (*ite)->findMethod_(keyMethod);
+        if (found)
+            return found;
+    }
+    return NULL;
+}
+
+
+void Class::putMethod(size_t slot, const Method* method,
+                      vector<MethodSlot>& clashes)
+{
+    if (dispatch_.size() <= slot)
+        dispatch_.resize(slot + 1, NULL);
+    const Method* current = dispatch_[slot];
+    if (current && (*current < *method || *method < *current))
+        clashes.push_back(MethodSlot(method, slot));
+    else
+        dispatch_[slot] = method;
+}
+
+
+void Class::dispatchMethod(const Method& method, vector<MethodSlot>& clashes)
+{
+    // a derived class may override the method
+    putMethod(method.getSlot(), findMethod_(method), clashes);
+    
+    Const_Class_Set::iterator ite = derivedClasses_.begin();
+    for (; ite != derivedClasses_.end(); ++ite)
+        const_cast<Class*>(*ite)->dispatchMethod(method, clashes);
+}
+
+
+void Class::rebuildDispatch(vector<MethodSlot>& clashes)
+{
+    // the dispatch array extends the ones of the bases, whose slots get the
+    // methods of this class with the same keys, then the own methods are
+    // put in their slots
+    dispatch_.clear();
+    Const_Class_Set::const_iterator ite = baseClasses_.begin();
+    for (; ite != baseClasses_.end(); ++ite)
+    {
+        const vector<const Method*>& base = (*ite)->dispatch_;
+        for (size_t slot = 0; slot < base.size(); slot++)
+        {
+            if (base[slot])
+                putMethod(slot, findMethod_(*base[slot]), clashes);
+        }
+    }
+    
+    Const_Method_Set::const_iterator method = ownMethods_.begin();
+    for (; method != ownMethods_.end(); ++method)
+    {
+        if ((*method)->getSlot() != Method::NoSlot)
+            putMethod((*method)->getSlot(), *method, clashes);
+    }
+    
+    for (ite = derivedClasses_.begin(); ite != derivedClasses_.end(); ++ite)
+        const_cast<Class*>(*ite)->rebuildDispatch(clashes);
+}
+
+
+void Class::resolveClashes(vector<MethodSlot>& clashes)
+{
+    // every move takes a slot free in the whole hierarchy, so the clashes
+    // end
+    while (!clashes.empty())
+    {
+        MethodSlot clash = clashes.front();
+        clashes.clear();
+        moveSlot(clash, clashes);
     }
 }
 
 
+void Class::assignSlot(Method& method) const
+{
+    Const_Class_Set::const_iterator ite = baseClasses_.begin();
+    for (; ite != baseClasses_.end(); ++ite)
+    {
+        const Method* overridden = (*ite)->findMethod_(method);
+        if (overridden)
+        {
+            method.slot_ = overridden->getSlot();
+            return;
+        }
+    }
+    method.slot_ = getFreeSlot();
+}
+
+
+size_t Class::getFreeSlot() const
+{
+    size_t slot = dispatch_.size();
+    Const_Class_Set::const_iterator ite = derivedClasses_.begin();
+    for (; ite != derivedClasses_.end(); ++ite)
+        slot = max(slot, (*ite)->getFreeSlot());
+    return slot;
+}
+
+
+void Class::moveSlot(const MethodSlot& clash, vector<MethodSlot>& clashes)
+{
+    // collect the hierarchy, through the bases and the derived classes
+    vector<Class*> hierarchy(1, this);
+    set<const Class*> visited;
+    visited.insert(this);
+    for (size_t i = 0; i < hierarchy.size(); i++)
+    {
+        const Const_Class_Set* links[] =
+                {&hierarchy[i]->baseClasses_, &hierarchy[i]->derivedClasses_};
+        for (size_t j = 0; j < 2; j++)
+        {
+            Const_Class_Set::const_iterator ite = links[j]->begin();
+            for (; ite != links[j]->end(); ++ite)
+            {
+                if (visited.insert(*ite).second)
+                    hierarchy.push_back(const_cast<Class*>(*ite));
+            }
+        }
+    }
+    
+    const Method& method = *clash.first;
+    size_t newSlot = 0;
+    for (size_t i = 0; i < hierarchy.size(); i++)
+        newSlot = max(newSlot, hierarchy[i]->dispatch_.size());
+    
+    for (size_t i = 0; i < hierarchy.size(); i++)
+    {
+        const Const_Method_Set& methods = hierarchy[i]->ownMethods_;
+        Const_Method_Set::const_iterator ite = methods.begin();
+        for (; ite != methods.end(); ++ite)
+        {
+            if ((*ite)->getSlot() == clash.second && !(**ite < method)
+                    && !(method < **ite))
+                const_cast<Method*>(*ite)->slot_ = newSlot;
+        }
+    }
+    
+    for (size_t i = 0; i < hierarchy.size(); i++)
+    {
+        if (hierarchy[i]->baseClasses_.empty())
+            hierarchy[i]->rebuildDispatch(clashes);
+    }
+}
+
+
+const Item* Class::lookupItem_(const Item& keyItem) const
+{
+    // members are looked up among the inherited ones too, the other items
+    // only among the own ones
+    const Member* member = lookupMember_(keyItem);
+    if (member)
+        return member;
+    return Namespace::lookupItem_(keyItem);
+}
+
+
 Item::Category Class::getItemCategory() const
 {
     return TypeItem;
@@ -327,6 +702,10 @@ Class::~Class()
     delete constructor_;
     delete copyConstructor_;
     delete destructor_;
+    delete layout_.load();
+    for (size_t i = 0; i < oldLayouts_.size(); i++)
+        delete oldLayouts_[i];
+    delete memberTable_.load();
     ptrSet::deleteAll(refCasters_);
 }
 
@@ -0,0 +1,258 @@
+/******************************************************************************      
+ *      Extended Mirror: ClassLayout.cpp                                      *
+ ******************************************************************************
+ *      Copyright (c) 2012-2015, Manuele Finocchiaro                          *
+ *      All rights reserved.                                                  *
+ ******************************************************************************
+ * Redistribution and use in source and binary forms, with or without         *
+ * modification, are permitted provided that the following conditions         *
+ * are met:                                                                   *
+ *                                                                            *
+ *    1. Redistributions of source code must retain the above copyright       *
+ *       notice, this list of conditions and the following disclaimer.        *
+ *                                                                            *
+ *    2. Redistributions in binary form must reproduce the above copyright    *
+ *       notice, this list of conditions and the following disclaimer in      *
+ *       the documentation and/or other materials provided with the           *
+ *       distribution.                                                        *
+ *                                                                            *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"* 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE  *
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE *
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE  *
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR        *
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF       *
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS   *
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN    *
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)    *
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF     *
+ * THE POSSIBILITY OF SUCH DAMAGE.                                            *
+ *****************************************************************************/
+
+
+#include <XM/xMirror.hpp>
+
+#include <algorithm>
+
+using namespace std;
+using namespace xm;
+
+
+namespace {
+
+// Fields with an offset come first sorted by offset, then the others.
+// The sort is stable, so properties with no offset keep the name order.
+bool fieldBefore(const ClassLayout::Field& f1, const ClassLayout::Field& f2)
+{
+    if (f1.offset < 0 || f2.offset < 0)
+        return f1.offset >= 0 && f2.offset < 0;
+    return f1.offset < f2.offset;
+}
+
+
+// Orders the field indexes by property name.
+struct KeyBefore
+{
+    const ClassLayout::Field_Vector* fields;
+    
+    bool operator()(size_t i1, size_t i2) const
+    {
+        return (*fields)[i1].property->getUnqualifiedName()
+                < (*fields)[i2].property->getUnqualifiedName();
+    }
+};
+
+
+// FNV-1a hash
+const uint64_t fnvOffsetBasis = 14695981039346656037ULL;
+const uint64_t fnvPrime = 1099511628211ULL;
+
+void hashBytes(uint64_t& hash, const void* data, size_t size)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= fnvPrime;
+    }
+}
+
+
+void hashString(uint64_t& hash, const string& str)
+{
+    // hash the terminator too, to separate consecutive strings
+    hashBytes(hash, str.c_str(), str.size() + 1);
+}
+
+} // namespace
+
+
+ClassLayout::ClassLayout(const Class& clazz)
+    : class_(&clazz), fingerprint_(fnvOffsetBasis)
+{
+    const Const_Property_Set& properties = clazz.getProperties();
+    Const_Property_Set::const_iterator ite = properties.begin();
+    while (ite != properties.end())
+    {
+        const Property& property = **ite;
+        Field field;
+        field.property = &property;
+        field.offset = -1;
+        
+        // the field offset is the one within the owner subobject plus the
+        // offset of the owner subobject
+        ptrdiff_t fieldOffset = property.getOffset();
+        if (fieldOffset >= 0)
+        {
+            ptrdiff_t ownerOffset = clazz.getBaseOffset(property.getOwner());
+            if (ownerOffset >= 0)
+                field.offset = ownerOffset + fieldOffset;
+        }
+        
+        fields_.push_back(field);
+        ite ++;
+    }
+    
+    stable_sort(fields_.begin(), fields_.end(), fieldBefore);
+    
+    // group adjacent primitive fields into runs
+    for (size_t i = 0; i < fields_.size() && fields_[i].offset >= 0; i++)
+    {
+        const Type& type = fields_[i].property->getType();
+        if (type.getCategory() != Type::Primitive)
+            continue;
+        
+        size_t offset = fields_[i].offset;
+        if (!runs_.empty())
+        {
+            Run& last = runs_.back();
+            if (last.firstField + last.fieldCount == i
+                && last.offset + last.size == offset)
+            {
+                last.size += type.getSize();
+                last.fieldCount ++;
+                continue;
+            }
+        }
+        
+        Run run;
+        run.offset = offset;
+        run.size = type.getSize();
+        run.firstField = i;
+        run.fieldCount = 1;
+        runs_.push_back(run);
+    }
+    
+    // build the key table and the property index
+    for (size_t i = 0; i < fields_.size(); i++)
+    {
+        keys_.push_back(i);
+        propertyIndexes_.push_back(make_pair(fields_[i].property, i));
+    }
+    sort(propertyIndexes_.begin(), propertyIndexes_.end());
+    KeyBefore keyBefore = {&fields_};
+    sort(keys_.begin(), keys_.end(), keyBefore);
+    
+    // compute the fingerprint
+    for (size_t i = 0; i < fields_.size(); i++)
+    {
+        const Property& property = *fields_[i].property;
+        hashString(fingerprint_, property.getUnqualifiedName());
+        
+        const Type* type = &property.getType();
+        hashString(fingerprint_, type->getName());
+        
+        // nested classes contribute with their fingerprint
+        while (type->getCategory() == Type::Array)
+            type = &dynamic_cast<const ArrayType*>(type)->getArrayElementType();
+        if (type->getCategory() & Type::Class)
+        {
+            uint64_t nested = dynamic_cast<const Class*>(type)->getLayout()
+                    .getFingerprint();
+            hashBytes(fingerprint_, &nested, sizeof(nested));
+        }
+    }
+}
+
+
+const Class& ClassLayout::getClass() const
+{
+    return *class_;
+}
+
+
+const ClassLayout::Field_Vector& ClassLayout::getFields() const
+{
+    return fields_;
+}
+
+
+const ClassLayout::Run_Vector& ClassLayout::getRuns() const
+{
+    return runs_;
+}
+
+
+int ClassLayout::getFieldIndex(const Property& property) const
+{
+    vector<pair<const Property*, size_t> >::const_iterator ite =
+            lower_bound(propertyIndexes_.begin(), propertyIndexes_.end(),
+                    make_pair(&property, size_t(0)));
+    if (ite == propertyIndexes_.end() || ite->first != &property)
+        return -1;
+    return ite->second;
+}
+
+
+int ClassLayout::findField(const char* name, size_t length) const
+{
+    size_t first = 0;
+    size_t last = keys_.size();
+    while (first < last)
+    {
+        size_t middle = first + (last - first) / 2;
+        const string& key =
+                fields_[keys_[middle]].property->getUnqualifiedName();
+        int cmp = key.compare(0, string::npos, name, length);
+        if (cmp == 0)
+            return keys_[middle];
+        else if (cmp < 0)
+            first = middle + 1;
+        else
+            last = middle;
+    }
+    return -1;
+}
+
+
+uint64_t ClassLayout::getFingerprint() const
+{
+    return fingerprint_;
+}
+
+
+bool ClassLayout::isPlainData(const Type& type)
+{
+    switch (type.getCategory())
+    {
+        case Type::Primitive:
+            return true;
+        
+        case Type::Array:
+            return isPlainData(
+                dynamic_cast<const ArrayType&>(type).getArrayElementType());
+            
+        default:
+            return false;
+    }
+}
+
+
+size_t ClassLayout::getMemorySize() const
+{
+    return sizeof(ClassLayout)
+            + fields_.capacity() * sizeof(Field)
+            + runs_.capacity() * sizeof(Run)
+            + keys_.capacity() * sizeof(size_t)
+            + propertyIndexes_.capacity() * sizeof(propertyIndexes_[0]);
+}
@@ -0,0 +1,251 @@
+/******************************************************************************      
+ *      Extended Mirror: Columns.cpp                                          *
+ ******************************************************************************
+ *      Copyright (c) 2012-2015, Manuele Finocchiaro                          *
+ *      All rights reserved.                                                  *
+ ******************************************************************************
+ * Redistribution and use in source and binary forms, with or without         *
+ * modification, are permitted provided that the following conditions         *
+ * are met:                                                                   *
+ *                                                                            *
+ *    1. Redistributions of source code must retain the above copyright       *
+ *       notice, this list of conditions and the following disclaimer.        *
+ *                                                                            *
+ *    2. Redistributions in binary form must reproduce the above copyright    *
+ *       notice, this list of conditions and the following disclaimer in      *
+ *       the documentation and/or other materials provided with the           *
+ *       distribution.                                                        *
+ *                                                                            *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"* 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE  *
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE *
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE  *
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR        *
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF       *
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS   *
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN    *
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)    *
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF     *
+ * THE POSSIBILITY OF SUCH DAMAGE.                                            *
+ *****************************************************************************/
+
+
+#include <XM/xMirror.hpp>
+#include <XM/Columns.hpp>
+#include <XM/ChangeTracker.hpp>
+#include <XM/Exceptions/MemberExceptions.hpp>
+#include <XM/Exceptions/NotFoundException.hpp>
+
+#include <cstring>
+
+using namespace std;
+using namespace xm;
+
+
+namespace {
+
+// Strided copies specialized on the value size. The fixed size memcpy
+// compiles to a single load or store, which lets the loops be vectorized.
+template<typename T>
+void gatherValues(const char* src, size_t stride, size_t count, char* dst)
+{
+    for (size_t i = 0; i < count; i++)
+        memcpy(dst + i * sizeof(T), src + i * stride, sizeof(T));
+}
+
+
+template<typename T>
+void scatterValues(const char* src, size_t count, char* dst, size_t stride)
+{
+    for (size_t i = 0; i < count; i++)
+        memcpy(dst + i * stride, src + i * sizeof(T), sizeof(T));
+}
+
+
+struct Value2 { char bytes[2]; };
+struct Value4 { char bytes[4]; };
+struct Value8 { char bytes[8]; };
+struct Value16 { char bytes[16]; };
+
+
+void gatherField(const char* src, size_t stride, size_t size, size_t count,
+                 char* dst)
+{
+    // contiguous values
+    if (stride == size)
+    {
+        memcpy(dst, src, size * count);
+        return;
+    }
+    
+    switch (size)
+    {
+        case 1: gatherValues<char>(src, stride, count, dst); break;
+        case 2: gatherValues<Value2>(src, stride, count, dst); break;
+        case 4: gatherValues<Value4>(src, stride, count, dst); break;
+        case 8: gatherValues<Value8>(src, stride, count, dst); break;
+        case 16: gatherValues<Value16>(src, stride, count, dst); break;
+        default:
+            for (size_t i = 0; i < count; i++)
+                memcpy(dst + i * size, src + i * stride, size);
+            break;
+    }
+}
+
+
+void scatterField(const char* src, size_t size, size_t count, char* dst,
+                  size_t stride)
+{
+    if (stride == size)
+    {
+        memcpy(dst, src, size * count);
+        return;
+    }
+    
+    switch (size)
+    {
+        case 1: scatterValues<char>(src, count, dst, stride); break;
+        case 2: scatterValues<Value2>(src, count, dst, stride); break;
+        case 4: scatterValues<Value4>(src, count, dst, stride); break;
+        case 8: scatterValues<Value8>(src, count, dst, stride); break;
+        case 16: scatterValues<Value16>(src, count, dst, stride); break;
+        default:
+            for (size_t i = 0; i < count; i++)
+                memcpy(dst + i * stride, src + i * size, size);
+            break;
+    }
+}
+
+
+// Get the offset of the property within an instance of the class, -1 if it
+// is accessed through getter and setter.
+ptrdiff_t getFieldOffset(const Class& clazz, const Property& property)
+{
+    const ClassLayout& layout = clazz.getLayout();
+    int index = layout.getFieldIndex(property);
+    if (index < 0)
+        throw NotFoundException(clazz, property);
+    return layout.getFields()[index].offset;
+}
+
+} // namespace
+
+
+Column::Column(const Property& property, size_t size)
+    : property_(&property), buffer_(NULL), data_(NULL), size_(0)
+{
+    if (!ClassLayout::isPlainData(property.getType()))
+        throw NonCopyableException(property.getType());
+    resize(size);
+}
+
+
+const Property& Column::getProperty() const
+{
+    return *property_;
+}
+
+
+const Type& Column::getType() const
+{
+    return property_->getType();
+}
+
+
+size_t Column::getSize() const
+{
+    return size_;
+}
+
+
+void Column::resize(size_t size)
+{
+    if (size == size_ && buffer_)
+        return;
+    
+    delete[] buffer_;
+    buffer_ = new char[size * getType().getSize() + Alignment];
+    size_t misalignment = reinterpret_cast<size_t>(buffer_) % Alignment;
+    data_ = buffer_ + (misalignment ? Alignment - misalignment : 0);
+    size_ = size;
+}
+
+
+void* Column::getData()
+{
+    return data_;
+}
+
+
+const void* Column::getData() const
+{
+    return data_;
+}
+
+
+Column::~Column()
+{
+    delete[] buffer_;
+}
+
+
+void xm::gather(const Class& clazz,
+                const void* objects,
+                size_t count,
+                Column& column)
+{
+    const Property& property = column.getProperty();
+    ptrdiff_t offset = getFieldOffset(clazz, property);
+    size_t size = column.getType().getSize();
+    size_t stride = clazz.getSize();
+    const char* src = static_cast<const char*>(objects);
+    
+    column.resize(count);
+    char* dst = static_cast<char*>(column.getData());
+    
+    if (offset >= 0)
+    {
+        gatherField(src + offset, stride, size, count, dst);
+        return;
+    }
+    
+    for (size_t i = 0; i < count; i++)
+    {
+        Variant self(const_cast<char*>(src + i * stride), clazz, 0);
+        Variant value = property.getData(self);
+        memcpy(dst + i * size, value.getAddress(), size);
+    }
+}
+
+
+void xm::scatter(const Column& column,
+                 const Class& clazz,
+                 void* objects,
+                 size_t count)
+{
+    const Property& property = column.getProperty();
+    ptrdiff_t offset = getFieldOffset(clazz, property);
+    size_t size = column.getType().getSize();
+    size_t stride = clazz.getSize();
+    const char* src = static_cast<const char*>(column.getData());
+    char* dst = static_cast<char*>(objects);
+    
+    if (count > column.getSize())
+        count = column.getSize();
+    
+    // fields are written directly, then the change of each instance is
+    // reported to the trackers as Property::setData() would
+    if (offset >= 0)
+    {
+        scatterField(src, size, count, dst + offset, stride);
+        ChangeTracker::notifySet(dst, stride, count, property);
+        return;
+    }
+    
+    for (size_t i = 0; i < count; i++)
+    {
+        Variant self(dst + i * stride, clazz, 0);
+        Variant value(const_cast<char*>(src + i * size), column.getType(), 0);
+        property.setData(self, value);
+    }
+}
@@ -38,7 +38,8 @@ using namespace std;
 
 CompoundClass::CompoundClass(const std::string& name,
                              const Namespace& name_space)
-    : Item(name, name_space), Class(name, name_space)
+    : Item(name, name_space), Class(name, name_space), sequence_(NULL),
+      associative_(NULL)
 {}
 
 
@@ -66,7 +67,9 @@ CompoundClass::CompoundClass
         destructor,
         isAbstract
     ),
-    tempjate_(&tempjate)
+    tempjate_(&tempjate),
+    sequence_(NULL),
+    associative_(NULL)
 {
 }
 
@@ -99,3 +102,36 @@ const TemplArg_Vector& CompoundClass::getTemplateArgs() const
 {
     return templateArgs_;
 }
+
+
+const Sequence* CompoundClass::getSequence() const
+{
+    return sequence_;
+}
+
+
+void CompoundClass::setSequence(const Sequence& sequence)
+{
+    delete sequence_;
+    sequence_ = &sequence;
+}
+
+
+const Associative* CompoundClass::getAssociative() const
+{
+    return associative_;
+}
+
+
+void CompoundClass::setAssociative(const Associative& associative)
+{
+    delete associative_;
+    associative_ = &associative;
+}
+
+
+CompoundClass::~CompoundClass()
+{
+    delete sequence_;
+    delete associative_;
+}
@@ -33,40 +33,438 @@
 #include <XM/xMirror.hpp>
 #include <XM/Exceptions/EnumKeyNotFoundException.hpp>
 
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+
 using namespace xm;
 using namespace std;
 
 
+namespace {
+
+// FNV-1a hash of a key, perturbed by the seed of the key table.
+unsigned long long hashKey(const char* key, size_t length,
+        unsigned long long seed)
+{
+    unsigned long long hash = 14695981039346656037ULL
+            ^ (seed * 0x9E3779B97F4A7C15ULL);
+    for (size_t i = 0; i < length; i++)
+    {
+        hash ^= static_cast<unsigned char>(key[i]);
+        hash *= 1099511628211ULL;
+    }
+    return hash ^ (hash >> 29);
+}
+
+
+typedef pair<long long, const string*> ValueKey;
+
+
+// The slot of a key in the table of the given size, from the hash of the key
+// and the displacement of its bucket.
+size_t getKeySlot(unsigned long long hash, uint32_t displacement, size_t size)
+{
+    return (hash + displacement * ((hash >> 32) | 1)) & (size - 1);
+}
+
+
+// The bucket of a key, from the hash of the key.
+size_t getKeyBucket(unsigned long long hash, size_t buckets)
+{
+    return (hash >> 40) & (buckets - 1);
+}
+
+
+typedef pair<unsigned long long, ValueKey> HashedKey;
+typedef vector<HashedKey> Bucket;
+
+
+// Orders the indexes of buckets by decreasing size.
+struct LargerBucket
+{
+    explicit LargerBucket(const vector<Bucket>& buckets) : buckets(buckets)
+    {
+    }
+    
+    bool operator()(size_t lhs, size_t rhs) const
+    {
+        return buckets[lhs].size() > buckets[rhs].size();
+    }
+    
+    const vector<Bucket>& buckets;
+};
+
+
+// Put the keys of a bucket in the slots given by a displacement, if they are
+// free and distinct, otherwise leave the slots unchanged.
+bool placeBucket(const Bucket& bucket,
+                 uint32_t displacement,
+                 vector<ValueKey>& slots)
+{
+    size_t i = 0;
+    for (; i < bucket.size(); i++)
+    {
+        size_t slot = getKeySlot(bucket[i].first, displacement, slots.size());
+        if (slots[slot].second)
+            break;
+        slots[slot] = bucket[i].second;
+    }
+    if (i == bucket.size())
+        return true;
+    
+    // undo the keys placed so far
+    while (i > 0)
+    {
+        i--;
+        slots[getKeySlot(bucket[i].first, displacement, slots.size())] =
+                ValueKey(0, NULL);
+    }
+    return false;
+}
+
+
+// Guards the building of the lookup tables of all the enumerations.
+mutex& getTablesMutex()
+{
+    static mutex tablesMutex;
+    return tablesMutex;
+}
+
+
+bool lessValue(const ValueKey& lhs, const ValueKey& rhs)
+{
+    return lhs.first < rhs.first;
+}
+
+
+bool isSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+
+bool parseNumber(const char* text, size_t length, long long& value)
+{
+    string number(text, length);
+    char* end = NULL;
+    errno = 0;
+    long long result = strtoll(number.c_str(), &end, 0);
+    if (number.empty() || *end != '\0' || errno)
+        return false;
+    value = result;
+    return true;
+}
+
+} // namespace
+
+
 Enum::Enum(const string& uName, const Namespace& name_space)
-    : Item(uName, name_space)
+    : Item(uName, name_space),
+      tablesBuilt_(false),
+      keySeed_(0),
+      denseMin_(0),
+      flags_(false),
+      signed_(true)
 {
 }
 
 
 Enum::Enum(const string& uName)
-    : Item(uName)
+    : Item(uName),
+      tablesBuilt_(false),
+      keySeed_(0),
+      denseMin_(0),
+      flags_(false),
+      signed_(true)
 {
 }
 
 
-const map<string, int>& Enum::getValues() const
+const map<string, long long>& Enum::getValues() const
 {
     return values_;
 }
 
 
-int Enum::getValue(const std::string& enumKey) const
+long long Enum::getValue(const std::string& enumKey) const
 {
-    map<string, int>::const_iterator ite = values_.find(enumKey);
-    if (ite == values_.end())
+    long long value;
+    if (!tryGetValue(enumKey, value))
         throw EnumKeyNotFoundException(*this, enumKey);
-    else
-        return ite->second;
+    return value;
+}
+
+
+bool Enum::tryGetValue(const string& enumKey, long long& value) const
+{
+    return tryGetValue(enumKey.data(), enumKey.size(), value);
+}
+
+
+bool Enum::tryGetValue(const char* enumKey, size_t length, long long& value)
+        const
+{
+    size_t slot;
+    if (!findSlot(enumKey, length, slot))
+        return false;
+    value = keySlots_[slot].first;
+    return true;
+}
+
+
+bool Enum::findSlot(const char* enumKey, size_t length, size_t& slot) const
+{
+    prepareTables();
+    if (keySlots_.empty())
+        return false;
+    
+    // a single probe: keys never collide in the table
+    unsigned long long hash = hashKey(enumKey, length, keySeed_);
+    uint32_t displacement =
+            displacements_[getKeyBucket(hash, displacements_.size())];
+    slot = getKeySlot(hash, displacement, keySlots_.size());
+    const string* key = keySlots_[slot].second;
+    return key && key->size() == length
+            && key->compare(0, length, enumKey, length) == 0;
+}
+
+
+const string* Enum::findKey(long long value) const
+{
+    prepareTables();
+    if (!denseKeys_.empty())
+    {
+        unsigned long long index = static_cast<unsigned long long>(value)
+                - static_cast<unsigned long long>(denseMin_);
+        if (value < denseMin_ || index >= denseKeys_.size())
+            return NULL;
+        return denseKeys_[index];
+    }
+    
+    vector<ValueKey>::const_iterator ite = lower_bound(sortedKeys_.begin(),
+            sortedKeys_.end(), ValueKey(value, NULL), lessValue);
+    if (ite == sortedKeys_.end() || ite->first != value)
+        return NULL;
+    return ite->second;
+}
+
+
+string Enum::format(long long value) const
+{
+    const string* key = findKey(value);
+    if (key)
+        return *key;
+    
+    char number[24];
+    if (!flags_ || value == 0)
+    {
+        sprintf(number, "%lld", value);
+        return number;
+    }
+    
+    // compose the value from the keys of its bits, findKey() built the
+    // tables
+    string text;
+    unsigned long long bits = value;
+    unsigned long long remaining = bits;
+    for (size_t i = 0; i < sortedKeys_.size(); i++)
+    {
+        unsigned long long flag = sortedKeys_[i].first;
+        if (flag != 0 && (bits & flag) == flag && (remaining & flag))
+        {
+            if (!text.empty())
+                text += '|';
+            text += *sortedKeys_[i].second;
+            remaining &= ~flag;
+        }
+    }
+    if (remaining)
+    {
+        if (!text.empty())
+            text += '|';
+        sprintf(number, "%llu", remaining);
+        text += number;
+    }
+    return text;
+}
+
+
+bool Enum::parse(const string& text, long long& value) const
+{
+    return parse(text.data(), text.size(), value);
+}
+
+
+bool Enum::parse(const char* text, size_t length, long long& value) const
+{
+    long long result = 0;
+    size_t start = 0;
+    while (true)
+    {
+        size_t end = start;
+        while (end < length && text[end] != '|')
+            end++;
+        if (end < length && !flags_)
+            return false;
+        
+        // trim the token
+        size_t first = start;
+        size_t last = end;
+        while (first < last && isSpace(text[first]))
+            first++;
+        while (last > first && isSpace(text[last - 1]))
+            last--;
+        
+        long long token;
+        if (!tryGetValue(text + first, last - first, token)
+                && !parseNumber(text + first, last - first, token))
+            return false;
+        result |= token;
+        
+        if (end == length)
+            break;
+        start = end + 1;
+    }
+    value = result;
+    return true;
+}
+
+
+bool Enum::isFlags() const
+{
+    return flags_;
+}
+
+
+Enum& Enum::setFlags(bool flags)
+{
+    flags_ = flags;
+    return *this;
+}
+
+
+bool Enum::isSigned() const
+{
+    return signed_;
+}
+
+
+Enum& Enum::setSigned(bool isSigned)
+{
+    signed_ = isSigned;
+    return *this;
 }
 
 
-Enum& Enum::addValue(const std::string& enumKey, int val)
+Enum& Enum::addValue(const std::string& enumKey, long long val)
 {
-    values_.insert(make_pair(enumKey, val));
+    lock_guard<mutex> lock(getTablesMutex());
+    if (values_.insert(make_pair(enumKey, val)).second)
+        tablesBuilt_.store(false, memory_order_release);
     return *this;
 }
+
+
+void Enum::prepareTables() const
+{
+    if (tablesBuilt_.load(memory_order_acquire))
+        return;
+    
+    lock_guard<mutex> lock(getTablesMutex());
+    if (!tablesBuilt_.load(memory_order_relaxed))
+    {
+        buildTables();
+        tablesBuilt_.store(true, memory_order_release);
+    }
+}
+
+
+void Enum::buildTables() const
+{
+    // values, sorted, with the first key bound to each of them
+    sortedKeys_.clear();
+    keySlots_.clear();
+    displacements_.clear();
+    denseKeys_.clear();
+    if (values_.empty())
+        return;
+    
+    map<string, long long>::const_iterator ite;
+    for (ite = values_.begin(); ite != values_.end(); ite++)
+        sortedKeys_.push_back(ValueKey(ite->second, &ite->first));
+    stable_sort(sortedKeys_.begin(), sortedKeys_.end(), lessValue);
+    
+    // a directly indexed table when the range of values is narrow
+    long long minValue = sortedKeys_.front().first;
+    unsigned long long range =
+            static_cast<unsigned long long>(sortedKeys_.back().first)
+            - static_cast<unsigned long long>(minValue) + 1;
+    if (range != 0 && range <= 4 * sortedKeys_.size() + 16)
+    {
+        denseMin_ = minValue;
+        denseKeys_.assign(range, NULL);
+        for (size_t i = sortedKeys_.size(); i > 0; i--)
+        {
+            const ValueKey& valueKey = sortedKeys_[i - 1];
+            unsigned long long index =
+                    static_cast<unsigned long long>(valueKey.first)
+                    - static_cast<unsigned long long>(minValue);
+            denseKeys_[index] = valueKey.second;
+        }
+    }
+    
+    // hash and displace: the keys are split into buckets of about four
+    // keys, then, from the largest bucket, each bucket gets the first
+    // displacement that puts its keys in free slots. The table is at least
+    // twice the number of keys, if a bucket cannot be placed the keys are
+    // hashed again with another seed.
+    size_t size = 1;
+    while (size < 2 * values_.size())
+        size *= 2;
+    size_t buckets = 1;
+    while (buckets * 4 < values_.size())
+        buckets *= 2;
+    
+    for (unsigned long long seed = 0; ; seed++)
+    {
+        vector<Bucket> bucketKeys(buckets);
+        for (ite = values_.begin(); ite != values_.end(); ite++)
+        {
+            const string& key = ite->first;
+            unsigned long long hash = hashKey(key.data(), key.size(), seed);
+            bucketKeys[getKeyBucket(hash, buckets)].push_back(
+                    HashedKey(hash, ValueKey(ite->second, &key)));
+        }
+        
+        vector<size_t> order(buckets);
+        for (size_t i = 0; i < buckets; i++)
+            order[i] = i;
+        stable_sort(order.begin(), order.end(), LargerBucket(bucketKeys));
+        
+        keySlots_.assign(size, ValueKey(0, NULL));
+        displacements_.assign(buckets, 0);
+        bool placed = true;
+        for (size_t i = 0; i < buckets && placed; i++)
+        {
+            const Bucket& bucket = bucketKeys[order[i]];
+            if (bucket.empty())
+                break;
+            placed = false;
+            for (uint32_t displacement = 0;
+                    displacement < 4 * size && !placed; displacement++)
+            {
+                placed = placeBucket(bucket, displacement, keySlots_);
+                if (placed)
+                    displacements_[order[i]] = displacement;
+            }
+        }
+        if (placed)
+        {
+            keySeed_ = seed;
+            break;
+        }
+    }
+}
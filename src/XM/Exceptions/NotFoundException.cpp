@@ -33,59 +33,109 @@
 #include <XM/xMirror.hpp>
 #include <XM/Exceptions/NotFoundException.hpp>
 
+#include <cstring>
+
 using namespace std;
 using namespace xm;
 
 
+namespace {
+
+void copyKey(char* key, size_t size, const string& name)
+{
+    size_t length = name.copy(key, size - 1);
+    key[length] = '\0';
+    if (length < name.size() && size > 4)
+        strcpy(key + size - 4, "...");
+}
+
+
+const char* getCategoryName(Item::Category category, bool isClass)
+{
+    switch (category)
+    {
+        case Item::NamespaceItem: return "Namespace";
+        case Item::TypeItem: return isClass ? "Class" : "Type";
+        case Item::TemplateItem: return "Template";
+        case Item::FunctionItem: return "Function";
+        case Item::PropertyItem: return "Property";
+        case Item::MethodItem: return "Method";
+        default: return "Item";
+    }
+}
+
+} // namespace
+
+
 NotFoundException::NotFoundException(const Namespace& name_space,
                                      const Item& item) throw()
+    : namespace_(&name_space),
+      cppType_(NULL),
+      category_(item.getItemCategory()),
+      isClass_(false),
+      isSignature_(false)
 {
-    string nsCategory;
-    if (dynamic_cast<const Class*>(&name_space))
-        nsCategory = "Class";
-    else
-        nsCategory = "Namespace";
-
-    string itemCategory;
-    const Method* method = NULL;
-    if (dynamic_cast<const Class*>(&item))
-        itemCategory = "Class";
-    else if (dynamic_cast<const Namespace*>(&item))
-        itemCategory = "Namespace";
-    else if (dynamic_cast<const Property*>(&item))
-        itemCategory = "Property";
-    else if (dynamic_cast<const Method*>(&item))
+    if (category_ == Item::TypeItem)
+        isClass_ = dynamic_cast<const Class*>(&item) != NULL;
+    
+    // methods looked up by signature are rare, their signature is the only
+    // part of the key that has to be built
+    if (category_ == Item::MethodItem)
     {
-        itemCategory = "Method";
-        method = dynamic_cast<const Method*>(&item);
+        const Method& method = dynamic_cast<const Method&>(item);
+        isSignature_ = method.hasFullSignature();
+        if (isSignature_)
+        {
+            copyKey(key_, sizeof(key_), method.getSignature());
+            return;
+        }
     }
-    else if (dynamic_cast<const Function*>(&item))
-        itemCategory = "Function";
-    else if (dynamic_cast<const Type*>(&item))
-        itemCategory = "Type";
-
-    msg = nsCategory + " " + name_space.getName() + " has no " +
-          itemCategory;
-
-    if (!method || !method->hasFullSignature())
-        msg += " with name " + item.getUnqualifiedName();
-    else
-        msg += " with signature " + method->getSignature();
+    copyKey(key_, sizeof(key_), item.getUnqualifiedName());
 }
 
 
 NotFoundException::NotFoundException(const type_info& cppType) throw()
+    : namespace_(NULL),
+      cppType_(&cppType),
+      category_(Item::TypeItem),
+      isClass_(false),
+      isSignature_(false)
 {
-    msg = "Cannot find Type with id ";
-    msg += cppType.name();
+    key_[0] = '\0';
 }
 
 
 const char* NotFoundException::what() const throw()
 {
+    if (!msg.empty())
+        return msg.c_str();
+    
+    try
+    {
+        if (cppType_)
+        {
+            msg = "Cannot find Type with id ";
+            msg += cppType_->name();
+        }
+        else
+        {
+            msg = dynamic_cast<const Class*>(namespace_) ? "Class "
+                    : "Namespace ";
+            msg += namespace_->getName();
+            msg += " has no ";
+            msg += getCategoryName(category_, isClass_);
+            msg += isSignature_ ? " with signature " : " with name ";
+            msg += key_;
+        }
+    }
+    catch (...)
+    {
+        return "Item not found";
+    }
     return msg.c_str();
 }
 
+
 NotFoundException::~NotFoundException() throw()
 {
 }
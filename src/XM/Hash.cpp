@@ -0,0 +1,411 @@
+/******************************************************************************      
+ *      Extended Mirror: Hash.cpp                                             *
+ ******************************************************************************
+ *      Copyright (c) 2012-2015, Manuele Finocchiaro                          *
+ *      All rights reserved.                                                  *
+ ******************************************************************************
+ * Redistribution and use in source and binary forms, with or without         *
+ * modification, are permitted provided that the following conditions         *
+ * are met:                                                                   *
+ *                                                                            *
+ *    1. Redistributions of source code must retain the above copyright       *
+ *       notice, this list of conditions and the following disclaimer.        *
+ *                                                                            *
+ *    2. Redistributions in binary form must reproduce the above copyright    *
+ *       notice, this list of conditions and the following disclaimer in      *
+ *       the documentation and/or other materials provided with the           *
+ *       distribution.                                                        *
+ *                                                                            *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"* 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE  *
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE *
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE  *
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR        *
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF       *
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS   *
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN    *
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)    *
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF     *
+ * THE POSSIBILITY OF SUCH DAMAGE.                                            *
+ *****************************************************************************/
+
+
+#include <XM/xMirror.hpp>
+#include <XM/Hash.hpp>
+
+#include <cstring>
+
+using namespace std;
+using namespace xm;
+
+
+namespace {
+
+const uint64_t hashSeed = 0x9E3779B97F4A7C15ULL;
+const uint64_t hashPrime1 = 0x87C37B91114253D5ULL;
+const uint64_t hashPrime2 = 0x4CF5AD432745937FULL;
+
+
+inline uint64_t rotate(uint64_t value, int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+
+inline uint64_t mixWord(uint64_t hash, uint64_t word)
+{
+    word *= hashPrime1;
+    word = rotate(word, 31);
+    word *= hashPrime2;
+    hash ^= word;
+    return rotate(hash, 27) * 5 + 0x52DCE729;
+}
+
+
+// Hash a block of memory eight bytes at a time.
+uint64_t hashBlock(uint64_t hash, const char* data, size_t size)
+{
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8)
+    {
+        uint64_t word;
+        memcpy(&word, data + i, 8);
+        hash = mixWord(hash, word);
+    }
+    
+    if (i < size)
+    {
+        uint64_t word = 0;
+        memcpy(&word, data + i, size - i);
+        hash = mixWord(hash, word ^ (uint64_t(size - i) << 56));
+    }
+    return hash;
+}
+
+
+uint64_t hashData(uint64_t hash, const char* data, const Type& type);
+
+
+uint64_t hashObject(uint64_t hash, const char* obj, const Class& clazz)
+{
+    const ClassLayout& layout = clazz.getLayout();
+    const ClassLayout::Field_Vector& fields = layout.getFields();
+    const ClassLayout::Run_Vector& runs = layout.getRuns();
+    
+    size_t run = 0;
+    size_t i = 0;
+    while (i < fields.size())
+    {
+        if (run < runs.size() && runs[run].firstField == i)
+        {
+            hash = hashBlock(hash, obj + runs[run].offset, runs[run].size);
+            i += runs[run].fieldCount;
+            run ++;
+            continue;
+        }
+        
+        const ClassLayout::Field& field = fields[i];
+        if (field.offset >= 0)
+        {
+            hash = hashData(hash, obj + field.offset,
+                    field.property->getType());
+        }
+        else
+        {
+            Variant self(const_cast<char*>(obj), clazz, 0);
+            Variant value = field.property->getData(self);
+            hash = hashData(hash, static_cast<const char*>(value.getAddress()),
+                    value.getType());
+        }
+        i ++;
+    }
+    return hash;
+}
+
+
+// Hashes the elements of an associative container. The hashes of the
+// elements are summed, as hashed containers holding the same elements may
+// visit them in different orders.
+class ElementHasher : public Associative::Visitor
+{
+public:
+    ElementHasher(const Associative& associative)
+        : associative_(associative), sum_(0) {}
+    
+    void visit(const Variant& key, const Variant& mapped)
+    {
+        uint64_t hash = hashData(hashSeed,
+                static_cast<const char*>(key.getAddress()),
+                associative_.getKeyType());
+        if (associative_.getMappedType())
+            hash = hashData(hash, static_cast<const char*>(mapped.getAddress()),
+                    *associative_.getMappedType());
+        sum_ += rotate(hash, 17) * hashPrime1;
+    }
+    
+    uint64_t getSum() const
+    {
+        return sum_;
+    }
+    
+private:
+    const Associative& associative_;
+    uint64_t sum_;
+};
+
+
+// Containers are hashed through their size and elements, the other compound
+// classes through their properties.
+uint64_t hashCompound(uint64_t hash, const char* data,
+        const CompoundClass& clazz)
+{
+    Variant self(const_cast<char*>(data), clazz, Variant::Const);
+    const Sequence* sequence = clazz.getSequence();
+    const Associative* associative = clazz.getAssociative();
+    if (sequence)
+    {
+        const Type& elementType = sequence->getElementType();
+        size_t count = sequence->getSize(self);
+        hash = mixWord(hash, count);
+        if (count && sequence->isContiguous()
+                && ClassLayout::isPlainData(elementType))
+            return hashBlock(hash,
+                    static_cast<const char*>(sequence->getData(self)),
+                    count * elementType.getSize());
+        
+        for (size_t i = 0; i < count; i++)
+            hash = hashData(hash, static_cast<const char*>(
+                    sequence->at(self, i).getAddress()), elementType);
+        return hash;
+    }
+    if (associative)
+    {
+        ElementHasher hasher(*associative);
+        associative->forEach(self, hasher);
+        hash = mixWord(hash, associative->getSize(self));
+        return mixWord(hash, hasher.getSum());
+    }
+    return hashObject(hash, data, clazz);
+}
+
+
+uint64_t hashData(uint64_t hash, const char* data, const Type& type)
+{
+    if (ClassLayout::isPlainData(type))
+        return hashBlock(hash, data, type.getSize());
+    
+    switch (type.getCategory())
+    {
+        case Type::Array:
+        {
+            const ArrayType& arrayType = dynamic_cast<const ArrayType&>(type);
+            const Type& elementType = arrayType.getArrayElementType();
+            for (size_t i = 0; i < arrayType.getArraySize(); i++)
+                hash = hashData(hash, data + i * elementType.getSize(),
+                        elementType);
+            return hash;
+        }
+            
+        case Type::Class:
+            return hashObject(hash, data, dynamic_cast<const Class&>(type));
+            
+        case Type::CompoundClass:
+            return hashCompound(hash, data,
+                    dynamic_cast<const CompoundClass&>(type));
+            
+        case Type::String:
+        {
+            const string& str = *reinterpret_cast<const string*>(data);
+            return hashBlock(hash, str.data(), str.size());
+        }
+            
+        default:
+            // pointers are not hashed
+            return hash;
+    }
+}
+
+
+bool equalObjects(const char* obj1, const char* obj2, const Class& clazz)
+{
+    const ClassLayout& layout = clazz.getLayout();
+    const ClassLayout::Field_Vector& fields = layout.getFields();
+    const ClassLayout::Run_Vector& runs = layout.getRuns();
+    
+    size_t run = 0;
+    size_t i = 0;
+    while (i < fields.size())
+    {
+        if (run < runs.size() && runs[run].firstField == i)
+        {
+            if (memcmp(obj1 + runs[run].offset, obj2 + runs[run].offset,
+                    runs[run].size) != 0)
+                return false;
+            i += runs[run].fieldCount;
+            run ++;
+            continue;
+        }
+        
+        const ClassLayout::Field& field = fields[i];
+        if (field.offset >= 0)
+        {
+            if (!equals(obj1 + field.offset, obj2 + field.offset,
+                    field.property->getType()))
+                return false;
+        }
+        else
+        {
+            // go through the getter
+            Variant value1 = field.property->getData(
+                    Variant(const_cast<char*>(obj1), clazz, 0));
+            Variant value2 = field.property->getData(
+                    Variant(const_cast<char*>(obj2), clazz, 0));
+            if (!equals(value1, value2))
+                return false;
+        }
+        i ++;
+    }
+    return true;
+}
+
+// Looks up the elements of an associative container in another one.
+class ElementComparer : public Associative::Visitor
+{
+public:
+    ElementComparer(const Associative& associative, const Variant& other)
+        : associative_(associative), other_(other), equal_(true) {}
+    
+    void visit(const Variant& key, const Variant& mapped)
+    {
+        if (!equal_)
+            return;
+        
+        Variant found = associative_.find(other_, key);
+        if (&found.getType() == &Variant::Void.getType())
+            equal_ = false;
+        else if (associative_.getMappedType())
+            equal_ = equals(mapped.getAddress(), found.getAddress(),
+                    *associative_.getMappedType());
+    }
+    
+    bool isEqual() const
+    {
+        return equal_;
+    }
+    
+private:
+    const Associative& associative_;
+    const Variant& other_;
+    bool equal_;
+};
+
+
+bool equalCompounds(const char* obj1, const char* obj2,
+        const CompoundClass& clazz)
+{
+    Variant self1(const_cast<char*>(obj1), clazz, Variant::Const);
+    Variant self2(const_cast<char*>(obj2), clazz, Variant::Const);
+    const Sequence* sequence = clazz.getSequence();
+    const Associative* associative = clazz.getAssociative();
+    if (sequence)
+    {
+        const Type& elementType = sequence->getElementType();
+        size_t count = sequence->getSize(self1);
+        if (count != sequence->getSize(self2))
+            return false;
+        if (count && sequence->isContiguous()
+                && ClassLayout::isPlainData(elementType))
+            return memcmp(sequence->getData(self1), sequence->getData(self2),
+                    count * elementType.getSize()) == 0;
+        
+        for (size_t i = 0; i < count; i++)
+        {
+            if (!equals(sequence->at(self1, i).getAddress(),
+                    sequence->at(self2, i).getAddress(), elementType))
+                return false;
+        }
+        return true;
+    }
+    if (associative)
+    {
+        if (associative->getSize(self1) != associative->getSize(self2))
+            return false;
+        ElementComparer comparer(*associative, self2);
+        associative->forEach(self1, comparer);
+        return comparer.isEqual();
+    }
+    return equalObjects(obj1, obj2, clazz);
+}
+
+} // namespace
+
+
+size_t xm::hashOf(const void* data, const Type& type)
+{
+    uint64_t hash = hashData(hashSeed, static_cast<const char*>(data), type);
+    
+    // final avalanche
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDULL;
+    hash ^= hash >> 33;
+    return static_cast<size_t>(hash);
+}
+
+
+size_t xm::hashOf(const Variant& value)
+{
+    return hashOf(value.getAddress(), value.getType());
+}
+
+
+bool xm::equals(const void* data1, const void* data2, const Type& type)
+{
+    if (data1 == data2)
+        return true;
+    
+    const char* bytes1 = static_cast<const char*>(data1);
+    const char* bytes2 = static_cast<const char*>(data2);
+    
+    if (ClassLayout::isPlainData(type))
+        return memcmp(bytes1, bytes2, type.getSize()) == 0;
+    
+    switch (type.getCategory())
+    {
+        case Type::Array:
+        {
+            const ArrayType& arrayType = dynamic_cast<const ArrayType&>(type);
+            const Type& elementType = arrayType.getArrayElementType();
+            for (size_t i = 0; i < arrayType.getArraySize(); i++)
+            {
+                size_t offset = i * elementType.getSize();
+                if (!equals(bytes1 + offset, bytes2 + offset, elementType))
+                    return false;
+            }
+            return true;
+        }
+            
+        case Type::Class:
+            return equalObjects(bytes1, bytes2,
+                    dynamic_cast<const Class&>(type));
+            
+        case Type::CompoundClass:
+            return equalCompounds(bytes1, bytes2,
+                    dynamic_cast<const CompoundClass&>(type));
+            
+        case Type::String:
+            return *reinterpret_cast<const string*>(bytes1)
+                    == *reinterpret_cast<const string*>(bytes2);
+            
+        default:
+            // pointers are not compared
+            return true;
+    }
+}
+
+
+bool xm::equals(const Variant& value1, const Variant& value2)
+{
+    if (&value1.getType() != &value2.getType())
+        return false;
+    return equals(value1.getAddress(), value2.getAddress(), value1.getType());
+}
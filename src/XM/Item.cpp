@@ -107,6 +107,18 @@ bool Item::before_(const Item& item) const
 }
 
 
+void* Item::operator new(size_t size)
+{
+    return allocateMetadata(size);
+}
+
+
+void Item::operator delete(void* ptr)
+{
+    releaseMetadata(ptr);
+}
+
+
 Item::~Item()
 {
 }
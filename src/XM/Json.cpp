@@ -0,0 +1,1234 @@
+/******************************************************************************      
+ *      Extended Mirror: Json.cpp                                             *
+ ******************************************************************************
+ *      Copyright (c) 2012-2015, Manuele Finocchiaro                          *
+ *      All rights reserved.                                                  *
+ ******************************************************************************
+ * Redistribution and use in source and binary forms, with or without         *
+ * modification, are permitted provided that the following conditions         *
+ * are met:                                                                   *
+ *                                                                            *
+ *    1. Redistributions of source code must retain the above copyright       *
+ *       notice, this list of conditions and the following disclaimer.        *
+ *                                                                            *
+ *    2. Redistributions in binary form must reproduce the above copyright    *
+ *       notice, this list of conditions and the following disclaimer in      *
+ *       the documentation and/or other materials provided with the           *
+ *       distribution.                                                        *
+ *                                                                            *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"* 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE  *
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE *
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE  *
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR        *
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF       *
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS   *
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN    *
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)    *
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF     *
+ * THE POSSIBILITY OF SUCH DAMAGE.                                            *
+ *****************************************************************************/
+
+
+#include <XM/xMirror.hpp>
+#include <XM/Json.hpp>
+#include <XM/Exceptions/EnumKeyNotFoundException.hpp>
+#include <XM/Exceptions/SerializationException.hpp>
+#include <XM/Exceptions/PropertyRangeException.hpp>
+#include <XM/Exceptions/VariantCostnessException.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using namespace std;
+using namespace xm;
+
+
+namespace {
+
+template<typename T>
+T load(const char* data)
+{
+    T value;
+    memcpy(&value, data, sizeof(T));
+    return value;
+}
+
+
+template<typename T>
+void store(char* data, T value)
+{
+    memcpy(data, &value, sizeof(T));
+}
+
+
+// Enumerations are stored as integers of the size and signedness of their
+// underlying type.
+long long loadEnum(const char* data, size_t size, bool isSigned)
+{
+    switch (size)
+    {
+        case 1: return isSigned ? load<signed char>(data) : load<uchar>(data);
+        case 2: return isSigned ? load<short>(data) : load<ushort>(data);
+        case 8: return load<long long>(data);
+        default: return isSigned ? load<int>(data) : load<uint>(data);
+    }
+}
+
+
+void storeEnum(char* data, size_t size, long long value)
+{
+    switch (size)
+    {
+        case 1: store<signed char>(data, value); break;
+        case 2: store<short>(data, value); break;
+        case 8: store<long long>(data, value); break;
+        default: store<int>(data, value); break;
+    }
+}
+
+
+// Store the integer of the given sign and magnitude, if it fits in T.
+template<typename T>
+bool storeInteger(char* data, bool negative, unsigned long long magnitude)
+{
+    if (negative && magnitude > 0)
+    {
+        if (!numeric_limits<T>::is_signed
+            || magnitude - 1 > static_cast<unsigned long long>(
+                    -(numeric_limits<T>::min() + 1)))
+            return false;
+        store<T>(data, static_cast<T>(
+                -static_cast<long long>(magnitude - 1) - 1));
+    }
+    else
+    {
+        if (magnitude > static_cast<unsigned long long>(
+                numeric_limits<T>::max()))
+            return false;
+        store<T>(data, static_cast<T>(magnitude));
+    }
+    return true;
+}
+
+
+// Store the integer of the given sign and magnitude as an enumeration value,
+// if it fits in the underlying type.
+bool storeEnumInteger(char* data, size_t size, bool isSigned, bool negative,
+                      unsigned long long magnitude)
+{
+    switch (size)
+    {
+        case 1:
+            return isSigned
+                    ? storeInteger<signed char>(data, negative, magnitude)
+                    : storeInteger<uchar>(data, negative, magnitude);
+        case 2:
+            return isSigned ? storeInteger<short>(data, negative, magnitude)
+                    : storeInteger<ushort>(data, negative, magnitude);
+        case 8:
+            return isSigned
+                    ? storeInteger<long long>(data, negative, magnitude)
+                    : storeInteger<unsigned long long>(data, negative,
+                                                       magnitude);
+        default:
+            return isSigned ? storeInteger<int>(data, negative, magnitude)
+                    : storeInteger<uint>(data, negative, magnitude);
+    }
+}
+
+
+bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+
+// Append the UTF-8 encoding of a code point.
+void appendUtf8(string& str, unsigned long code)
+{
+    if (code < 0x80)
+        str += static_cast<char>(code);
+    else if (code < 0x800)
+    {
+        str += static_cast<char>(0xC0 | (code >> 6));
+        str += static_cast<char>(0x80 | (code & 0x3F));
+    }
+    else if (code < 0x10000)
+    {
+        str += static_cast<char>(0xE0 | (code >> 12));
+        str += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        str += static_cast<char>(0x80 | (code & 0x3F));
+    }
+    else
+    {
+        str += static_cast<char>(0xF0 | (code >> 18));
+        str += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+        str += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        str += static_cast<char>(0x80 | (code & 0x3F));
+    }
+}
+
+} // namespace
+
+
+// Writes the elements of an associative container: the keys and their
+// mapped values as the members of a JSON object if the keys are strings, else
+// as the elements of a JSON array.
+class JsonWriter::ElementWriter : public Associative::Visitor
+{
+public:
+    ElementWriter(JsonWriter& writer, const Associative& associative)
+        : writer_(writer), associative_(associative), first_(true) {}
+    
+    void visit(const Variant& key, const Variant& mapped)
+    {
+        const Type& keyType = associative_.getKeyType();
+        const Type* mappedType = associative_.getMappedType();
+        if (!first_)
+            writer_.put(',');
+        first_ = false;
+        
+        if (mappedType && keyType.getCategory() != Type::String)
+            writer_.put('[');
+        writer_.writeData(static_cast<const char*>(key.getAddress()),
+                keyType);
+        if (mappedType)
+        {
+            writer_.put(keyType.getCategory() == Type::String ? ':' : ',');
+            writer_.writeData(static_cast<const char*>(mapped.getAddress()),
+                    *mappedType);
+            if (keyType.getCategory() != Type::String)
+                writer_.put(']');
+        }
+    }
+    
+private:
+    JsonWriter& writer_;
+    const Associative& associative_;
+    bool first_;
+};
+
+
+JsonWriter::JsonWriter(OutStream& out)
+    : out_(&out), size_(0)
+{
+}
+
+
+void JsonWriter::write(const Variant& object)
+{
+    const Class* clazz = dynamic_cast<const Class*>(&object.getType());
+    if (!clazz)
+        throw SerializationException("Cannot write non class type "
+                + object.getType().getName() + " as a JSON object");
+    
+    // the objects being written, to detect cyclic pointers
+    pointed_.clear();
+    pointed_.push_back(object.getAddress());
+    
+    writeObject(static_cast<const char*>(object.getAddress()), *clazz);
+    flush();
+}
+
+
+void JsonWriter::writeData(const char* data, const Type& type)
+{
+    char number[32];
+    int length = 0;
+    
+    switch (type.getCategory())
+    {
+        case Type::Primitive:
+        {
+            const PrimitiveType& primitive =
+                    dynamic_cast<const PrimitiveType&>(type);
+            
+            // enumeration values are written as their names, flag sets as
+            // the names of their flags
+            const Enum* xmEnum = primitive.getEnum();
+            if (xmEnum)
+            {
+                long long value = loadEnum(data, type.getSize(),
+                        xmEnum->isSigned());
+                const string* key = xmEnum->findKey(value);
+                if (key)
+                    writeString(key->data(), key->size());
+                else if (xmEnum->isFlags())
+                {
+                    string text = xmEnum->format(value);
+                    writeString(text.data(), text.size());
+                }
+                else if (xmEnum->isSigned())
+                    length = sprintf(number, "%lld", value);
+                else
+                    length = sprintf(number, "%llu",
+                            static_cast<unsigned long long>(value));
+                break;
+            }
+            
+            switch (primitive.getKind())
+            {
+                case PrimitiveType::Bool:
+                    if (load<bool>(data))
+                        put("true", 4);
+                    else
+                        put("false", 5);
+                    break;
+                case PrimitiveType::Char:
+                    length = sprintf(number, "%d", load<char>(data));
+                    break;
+                case PrimitiveType::WChar:
+                    length = sprintf(number, "%ld",
+                            static_cast<long>(load<wchar_t>(data)));
+                    break;
+                case PrimitiveType::Short:
+                    length = sprintf(number, "%d", load<short>(data));
+                    break;
+                case PrimitiveType::Int:
+                    length = sprintf(number, "%d", load<int>(data));
+                    break;
+                case PrimitiveType::Long:
+                    length = sprintf(number, "%ld", load<long>(data));
+                    break;
+                case PrimitiveType::UChar:
+                    length = sprintf(number, "%u", load<uchar>(data));
+                    break;
+                case PrimitiveType::UShort:
+                    length = sprintf(number, "%u", load<ushort>(data));
+                    break;
+                case PrimitiveType::UInt:
+                    length = sprintf(number, "%u", load<uint>(data));
+                    break;
+                case PrimitiveType::ULong:
+                    length = sprintf(number, "%lu", load<ulong>(data));
+                    break;
+                case PrimitiveType::Float:
+                {
+                    float value = load<float>(data);
+                    if (isfinite(value))
+                        length = sprintf(number, "%.9g", value);
+                    else
+                        put("null", 4);
+                    break;
+                }
+                case PrimitiveType::Double:
+                {
+                    double value = load<double>(data);
+                    if (isfinite(value))
+                        length = sprintf(number, "%.17g", value);
+                    else
+                        put("null", 4);
+                    break;
+                }
+                default:
+                    put("null", 4);
+                    break;
+            }
+            break;
+        }
+            
+        case Type::Array:
+        {
+            const ArrayType& arrayType = dynamic_cast<const ArrayType&>(type);
+            const Type& elementType = arrayType.getArrayElementType();
+            put('[');
+            for (size_t i = 0; i < arrayType.getArraySize(); i++)
+            {
+                if (i > 0)
+                    put(',');
+                writeData(data + i * elementType.getSize(), elementType);
+            }
+            put(']');
+            break;
+        }
+            
+        case Type::Class:
+            writeObject(data, dynamic_cast<const Class&>(type));
+            break;
+            
+        case Type::CompoundClass:
+            writeCompound(data, dynamic_cast<const CompoundClass&>(type));
+            break;
+            
+        case Type::String:
+        {
+            const string& str = *reinterpret_cast<const string*>(data);
+            writeString(str.data(), str.size());
+            break;
+        }
+            
+        case Type::Pointer:
+        {
+            const char* pointer = load<const char*>(data);
+            const Type& pointedType =
+                    dynamic_cast<const PointerType&>(type).getPointedType();
+            const PrimitiveType* pointedPrimitive =
+                    dynamic_cast<const PrimitiveType*>(&pointedType);
+            
+            if (!pointer)
+                put("null", 4);
+            else if (pointedPrimitive
+                     && pointedPrimitive->getKind() == PrimitiveType::Char)
+                writeString(pointer, strlen(pointer));
+            else
+            {
+                if (find(pointed_.begin(), pointed_.end(), pointer)
+                        != pointed_.end())
+                    throw SerializationException("Cyclic pointer to "
+                            + pointedType.getName() + " cannot be written "
+                            "as JSON");
+                pointed_.push_back(pointer);
+                writeData(pointer, pointedType);
+                pointed_.pop_back();
+            }
+            break;
+        }
+            
+        default:
+            put("null", 4);
+            break;
+    }
+    
+    if (length > 0)
+        put(number, length);
+}
+
+
+void JsonWriter::writeObject(const char* obj, const Class& clazz)
+{
+    const ClassLayout::Field_Vector& fields = clazz.getLayout().getFields();
+    
+    put('{');
+    for (size_t i = 0; i < fields.size(); i++)
+    {
+        if (i > 0)
+            put(',');
+        
+        const Property& property = *fields[i].property;
+        const string& name = property.getUnqualifiedName();
+        writeString(name.data(), name.size());
+        put(':');
+        
+        if (fields[i].offset >= 0)
+        {
+            writeData(obj + fields[i].offset, property.getType());
+        }
+        else
+        {
+            // go through the getter
+            Variant self(const_cast<char*>(obj), clazz, 0);
+            Variant value = property.getData(self);
+            writeData(static_cast<const char*>(value.getAddress()),
+                    value.getType());
+        }
+    }
+    put('}');
+}
+
+
+void JsonWriter::writeCompound(const char* data, const CompoundClass& clazz)
+{
+    Variant self(const_cast<char*>(data), clazz, Variant::Const);
+    const Sequence* sequence = clazz.getSequence();
+    const Associative* associative = clazz.getAssociative();
+    if (sequence)
+    {
+        const Type& elementType = sequence->getElementType();
+        size_t count = sequence->getSize(self);
+        put('[');
+        for (size_t i = 0; i < count; i++)
+        {
+            if (i > 0)
+                put(',');
+            writeData(static_cast<const char*>(
+                    sequence->at(self, i).getAddress()), elementType);
+        }
+        put(']');
+    }
+    else if (associative)
+    {
+        bool object = associative->getMappedType()
+                && associative->getKeyType().getCategory() == Type::String;
+        put(object ? '{' : '[');
+        ElementWriter writer(*this, *associative);
+        associative->forEach(self, writer);
+        put(object ? '}' : ']');
+    }
+    else
+        writeObject(data, clazz);
+}
+
+
+void JsonWriter::writeString(const char* str, size_t length)
+{
+    static const char hexDigits[] = "0123456789abcdef";
+    
+    put('"');
+    size_t plain = 0;
+    for (size_t i = 0; i < length; i++)
+    {
+        unsigned char c = str[i];
+        if (c >= 0x20 && c != '"' && c != '\\')
+            continue;
+        
+        // write the characters preceding the one to escape at once
+        put(str + plain, i - plain);
+        plain = i + 1;
+        
+        put('\\');
+        switch (c)
+        {
+            case '"': put('"'); break;
+            case '\\': put('\\'); break;
+            case '\b': put('b'); break;
+            case '\f': put('f'); break;
+            case '\n': put('n'); break;
+            case '\r': put('r'); break;
+            case '\t': put('t'); break;
+            default:
+                put("u00", 3);
+                put(hexDigits[c >> 4]);
+                put(hexDigits[c & 0xF]);
+                break;
+        }
+    }
+    put(str + plain, length - plain);
+    put('"');
+}
+
+
+void JsonWriter::put(char c)
+{
+    if (size_ == sizeof(buffer_))
+        flush();
+    buffer_[size_++] = c;
+}
+
+
+void JsonWriter::put(const char* str, size_t length)
+{
+    if (sizeof(buffer_) - size_ < length)
+    {
+        flush();
+        if (length > sizeof(buffer_))
+        {
+            out_->write(str, length);
+            return;
+        }
+    }
+    memcpy(buffer_ + size_, str, length);
+    size_ += length;
+}
+
+
+void JsonWriter::flush()
+{
+    if (size_ > 0)
+        out_->write(buffer_, size_);
+    size_ = 0;
+}
+
+
+JsonReader::JsonReader(const char* data, size_t size)
+    : begin_(data),
+      end_(data + size),
+      pos_(data),
+      token_(End),
+      state_(ValueState),
+      text_(NULL),
+      textLength_(0)
+{
+}
+
+
+JsonReader::Token JsonReader::next()
+{
+    skipWhitespace();
+    
+    // after a value comes a separator or the end of the enclosing container
+    if (state_ == AfterValueState)
+    {
+        if (stack_.empty())
+            state_ = DoneState;
+        else if (pos_ != end_ && *pos_ == ',')
+        {
+            pos_ ++;
+            skipWhitespace();
+            state_ = stack_[stack_.size() - 1] == '{' ? KeyState : ValueState;
+        }
+        else
+            return closeContainer();
+    }
+    
+    if (state_ == DoneState)
+    {
+        if (pos_ != end_)
+            error("Unexpected data after the end of the document");
+        return token_ = End;
+    }
+    
+    if (pos_ == end_)
+        error("Unexpected end of document");
+    
+    char c = *pos_;
+    switch (state_)
+    {
+        case FirstKeyState:
+            if (c == '}')
+                return closeContainer();
+            // fall through
+        case KeyState:
+            if (c != '"')
+                error("Expected an object key");
+            parseString();
+            skipWhitespace();
+            if (pos_ == end_ || *pos_ != ':')
+                error("Expected ':' after an object key");
+            pos_ ++;
+            state_ = ValueState;
+            return token_ = Key;
+            
+        case FirstElementState:
+            if (c == ']')
+                return closeContainer();
+            break;
+            
+        default:
+            break;
+    }
+    
+    // parse a value
+    state_ = AfterValueState;
+    switch (c)
+    {
+        case '{':
+            pos_ ++;
+            stack_ += '{';
+            state_ = FirstKeyState;
+            return token_ = BeginObject;
+            
+        case '[':
+            pos_ ++;
+            stack_ += '[';
+            state_ = FirstElementState;
+            return token_ = BeginArray;
+            
+        case '"':
+            parseString();
+            return token_ = String;
+            
+        case 't':
+            parseLiteral("true", 4);
+            return token_ = True;
+            
+        case 'f':
+            parseLiteral("false", 5);
+            return token_ = False;
+            
+        case 'n':
+            parseLiteral("null", 4);
+            return token_ = Null;
+            
+        default:
+            if (c != '-' && !isDigit(c))
+                error("Unexpected character");
+            parseNumber();
+            return token_ = Number;
+    }
+}
+
+
+JsonReader::Token JsonReader::getToken() const
+{
+    return token_;
+}
+
+
+const char* JsonReader::getText() const
+{
+    return text_;
+}
+
+
+size_t JsonReader::getTextLength() const
+{
+    return textLength_;
+}
+
+
+double JsonReader::getNumber() const
+{
+    // strtod needs a null terminated string
+    char buffer[64];
+    if (textLength_ < sizeof(buffer))
+    {
+        memcpy(buffer, text_, textLength_);
+        buffer[textLength_] = 0;
+        return strtod(buffer, NULL);
+    }
+    return strtod(string(text_, textLength_).c_str(), NULL);
+}
+
+
+void JsonReader::skipValue()
+{
+    skipContent(next());
+}
+
+
+void JsonReader::read(const Variant& object)
+{
+    const Class* clazz = dynamic_cast<const Class*>(&object.getType());
+    if (!clazz)
+        throw SerializationException("Cannot read a JSON object into non "
+                "class type " + object.getType().getName());
+    
+    if (object.isConst())
+        throw VariantCostnessException(*clazz);
+    
+    readObject(next(), static_cast<char*>(object.getAddress()), *clazz);
+}
+
+
+size_t JsonReader::getPosition() const
+{
+    return pos_ - begin_;
+}
+
+
+JsonReader::Token JsonReader::closeContainer()
+{
+    char expected = stack_[stack_.size() - 1] == '{' ? '}' : ']';
+    if (pos_ == end_ || *pos_ != expected)
+    {
+        if (expected == '}')
+            error("Expected ',' or '}'");
+        else
+            error("Expected ',' or ']'");
+    }
+    
+    pos_ ++;
+    stack_.erase(stack_.size() - 1);
+    state_ = AfterValueState;
+    return token_ = (expected == '}' ? EndObject : EndArray);
+}
+
+
+void JsonReader::parseString()
+{
+    // skip the opening quote
+    pos_ ++;
+    
+    // strings with no escape sequences are returned in place
+    const char* start = pos_;
+    while (pos_ != end_ && *pos_ != '"' && *pos_ != '\\')
+    {
+        if (static_cast<unsigned char>(*pos_) < 0x20)
+            error("Control character in string");
+        pos_ ++;
+    }
+    
+    if (pos_ != end_ && *pos_ == '"')
+    {
+        text_ = start;
+        textLength_ = pos_ - start;
+        pos_ ++;
+        return;
+    }
+    
+    // decode the string into the scratch buffer
+    scratch_.assign(start, pos_);
+    while (true)
+    {
+        if (pos_ == end_)
+            error("Unterminated string");
+        
+        char c = *pos_++;
+        if (c == '"')
+            break;
+        if (static_cast<unsigned char>(c) < 0x20)
+            error("Control character in string");
+        if (c != '\\')
+        {
+            scratch_ += c;
+            continue;
+        }
+        
+        if (pos_ == end_)
+            error("Unterminated string");
+        c = *pos_++;
+        switch (c)
+        {
+            case '"': scratch_ += '"'; break;
+            case '\\': scratch_ += '\\'; break;
+            case '/': scratch_ += '/'; break;
+            case 'b': scratch_ += '\b'; break;
+            case 'f': scratch_ += '\f'; break;
+            case 'n': scratch_ += '\n'; break;
+            case 'r': scratch_ += '\r'; break;
+            case 't': scratch_ += '\t'; break;
+            case 'u':
+            {
+                unsigned long code = 0;
+                for (int i = 0; i < 4; i++)
+                {
+                    if (pos_ == end_)
+                        error("Unterminated string");
+                    c = *pos_++;
+                    code <<= 4;
+                    if (isDigit(c))
+                        code |= c - '0';
+                    else if (c >= 'a' && c <= 'f')
+                        code |= c - 'a' + 10;
+                    else if (c >= 'A' && c <= 'F')
+                        code |= c - 'A' + 10;
+                    else
+                        error("Invalid unicode escape sequence");
+                }
+                
+                // combine surrogate pairs
+                if (code >= 0xD800 && code < 0xDC00 && end_ - pos_ >= 6
+                    && pos_[0] == '\\' && pos_[1] == 'u')
+                {
+                    unsigned long low = strtoul(
+                            string(pos_ + 2, 4).c_str(), NULL, 16);
+                    if (low >= 0xDC00 && low < 0xE000)
+                    {
+                        code = 0x10000 + ((code - 0xD800) << 10)
+                                + (low - 0xDC00);
+                        pos_ += 6;
+                    }
+                }
+                appendUtf8(scratch_, code);
+                break;
+            }
+            default:
+                error("Invalid escape sequence");
+        }
+    }
+    
+    text_ = scratch_.data();
+    textLength_ = scratch_.size();
+}
+
+
+void JsonReader::parseNumber()
+{
+    const char* start = pos_;
+    
+    if (*pos_ == '-')
+        pos_ ++;
+    
+    if (pos_ == end_ || !isDigit(*pos_))
+        error("Invalid number");
+    if (*pos_ == '0')
+        pos_ ++;
+    else
+        while (pos_ != end_ && isDigit(*pos_)) pos_ ++;
+    
+    if (pos_ != end_ && *pos_ == '.')
+    {
+        pos_ ++;
+        if (pos_ == end_ || !isDigit(*pos_))
+            error("Invalid number");
+        while (pos_ != end_ && isDigit(*pos_)) pos_ ++;
+    }
+    
+    if (pos_ != end_ && (*pos_ == 'e' || *pos_ == 'E'))
+    {
+        pos_ ++;
+        if (pos_ != end_ && (*pos_ == '+' || *pos_ == '-'))
+            pos_ ++;
+        if (pos_ == end_ || !isDigit(*pos_))
+            error("Invalid number");
+        while (pos_ != end_ && isDigit(*pos_)) pos_ ++;
+    }
+    
+    text_ = start;
+    textLength_ = pos_ - start;
+}
+
+
+void JsonReader::parseLiteral(const char* literal, size_t length)
+{
+    if (static_cast<size_t>(end_ - pos_) < length
+        || memcmp(pos_, literal, length) != 0)
+        error("Unexpected character");
+    pos_ += length;
+}
+
+
+void JsonReader::skipWhitespace()
+{
+    while (pos_ != end_
+           && (*pos_ == ' ' || *pos_ == '\n' || *pos_ == '\r' || *pos_ == '\t'))
+        pos_ ++;
+}
+
+
+void JsonReader::error(const string& msg) const
+{
+    char position[32];
+    sprintf(position, "%lu", static_cast<ulong>(pos_ - begin_));
+    throw SerializationException(msg + " at position " + position
+            + " of the JSON document");
+}
+
+
+void JsonReader::readObject(Token token, char* obj, const Class& clazz)
+{
+    if (token != BeginObject)
+        error("Expected an object of class " + clazz.getName());
+    
+    const ClassLayout& layout = clazz.getLayout();
+    const ClassLayout::Field_Vector& fields = layout.getFields();
+    
+    token = next();
+    while (token != EndObject)
+    {
+        int index = layout.findField(text_, textLength_);
+        if (index < 0)
+            skipValue();
+        else
+            readField(obj, clazz, fields[index]);
+        token = next();
+    }
+}
+
+
+void JsonReader::readCompound(Token token,
+                              char* data,
+                              const CompoundClass& clazz)
+{
+    Variant self(data, clazz, 0);
+    const Sequence* sequence = clazz.getSequence();
+    const Associative* associative = clazz.getAssociative();
+    if (!sequence && !associative)
+    {
+        readObject(token, data, clazz);
+        return;
+    }
+    
+    const Type* mappedType = associative ? associative->getMappedType()
+            : NULL;
+    if (associative && mappedType
+            && associative->getKeyType().getCategory() == Type::String)
+    {
+        // string keys are the keys of a JSON object
+        if (token != BeginObject)
+            error("Expected an object for type " + clazz.getName());
+        associative->clear(self);
+        for (token = next(); token != EndObject; token = next())
+        {
+            Variant key = associative->createKey();
+            static_cast<string*>(key.getAddress())->assign(text_,
+                    textLength_);
+            associative->insert(self, key);
+            Variant mapped = associative->find(self, key);
+            readData(next(), static_cast<char*>(mapped.getAddress()),
+                    *mappedType, NULL);
+        }
+        return;
+    }
+    
+    if (token != BeginArray)
+        error("Expected an array for type " + clazz.getName());
+    if (sequence)
+        sequence->clear(self);
+    else
+        associative->clear(self);
+    
+    for (token = next(); token != EndArray; token = next())
+    {
+        if (sequence)
+        {
+            Variant element = sequence->emplaceBack(self);
+            readData(token, static_cast<char*>(element.getAddress()),
+                    sequence->getElementType(), NULL);
+            continue;
+        }
+        
+        // sets are arrays of keys, maps arrays of [key, value] pairs
+        if (mappedType)
+        {
+            if (token != BeginArray)
+                error("Expected a [key, value] pair for type "
+                        + clazz.getName());
+            token = next();
+        }
+        Variant key = associative->createKey();
+        readData(token, static_cast<char*>(key.getAddress()),
+                associative->getKeyType(), NULL);
+        associative->insert(self, key);
+        if (mappedType)
+        {
+            Variant mapped = associative->find(self, key);
+            readData(next(), static_cast<char*>(mapped.getAddress()),
+                    *mappedType, NULL);
+            if (next() != EndArray)
+                error("Expected the end of a [key, value] pair for type "
+                        + clazz.getName());
+        }
+    }
+}
+
+
+void JsonReader::readField(char* obj,
+                           const Class& clazz,
+                           const ClassLayout::Field& field)
+{
+    const Property& property = *field.property;
+    const Type& type = property.getType();
+    
+    // arrays are never settable as a whole, but are filled element-wise
+    bool settable = property.getFlags() & Property::Settable;
+    if (!settable && !(field.offset >= 0 && type.getCategory() == Type::Array))
+    {
+        skipValue();
+        return;
+    }
+    
+    if (field.offset >= 0)
+    {
+        readData(next(), obj + field.offset, type, &property);
+    }
+    else
+    {
+        // read into a copy of the current value, then go through the setter
+        Variant self(obj, clazz, 0);
+        Variant value = property.getData(self);
+        if (value.isReference() || value.isConst())
+        {
+            Variant ref(value.getAddress(), value.getType(), 0);
+            value = Variant(const_cast<const Variant&>(ref));
+        }
+        
+        readData(next(), static_cast<char*>(value.getAddress()),
+                value.getType(), NULL);
+        property.setData(self, value);
+    }
+}
+
+
+void JsonReader::readData(Token token,
+                          char* data,
+                          const Type& type,
+                          const Property* property)
+{
+    switch (type.getCategory())
+    {
+        case Type::Primitive:
+            readPrimitive(token, data, dynamic_cast<const PrimitiveType&>(type),
+                    property);
+            break;
+            
+        case Type::Array:
+        {
+            const ArrayType& arrayType = dynamic_cast<const ArrayType&>(type);
+            const Type& elementType = arrayType.getArrayElementType();
+            size_t count = arrayType.getArraySize();
+            
+            if (token != BeginArray)
+                error("Expected an array of type " + type.getName());
+            for (size_t i = 0; i < count; i++)
+            {
+                token = next();
+                if (token == EndArray)
+                    error("Array size mismatch for type " + type.getName());
+                readData(token, data + i * elementType.getSize(), elementType,
+                        NULL);
+            }
+            if (next() != EndArray)
+                error("Array size mismatch for type " + type.getName());
+            break;
+        }
+            
+        case Type::Class:
+            readObject(token, data, dynamic_cast<const Class&>(type));
+            break;
+            
+        case Type::CompoundClass:
+            readCompound(token, data, dynamic_cast<const CompoundClass&>(type));
+            break;
+            
+        case Type::String:
+            if (token != String)
+                error("Expected a string for type " + type.getName());
+            reinterpret_cast<string*>(data)->assign(text_, textLength_);
+            break;
+            
+        case Type::Pointer:
+        {
+            // values are read into the pointed data, if any. Strings are not
+            // read since the pointed memory is not owned by the instance.
+            char* pointer = load<char*>(data);
+            const Type& pointedType =
+                    dynamic_cast<const PointerType&>(type).getPointedType();
+            const PrimitiveType* pointedPrimitive =
+                    dynamic_cast<const PrimitiveType*>(&pointedType);
+            
+            if (token == Null || !pointer || (pointedPrimitive
+                    && pointedPrimitive->getKind() == PrimitiveType::Char))
+                skipContent(token);
+            else
+                readData(token, pointer, pointedType, NULL);
+            break;
+        }
+            
+        default:
+            skipContent(token);
+            break;
+    }
+}
+
+
+void JsonReader::readPrimitive(Token token,
+                               char* data,
+                               const PrimitiveType& type,
+                               const Property* property)
+{
+    PrimitiveType::Kind kind = type.getKind();
+    const Enum* xmEnum = type.getEnum();
+    
+    // null leaves the value untouched, except for floating point values
+    // which are written as null when not finite
+    if (token == Null)
+    {
+        if (kind == PrimitiveType::Float)
+            store<float>(data, numeric_limits<float>::quiet_NaN());
+        else if (kind == PrimitiveType::Double)
+            store<double>(data, numeric_limits<double>::quiet_NaN());
+        return;
+    }
+    
+    // enumeration values are read from their names
+    if (xmEnum && token == String)
+    {
+        long long value;
+        if (!xmEnum->parse(text_, textLength_, value))
+            throw EnumKeyNotFoundException(*xmEnum,
+                    string(text_, textLength_));
+        storeEnum(data, type.getSize(), value);
+        return;
+    }
+    
+    if (kind == PrimitiveType::Bool)
+    {
+        if (token != True && token != False)
+            error("Expected a boolean");
+        store<bool>(data, token == True);
+        return;
+    }
+    
+    if (kind == PrimitiveType::Other && !xmEnum)
+    {
+        skipContent(token);
+        return;
+    }
+    
+    if (token != Number)
+        error("Expected a number for type " + type.getName());
+    
+    // the value is stored into the field only once it has been checked
+    char buffer[sizeof(double) > sizeof(long long) ? sizeof(double)
+            : sizeof(long long)];
+    double value = 0;
+    bool fits = true;
+    if (kind == PrimitiveType::Float || kind == PrimitiveType::Double)
+    {
+        value = getNumber();
+        if (kind == PrimitiveType::Float)
+        {
+            fits = !(fabs(value) > numeric_limits<float>::max());
+            store<float>(buffer, value);
+        }
+        else
+            store<double>(buffer, value);
+    }
+    else
+    {
+        // parse the integer
+        bool negative = text_[0] == '-';
+        unsigned long long magnitude = 0;
+        for (size_t i = negative ? 1 : 0; i < textLength_; i++)
+        {
+            if (!isDigit(text_[i]))
+                error("Expected an integer for type " + type.getName());
+            unsigned long long digit = text_[i] - '0';
+            if (magnitude > (numeric_limits<unsigned long long>::max() - digit)
+                    / 10)
+                error("Number out of range for type " + type.getName());
+            magnitude = magnitude * 10 + digit;
+        }
+        value = negative ? -static_cast<double>(magnitude)
+                : static_cast<double>(magnitude);
+        
+        switch (kind)
+        {
+            case PrimitiveType::Char:
+                fits = storeInteger<char>(buffer, negative, magnitude);
+                break;
+            case PrimitiveType::WChar:
+                fits = storeInteger<wchar_t>(buffer, negative, magnitude);
+                break;
+            case PrimitiveType::Short:
+                fits = storeInteger<short>(buffer, negative, magnitude);
+                break;
+            case PrimitiveType::Int:
+                fits = storeInteger<int>(buffer, negative, magnitude);
+                break;
+            case PrimitiveType::Long:
+                fits = storeInteger<long>(buffer, negative, magnitude);
+                break;
+            case PrimitiveType::UChar:
+                fits = storeInteger<uchar>(buffer, negative, magnitude);
+                break;
+            case PrimitiveType::UShort:
+                fits = storeInteger<ushort>(buffer, negative, magnitude);
+                break;
+            case PrimitiveType::UInt:
+                fits = storeInteger<uint>(buffer, negative, magnitude);
+                break;
+            case PrimitiveType::ULong:
+                fits = storeInteger<ulong>(buffer, negative, magnitude);
+                break;
+            default:
+                // enumeration, of any width and signedness
+                fits = storeEnumInteger(buffer, type.getSize(),
+                        xmEnum->isSigned(), negative, magnitude);
+                break;
+        }
+    }
+    
+    if (!fits)
+        error("Number out of range for type " + type.getName());
+    
+    // check the property bounds
+    if (property && !xmEnum && (value < property->getMinValue()
+                                || value > property->getMaxValue()))
+        throw PropertyRangeException(property->getMinValue(),
+                property->getMaxValue(), value);
+    
+    memcpy(data, buffer, type.getSize());
+}
+
+
+void JsonReader::skipContent(Token token)
+{
+    if (token != BeginObject && token != BeginArray)
+        return;
+    
+    size_t depth = 1;
+    while (depth > 0)
+    {
+        token = next();
+        if (token == BeginObject || token == BeginArray)
+            depth ++;
+        else if (token == EndObject || token == EndArray)
+            depth --;
+    }
+}
@@ -0,0 +1,221 @@
+/******************************************************************************      
+ *      Extended Mirror: MemoryStats.cpp                                      *
+ ******************************************************************************
+ *      Copyright (c) 2012-2015, Manuele Finocchiaro                          *
+ *      All rights reserved.                                                  *
+ ******************************************************************************
+ * Redistribution and use in source and binary forms, with or without         *
+ * modification, are permitted provided that the following conditions         *
+ * are met:                                                                   *
+ *                                                                            *
+ *    1. Redistributions of source code must retain the above copyright       *
+ *       notice, this list of conditions and the following disclaimer.        *
+ *                                                                            *
+ *    2. Redistributions in binary form must reproduce the above copyright    *
+ *       notice, this list of conditions and the following disclaimer in      *
+ *       the documentation and/or other materials provided with the           *
+ *       distribution.                                                        *
+ *                                                                            *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"* 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE  *
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE *
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE  *
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR        *
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF       *
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS   *
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN    *
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)    *
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF     *
+ * THE POSSIBILITY OF SUCH DAMAGE.                                            *
+ *****************************************************************************/
+
+
+#include <XM/xMirror.hpp>
+#include <XM/MemoryStats.hpp>
+
+using namespace std;
+using namespace xm;
+
+
+namespace {
+
+// The size of a node of a std::set: three links and the color, plus the
+// element.
+template<class T>
+size_t getSetSize(const set<T>& s)
+{
+    return s.size() * (4 * sizeof(void*) + sizeof(T));
+}
+
+
+template<class T, class C>
+size_t getSetSize(const set<T, C>& s)
+{
+    return s.size() * (4 * sizeof(void*) + sizeof(T));
+}
+
+
+// The heap memory of a string, zero if it is stored in the object itself.
+size_t getStringSize(const string& str)
+{
+    const char* data = str.data();
+    const char* object = reinterpret_cast<const char*>(&str);
+    if (data >= object && data < object + sizeof(string))
+        return 0;
+    return str.capacity() + 1;
+}
+
+
+// The size of the descriptor object of an item.
+size_t getItemSize(const Item& item)
+{
+    if (dynamic_cast<const CompoundClass*>(&item))
+        return sizeof(CompoundClass);
+    if (dynamic_cast<const Class*>(&item))
+        return sizeof(Class);
+    if (dynamic_cast<const PrimitiveType*>(&item))
+        return sizeof(PrimitiveType);
+    if (dynamic_cast<const PointerType*>(&item))
+        return sizeof(PointerType);
+    if (dynamic_cast<const ArrayType*>(&item))
+        return sizeof(ArrayType);
+    if (dynamic_cast<const Type*>(&item))
+        return sizeof(Type);
+    if (dynamic_cast<const Property*>(&item))
+        return sizeof(Property);
+    if (dynamic_cast<const Method*>(&item))
+        return sizeof(Method);
+    if (dynamic_cast<const Function*>(&item))
+        return sizeof(Function);
+    if (dynamic_cast<const Namespace*>(&item))
+        return sizeof(Namespace);
+    if (dynamic_cast<const Enum*>(&item))
+        return sizeof(Enum);
+    if (dynamic_cast<const Template*>(&item))
+        return sizeof(Template);
+    return sizeof(Item);
+}
+
+
+// The parameters of a function.
+size_t getParametersSize(const Function& function)
+{
+    const Const_Prameter_Vector& params = function.getParameters();
+    return params.capacity() * sizeof(const Parameter*)
+            + params.size() * sizeof(Parameter);
+}
+
+
+} // namespace
+
+
+// Walks the registry accumulating the memory used.
+class xm::MemoryStatsCollector
+{
+public:
+    MemoryStatsCollector(MemoryStats& stats) : stats_(stats) {}
+    
+    void collect(const Item& item)
+    {
+        if (!visited_.insert(&item).second)
+            return;
+        
+        stats_.items ++;
+        stats_.names += getStringSize(item.getUnqualifiedName());
+        
+        size_t size = getItemSize(item);
+        if (dynamic_cast<const Type*>(&item))
+        {
+            const Type& type = dynamic_cast<const Type&>(item);
+            stats_.types += size;
+            const String_Set& aliases = type.getAliases();
+            stats_.containers += getSetSize(aliases);
+            for (String_Set::const_iterator ite = aliases.begin();
+                    ite != aliases.end(); ++ite)
+                stats_.names += getStringSize(*ite);
+        }
+        else if (dynamic_cast<const Member*>(&item))
+            stats_.members += size;
+        else
+            stats_.namespaces += size;
+        
+        const Function* function = dynamic_cast<const Function*>(&item);
+        if (function)
+            stats_.members += getParametersSize(*function);
+        
+        const Class* clazz = dynamic_cast<const Class*>(&item);
+        if (clazz)
+            collectClass(*clazz);
+        
+        const Namespace* name_space = dynamic_cast<const Namespace*>(&item);
+        if (name_space)
+            collectNamespace(*name_space);
+    }
+    
+private:
+    void collectNamespace(const Namespace& name_space);
+    
+    void collectClass(const Class& clazz);
+    
+    MemoryStats& stats_;
+    
+    set<const Item*> visited_;
+};
+
+
+void MemoryStatsCollector::collectNamespace(const Namespace& name_space)
+{
+    stats_.containers += getSetSize(name_space.items_)
+            + getSetSize(name_space.ownItems_);
+    
+    Const_Item_Set::const_iterator ite = name_space.items_.begin();
+    for (; ite != name_space.items_.end(); ++ite)
+        collect(**ite);
+    for (ite = name_space.ownItems_.begin();
+            ite != name_space.ownItems_.end(); ++ite)
+        collect(**ite);
+}
+
+
+void MemoryStatsCollector::collectClass(const Class& clazz)
+{
+    stats_.members += sizeof(Constructor) + sizeof(CopyConstructor)
+            + sizeof(Destructor)
+            + clazz.refCasters_.size() * sizeof(RefCaster);
+    
+    stats_.containers += clazz.baseClasses_.getMemorySize()
+            + clazz.indirectBaseClasses_.getMemorySize()
+            + clazz.refCasters_.getMemorySize()
+            + clazz.derivedClasses_.getMemorySize()
+            + clazz.ownProperties_.getMemorySize()
+            + clazz.ownMethods_.getMemorySize()
+            + clazz.ancestors_.capacity() * sizeof(uint64_t);
+    
+    stats_.memberTables += clazz.dispatch_.capacity() * sizeof(const Method*);
+    const Class::MemberTable* table = clazz.memberTable_.load();
+    if (table)
+    {
+        stats_.memberTables += sizeof(Class::MemberTable)
+                + table->properties.getMemorySize()
+                + table->methods.getMemorySize();
+    }
+    
+    const ClassLayout* layout = clazz.layout_.load();
+    if (layout)
+        stats_.layouts += layout->getMemorySize();
+    for (size_t i = 0; i < clazz.oldLayouts_.size(); i++)
+        stats_.layouts += clazz.oldLayouts_[i]->getMemorySize();
+}
+
+
+MemoryStats xm::memoryStats()
+{
+    MemoryStats stats;
+    MemoryStatsCollector collector(stats);
+    collector.collect(Register::getSingleton());
+    
+    stats.total = stats.types + stats.members + stats.namespaces
+            + stats.names + stats.containers + stats.memberTables
+            + stats.layouts;
+    return stats;
+}
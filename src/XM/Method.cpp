@@ -36,15 +36,20 @@
 using namespace std;
 using namespace xm;
 
+const size_t Method::NoSlot;
+
+
 Method::Method(const std::string& uName) :
         Item(uName, getClass<void>()),
-        Function(uName)
+        Function(uName),
+        slot_(NoSlot)
 {
 }
 
 
 Method::Method(const std::string& uName, const Class& owner) :
-        Item(uName, owner)
+        Item(uName, owner),
+        slot_(NoSlot)
 {
 }
 
@@ -111,6 +116,12 @@ bool Method::isConst() const
 }
 
 
+size_t Method::getSlot() const
+{
+    return slot_;
+}
+
+
 bool Method::before_(const Item& item) const
 {
     const Method& other = dynamic_cast<const Method&>(item);
@@ -52,8 +52,10 @@ Namespace::Namespace(const std::string& name)
 }
 
 
-template<typename T>
-T& Namespace::getItem_(const string& name)
+namespace {
+
+// Split a name in its path and normalized unqualified name.
+pair<string, string> splitItemName(const string& name)
 {
     pair<string, string> nameParts = splitName(name, NameTail);
 
@@ -69,11 +71,28 @@ T& Namespace::getItem_(const string& name)
             i++;
         }
     }
+    return nameParts;
+}
+
+} // namespace
 
+
+template<typename T>
+T& Namespace::getItem_(const string& name)
+{
+    pair<string, string> nameParts = splitItemName(name);
     return getItem_(nameParts.first, T(nameParts.second, *this));
 }
 
 
+template<typename T>
+T* Namespace::findItem_(const string& name)
+{
+    pair<string, string> nameParts = splitItemName(name);
+    return findItem_(nameParts.first, T(nameParts.second, *this));
+}
+
+
 namespace xm {
 
 template<>
@@ -93,6 +112,28 @@ Method& Namespace::getItem_<Method>(const string& name)
     return getItem_(nameParts.first, Method(nameParts.second, *clazz));
 }
 
+
+template<>
+Property* Namespace::findItem_<Property>(const string& name)
+{
+    pair<string, string> nameParts = splitName(name, NameTail);
+    const Class* clazz = dynamic_cast<Class*>(this);
+    if (!clazz)
+        return NULL;
+    return findItem_(nameParts.first, Property(nameParts.second, *clazz));
+}
+
+
+template<>
+Method* Namespace::findItem_<Method>(const string& name)
+{
+    pair<string, string> nameParts = splitName(name, NameTail);
+    const Class* clazz = dynamic_cast<Class*>(this);
+    if (!clazz)
+        return NULL;
+    return findItem_(nameParts.first, Method(nameParts.second, *clazz));
+}
+
 }
 
 
@@ -106,58 +147,76 @@ T& Namespace::getItem_(const T& keyItem)
 template<typename T>
 T& Namespace::getItem_(const string& path, const T& keyItem)
 {
+    T* found = findItem_(path, keyItem);
+    if (found)
+        return *found;
+    
+    // the exception only records the namespace and the key, its message is
+    // formatted when requested
     if (path != "")
-    {
-        Namespace& ns = walkTo(path);
-        return ns.getItem_("", keyItem);
-    }
-
+        throw NotFoundException(walkTo(path), keyItem);
+    throw NotFoundException(*this, keyItem);
+}
 
-    const Item* keyItemPtr = dynamic_cast<const Item*>(&keyItem);
-    Const_Item_Set::iterator ite = items_.find(keyItemPtr);
-    if (ite != items_.end())
-    {
-        const T* found = dynamic_cast<const T*>(*ite);
-        if (found)
-            return *const_cast<T*>(found);
-    }
 
-    throw NotFoundException(*this, keyItem);
+template<typename T>
+T* Namespace::findItem_(const string& path, const T& keyItem)
+{
+    Register::Lock lock(Register::Lock::Shared);
+    Namespace* ns = path != "" ? walkTo_(path, false) : this;
+    if (!ns)
+        return NULL;
+    
+    const Item* item = ns->lookupItem_(dynamic_cast<const Item&>(keyItem));
+    return const_cast<T*>(dynamic_cast<const T*>(item));
 }
 
 
 Namespace& Namespace::walkTo(const string& path, bool create)
 {
+    Namespace* ns = walkTo_(path, create);
+    if (!ns)
+        throw NotFoundException(*this, Namespace(path, *this));
+    return *ns;
+}
+
+
+Namespace* Namespace::walkTo_(const string& path, bool create)
+{
+    Register::Lock lock(create ? Register::Lock::Exclusive
+                               : Register::Lock::Shared);
     size_t sepPos = path.find("::");
     pair<string, string> pathParts;
     if (sepPos == 0)
     {
         string relativePath = path.substr(2, path.length());
-        return Register::getSingleton().walkTo(relativePath, create);
+        return Register::getSingleton().walkTo_(relativePath, create);
     }
     else if (path == "")
-        return *this;
+        return this;
     else if (sepPos != string::npos)
         pathParts = splitName(path, NameHead);
     else
         pathParts = make_pair<string, string>(path.c_str(), "");
 
-    try {
-        Namespace& ns = getItem_<Namespace>(pathParts.first);
-        return ns.walkTo(pathParts.second, create);
-    } catch (NotFoundException& e) {
-        if (create)
-        {
-            Namespace* ns = new Namespace(pathParts.first, *this);
-            items_.insert(ns);
-            ownItems_.insert(ns);
-            return ns->walkTo(pathParts.second, create);
-        }
-        else
-        {
-            throw e;
-        }
-    }
+    Namespace* ns = findItem_<Namespace>(pathParts.first);
+    if (ns)
+        return ns->walkTo_(pathParts.second, create);
+    
+    if (!create)
+        return NULL;
+    
+    ns = new Namespace(pathParts.first, *this);
+    items_.insert(ns);
+    ownItems_.insert(ns);
+    return ns->walkTo_(pathParts.second, create);
+}
+
+
+const Item* Namespace::lookupItem_(const Item& keyItem) const
+{
+    Const_Item_Set::const_iterator ite = items_.find(&keyItem);
+    return ite != items_.end() ? *ite : NULL;
 }
 
 
@@ -198,6 +257,43 @@ template const Method& Namespace::getItem(const std::string& name) const;
 template const Method& Namespace::getItem(const Method& method) const;
 
 
+template<typename T>
+const T* Namespace::findItem(const string& name) const
+{
+    return const_cast<Namespace*>(this)->findItem_<T>(name);
+}
+
+
+template<typename T>
+const T* Namespace::findItem(const T& keyItem) const
+{
+    return const_cast<Namespace*>(this)->findItem_("", keyItem);
+}
+
+
+template<typename T>
+const T* Namespace::findItem(const string& path, const T& keyItem) const
+{
+    return const_cast<Namespace*>(this)->findItem_(path, keyItem);
+}
+
+
+template const Item* Namespace::findItem(const std::string& name) const;
+template const Namespace* Namespace::findItem(const std::string& name) const;
+template const Type* Namespace::findItem(const std::string& name) const;
+template const Class* Namespace::findItem(const std::string& name) const;
+template const CompoundClass* Namespace::findItem(const std::string& name)
+    const;
+template const Template* Namespace::findItem(const std::string& name) const;
+template const Constant* Namespace::findItem(const std::string& name) const;
+template const Enum* Namespace::findItem(const std::string& name) const;
+template const Function* Namespace::findItem(const std::string& name) const;
+template const Variable* Namespace::findItem(const std::string& name) const;
+template const Property* Namespace::findItem(const std::string& name) const;
+template const Method* Namespace::findItem(const std::string& name) const;
+template const Method* Namespace::findItem(const Method& method) const;
+
+
 bool Namespace::addNamespace_(Namespace& where, const string& what)
 {
     Namespace* name_space = new Namespace(what, where);
@@ -214,6 +310,7 @@ Namespace& Namespace::defineNamespace(const std::string& path)
 
 void Namespace::addItem(Item& item)
 {
+    Register::Lock lock;
     items_.insert(&item);
     if (item.getNamespace() == *this)
         ownItems_.insert(&item);
@@ -0,0 +1,312 @@
+/******************************************************************************      
+ *      Extended Mirror: ObjectStore.cpp                                      *
+ ******************************************************************************
+ *      Copyright (c) 2012-2015, Manuele Finocchiaro                          *
+ *      All rights reserved.                                                  *
+ ******************************************************************************
+ * Redistribution and use in source and binary forms, with or without         *
+ * modification, are permitted provided that the following conditions         *
+ * are met:                                                                   *
+ *                                                                            *
+ *    1. Redistributions of source code must retain the above copyright       *
+ *       notice, this list of conditions and the following disclaimer.        *
+ *                                                                            *
+ *    2. Redistributions in binary form must reproduce the above copyright    *
+ *       notice, this list of conditions and the following disclaimer in      *
+ *       the documentation and/or other materials provided with the           *
+ *       distribution.                                                        *
+ *                                                                            *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"* 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE  *
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE *
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE  *
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR        *
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF       *
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS   *
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN    *
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)    *
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF     *
+ * THE POSSIBILITY OF SUCH DAMAGE.                                            *
+ *****************************************************************************/
+
+
+#include <XM/xMirror.hpp>
+#include <XM/ObjectStore.hpp>
+#include <XM/Exceptions/QueryException.hpp>
+#include <XM/Exceptions/VariantTypeException.hpp>
+
+#include <algorithm>
+
+using namespace std;
+using namespace xm;
+
+
+ObjectStore::ObjectStore(const Class& clazz)
+    : clazz_(clazz), slotCount_(0)
+{
+    tracker_.addListener(*this);
+}
+
+
+const Class& ObjectStore::getClass() const
+{
+    return clazz_;
+}
+
+
+void ObjectStore::addIndex(const string& property, IndexKind kind)
+{
+    const Property& prop = clazz_.getProperty(property);
+    const PrimitiveType* type =
+            dynamic_cast<const PrimitiveType*>(&prop.getType());
+    if (!type)
+        throw QueryException("Property \"" + property + "\" of "
+                + clazz_.getName() + " cannot be indexed");
+    
+    for (size_t i = 0; i < indexes_.size(); i++)
+    {
+        if (indexes_[i]->property == &prop)
+            throw QueryException("Property \"" + property + "\" of "
+                    + clazz_.getName() + " is already indexed");
+    }
+    
+    Index* index = new Index();
+    index->property = &prop;
+    index->type = type;
+    const ClassLayout& layout = clazz_.getLayout();
+    int field = layout.getFieldIndex(prop);
+    index->offset = field >= 0 ? layout.getFields()[field].offset : -1;
+    index->kind = kind;
+    index->keys.resize(slotCount_);
+    indexes_.push_back(index);
+    
+    refresh();
+    for (Slot_Map::iterator ite = slots_.begin(); ite != slots_.end(); ++ite)
+        addEntry(*index, ite->first, ite->second);
+}
+
+
+void ObjectStore::insert(const Variant& object)
+{
+    if (&object.getType() != &clazz_)
+        throw VariantTypeException(object.getType(), clazz_);
+    
+    void* address = object.getAddress();
+    if (slots_.count(address))
+        return;
+    
+    size_t slot;
+    if (freeSlots_.empty())
+    {
+        slot = slotCount_++;
+        for (size_t i = 0; i < indexes_.size(); i++)
+            indexes_[i]->keys.resize(slotCount_);
+    }
+    else
+    {
+        slot = freeSlots_.back();
+        freeSlots_.pop_back();
+    }
+    slots_[address] = slot;
+    
+    for (size_t i = 0; i < indexes_.size(); i++)
+        addEntry(*indexes_[i], address, slot);
+    
+    tracker_.track(object);
+}
+
+
+void ObjectStore::erase(const Variant& object)
+{
+    // the pending changes are applied first, so that the instance is
+    // removed from the indexes under its current keys
+    refresh();
+    
+    void* address = object.getAddress();
+    Slot_Map::iterator ite = slots_.find(address);
+    if (ite == slots_.end())
+        return;
+    
+    size_t slot = ite->second;
+    for (size_t i = 0; i < indexes_.size(); i++)
+        removeEntry(*indexes_[i], address, slot);
+    
+    slots_.erase(ite);
+    freeSlots_.push_back(slot);
+    tracker_.untrack(object);
+}
+
+
+bool ObjectStore::contains(const Variant& object) const
+{
+    return slots_.count(object.getAddress()) != 0;
+}
+
+
+size_t ObjectStore::getSize() const
+{
+    return slots_.size();
+}
+
+
+void ObjectStore::update(const Variant& object)
+{
+    void* address = object.getAddress();
+    Slot_Map::iterator ite = slots_.find(address);
+    if (ite == slots_.end())
+        return;
+    
+    size_t slot = ite->second;
+    for (size_t i = 0; i < indexes_.size(); i++)
+    {
+        Index& index = *indexes_[i];
+        if (getKey(index, address) == index.keys[slot])
+            continue;
+        removeEntry(index, address, slot);
+        addEntry(index, address, slot);
+    }
+}
+
+
+void ObjectStore::refresh()
+{
+    tracker_.flush();
+}
+
+
+void ObjectStore::find(const string& property,
+                       const Variant& value,
+                       vector<void*>& result)
+{
+    refresh();
+    
+    Index& index = getIndex(property);
+    uint64_t key = getKey(index, value);
+    result.clear();
+    
+    if (index.kind == HashIndex)
+    {
+        unordered_map<uint64_t, Bucket>::const_iterator ite =
+                index.buckets.find(key);
+        if (ite != index.buckets.end())
+            result = ite->second;
+        return;
+    }
+    
+    set<pair<uint64_t, void*> >::const_iterator ite =
+            index.entries.lower_bound(make_pair(key, (void*)NULL));
+    for (; ite != index.entries.end() && ite->first == key; ++ite)
+        result.push_back(ite->second);
+}
+
+
+void ObjectStore::findRange(const string& property,
+                            const Variant& low,
+                            const Variant& high,
+                            vector<void*>& result)
+{
+    refresh();
+    
+    Index& index = getIndex(property);
+    if (index.kind != OrderedIndex)
+        throw QueryException("Property \"" + property + "\" of "
+                + clazz_.getName() + " has no ordered index");
+    
+    uint64_t lowKey = getKey(index, low);
+    uint64_t highKey = getKey(index, high);
+    result.clear();
+    
+    set<pair<uint64_t, void*> >::const_iterator ite =
+            index.entries.lower_bound(make_pair(lowKey, (void*)NULL));
+    for (; ite != index.entries.end() && ite->first <= highKey; ++ite)
+        result.push_back(ite->second);
+}
+
+
+ObjectStore::~ObjectStore()
+{
+    for (size_t i = 0; i < indexes_.size(); i++)
+        delete indexes_[i];
+}
+
+
+ObjectStore::Index& ObjectStore::getIndex(const string& property)
+{
+    const Property& prop = clazz_.getProperty(property);
+    for (size_t i = 0; i < indexes_.size(); i++)
+    {
+        if (indexes_[i]->property == &prop)
+            return *indexes_[i];
+    }
+    throw QueryException("Property \"" + property + "\" of "
+            + clazz_.getName() + " is not indexed");
+}
+
+
+uint64_t ObjectStore::getKey(const Index& index, void* object) const
+{
+    if (index.offset >= 0)
+        return getSortKey(static_cast<char*>(object) + index.offset,
+                *index.type);
+    
+    Variant self(object, clazz_, 0);
+    Variant value = index.property->getData(self);
+    return getSortKey(value.getAddress(), *index.type);
+}
+
+
+uint64_t ObjectStore::getKey(const Index& index, const Variant& value) const
+{
+    if (&value.getType() != index.type)
+        throw VariantTypeException(value.getType(), *index.type);
+    return getSortKey(value.getAddress(), *index.type);
+}
+
+
+void ObjectStore::addEntry(Index& index, void* object, size_t slot)
+{
+    uint64_t key = getKey(index, object);
+    index.keys[slot] = key;
+    
+    if (index.kind == HashIndex)
+        index.buckets[key].push_back(object);
+    else
+        index.entries.insert(make_pair(key, object));
+}
+
+
+void ObjectStore::removeEntry(Index& index, void* object, size_t slot)
+{
+    uint64_t key = index.keys[slot];
+    
+    if (index.kind == OrderedIndex)
+    {
+        index.entries.erase(make_pair(key, object));
+        return;
+    }
+    
+    unordered_map<uint64_t, Bucket>::iterator ite = index.buckets.find(key);
+    Bucket& bucket = ite->second;
+    *std::find(bucket.begin(), bucket.end(), object) = bucket.back();
+    bucket.pop_back();
+    if (bucket.empty())
+        index.buckets.erase(ite);
+}
+
+
+void ObjectStore::propertiesChanged(const Variant& object,
+                                    const vector<const Property*>& properties)
+{
+    void* address = object.getAddress();
+    size_t slot = slots_.find(address)->second;
+    
+    for (size_t i = 0; i < indexes_.size(); i++)
+    {
+        Index& index = *indexes_[i];
+        if (std::find(properties.begin(), properties.end(), index.property)
+                == properties.end())
+            continue;
+        removeEntry(index, address, slot);
+        addEntry(index, address, slot);
+    }
+}
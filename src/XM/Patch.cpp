@@ -0,0 +1,287 @@
+/******************************************************************************      
+ *      Extended Mirror: Patch.cpp                                            *
+ ******************************************************************************
+ *      Copyright (c) 2012-2015, Manuele Finocchiaro                          *
+ *      All rights reserved.                                                  *
+ ******************************************************************************
+ * Redistribution and use in source and binary forms, with or without         *
+ * modification, are permitted provided that the following conditions         *
+ * are met:                                                                   *
+ *                                                                            *
+ *    1. Redistributions of source code must retain the above copyright       *
+ *       notice, this list of conditions and the following disclaimer.        *
+ *                                                                            *
+ *    2. Redistributions in binary form must reproduce the above copyright    *
+ *       notice, this list of conditions and the following disclaimer in      *
+ *       the documentation and/or other materials provided with the           *
+ *       distribution.                                                        *
+ *                                                                            *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"* 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE  *
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE *
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE  *
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR        *
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF       *
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS   *
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN    *
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)    *
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF     *
+ * THE POSSIBILITY OF SUCH DAMAGE.                                            *
+ *****************************************************************************/
+
+
+#include <XM/xMirror.hpp>
+#include <XM/Patch.hpp>
+#include <XM/Hash.hpp>
+#include <XM/Exceptions/SerializationException.hpp>
+#include <XM/Exceptions/VariantCostnessException.hpp>
+
+#include <cstring>
+
+using namespace std;
+using namespace xm;
+
+
+namespace {
+
+void writeIndex(uint32_t index, OutStream& out)
+{
+    // LEB128
+    unsigned char bytes[5];
+    size_t size = 0;
+    do
+    {
+        bytes[size] = index & 0x7F;
+        index >>= 7;
+        if (index)
+            bytes[size] |= 0x80;
+        size ++;
+    }
+    while (index);
+    out.write(bytes, size);
+}
+
+
+uint32_t readIndex(InStream& in)
+{
+    uint32_t index = 0;
+    for (int shift = 0; shift < 35; shift += 7)
+    {
+        unsigned char byte;
+        in.read(&byte, 1);
+        index |= static_cast<uint32_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+            return index;
+    }
+    throw SerializationException("Corrupted patch");
+}
+
+
+// Tells whether the data of a field is patched property by property. The
+// compound classes, containers included, are patched as whole values.
+bool isNested(const ClassLayout::Field& field)
+{
+    return field.offset >= 0
+            && field.property->getType().getCategory() == Type::Class;
+}
+
+
+bool equalFields(const char* obj1,
+                 const char* obj2,
+                 const Class& clazz,
+                 const ClassLayout::Field& field)
+{
+    const Type& type = field.property->getType();
+    if (field.offset >= 0)
+        return equals(obj1 + field.offset, obj2 + field.offset, type);
+    
+    // go through the getter
+    Variant value1 = field.property->getData(
+            Variant(const_cast<char*>(obj1), clazz, 0));
+    Variant value2 = field.property->getData(
+            Variant(const_cast<char*>(obj2), clazz, 0));
+    return equals(value1, value2);
+}
+
+
+void writeField(const char* obj,
+                const Class& clazz,
+                const ClassLayout::Field& field,
+                OutStream& out)
+{
+    if (field.offset >= 0)
+    {
+        serializeValue(Variant(const_cast<char*>(obj + field.offset),
+                field.property->getType(), 0), out);
+    }
+    else
+    {
+        serializeValue(field.property->getData(
+                Variant(const_cast<char*>(obj), clazz, 0)), out);
+    }
+}
+
+
+bool diffObjects(const char* from,
+                 const char* to,
+                 const Class& clazz,
+                 OutStream& out);
+
+
+// Write a changed field of the object.
+void diffField(const char* from,
+               const char* to,
+               const Class& clazz,
+               size_t index,
+               OutStream& out)
+{
+    const ClassLayout::Field& field = clazz.getLayout().getFields()[index];
+    writeIndex(index + 1, out);
+    if (isNested(field))
+    {
+        diffObjects(from + field.offset, to + field.offset,
+                dynamic_cast<const Class&>(field.property->getType()), out);
+    }
+    else
+        writeField(to, clazz, field, out);
+}
+
+
+bool diffObjects(const char* from,
+                 const char* to,
+                 const Class& clazz,
+                 OutStream& out)
+{
+    const ClassLayout& layout = clazz.getLayout();
+    const ClassLayout::Field_Vector& fields = layout.getFields();
+    const ClassLayout::Run_Vector& runs = layout.getRuns();
+    bool changed = false;
+    
+    size_t run = 0;
+    size_t i = 0;
+    while (i < fields.size())
+    {
+        // whole runs are compared first, their fields only if they differ
+        if (run < runs.size() && runs[run].firstField == i)
+        {
+            const ClassLayout::Run& current = runs[run];
+            if (memcmp(from + current.offset, to + current.offset,
+                    current.size) != 0)
+            {
+                for (size_t j = i; j < i + current.fieldCount; j++)
+                {
+                    size_t offset = fields[j].offset;
+                    if (memcmp(from + offset, to + offset,
+                            fields[j].property->getType().getSize()) != 0)
+                    {
+                        diffField(from, to, clazz, j, out);
+                        changed = true;
+                    }
+                }
+            }
+            i += current.fieldCount;
+            run ++;
+            continue;
+        }
+        
+        if (!equalFields(from, to, clazz, fields[i]))
+        {
+            diffField(from, to, clazz, i, out);
+            changed = true;
+        }
+        i ++;
+    }
+    
+    writeIndex(0, out);
+    return changed;
+}
+
+
+void applyObject(InStream& in, char* obj, const Class& clazz)
+{
+    const ClassLayout::Field_Vector& fields = clazz.getLayout().getFields();
+    
+    uint32_t index = readIndex(in);
+    while (index != 0)
+    {
+        if (index > fields.size())
+            throw SerializationException("Corrupted patch for class "
+                    + clazz.getName());
+        
+        const ClassLayout::Field& field = fields[index - 1];
+        const Property& property = *field.property;
+        if (isNested(field))
+        {
+            applyObject(in, obj + field.offset,
+                    dynamic_cast<const Class&>(property.getType()));
+        }
+        else if (field.offset >= 0)
+        {
+            deserializeValue(Variant(obj + field.offset, property.getType(),
+                    0), in);
+        }
+        else
+        {
+            // read into a copy of the current value, then go through the
+            // setter
+            Variant self(obj, clazz, 0);
+            Variant value = property.getData(self);
+            if (value.isReference() || value.isConst())
+            {
+                Variant ref(value.getAddress(), value.getType(), 0);
+                value = Variant(const_cast<const Variant&>(ref));
+            }
+            
+            deserializeValue(value, in);
+            
+            if (property.getFlags() & Property::Settable)
+                property.setData(self, value);
+        }
+        index = readIndex(in);
+    }
+}
+
+
+const Class& getObjectClass(const Variant& object)
+{
+    const Class* clazz = dynamic_cast<const Class*>(&object.getType());
+    if (!clazz)
+        throw SerializationException("Cannot patch non class type "
+                + object.getType().getName());
+    return *clazz;
+}
+
+} // namespace
+
+
+bool xm::diff(const Variant& from, const Variant& to, OutStream& out)
+{
+    const Class& clazz = getObjectClass(from);
+    if (&to.getType() != &clazz)
+        throw SerializationException("Cannot diff instances of different "
+                "classes " + clazz.getName() + " and "
+                + to.getType().getName());
+    
+    uint64_t fingerprint = clazz.getLayout().getFingerprint();
+    out.write(&fingerprint, sizeof(fingerprint));
+    
+    return diffObjects(static_cast<const char*>(from.getAddress()),
+            static_cast<const char*>(to.getAddress()), clazz, out);
+}
+
+
+void xm::apply(InStream& patch, const Variant& target)
+{
+    const Class& clazz = getObjectClass(target);
+    
+    if (target.isConst())
+        throw VariantCostnessException(clazz);
+    
+    uint64_t fingerprint;
+    patch.read(&fingerprint, sizeof(fingerprint));
+    if (fingerprint != clazz.getLayout().getFingerprint())
+        throw SerializationException("Schema fingerprint mismatch for class "
+                + clazz.getName());
+    
+    applyObject(patch, static_cast<char*>(target.getAddress()), clazz);
+}
@@ -37,9 +37,12 @@ using namespace xm;
 
 PrimitiveType::PrimitiveType(const string& name,
                              size_t size, 
-                             const type_info& cppType)
+                             const type_info& cppType,
+                             Kind kind)
     : Item(name),
-      Type(size, cppType)
+      Type(size, cppType),
+      kind_(kind),
+      enum_(NULL)
 {
     
 }
@@ -51,6 +54,24 @@ Type::Category PrimitiveType::getCategory() const
 }
 
 
+PrimitiveType::Kind PrimitiveType::getKind() const
+{
+    return kind_;
+}
+
+
+const Enum* PrimitiveType::getEnum() const
+{
+    return enum_;
+}
+
+
+void PrimitiveType::setEnum(const Enum& xmEnum)
+{
+    enum_ = &xmEnum;
+}
+
+
 PrimitiveType::~PrimitiveType()
 {
     
@@ -120,8 +120,19 @@ void Property::setData(const Variant& self, const Variant& data) const
 };
 
 
+std::ptrdiff_t Property::getOffset() const
+{
+    return -1;
+}
+
+
 Item::Category Property::getItemCategory() const
 {
     return PropertyItem;
 }
 
+
+void Property::notifySet(const Variant& self) const
+{
+    ChangeTracker::notifySet(self.getAddress(), *this);
+}
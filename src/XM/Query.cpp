@@ -0,0 +1,705 @@
+/******************************************************************************      
+ *      Extended Mirror: Query.cpp                                            *
+ ******************************************************************************
+ *      Copyright (c) 2012-2015, Manuele Finocchiaro                          *
+ *      All rights reserved.                                                  *
+ ******************************************************************************
+ * Redistribution and use in source and binary forms, with or without         *
+ * modification, are permitted provided that the following conditions         *
+ * are met:                                                                   *
+ *                                                                            *
+ *    1. Redistributions of source code must retain the above copyright       *
+ *       notice, this list of conditions and the following disclaimer.        *
+ *                                                                            *
+ *    2. Redistributions in binary form must reproduce the above copyright    *
+ *       notice, this list of conditions and the following disclaimer in      *
+ *       the documentation and/or other materials provided with the           *
+ *       distribution.                                                        *
+ *                                                                            *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"* 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE  *
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE *
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE  *
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR        *
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF       *
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS   *
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN    *
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)    *
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF     *
+ * THE POSSIBILITY OF SUCH DAMAGE.                                            *
+ *****************************************************************************/
+
+
+#include <XM/xMirror.hpp>
+#include <XM/Query.hpp>
+#include <XM/Exceptions/QueryException.hpp>
+
+#include <cctype>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <thread>
+#include <type_traits>
+
+using namespace std;
+using namespace xm;
+
+
+namespace {
+
+template<typename T>
+long long loadInteger(const char* data)
+{
+    T value;
+    memcpy(&value, data, sizeof(T));
+    return static_cast<long long>(value);
+}
+
+
+template<typename T>
+double loadFloating(const char* data)
+{
+    T value;
+    memcpy(&value, data, sizeof(T));
+    return static_cast<double>(value);
+}
+
+
+typedef long long (*IntegerLoader)(const char*);
+typedef double (*FloatingLoader)(const char*);
+
+
+struct Loaders
+{
+    IntegerLoader integer;
+    FloatingLoader floating;
+    bool isUnsigned;
+};
+
+
+template<typename T>
+Loaders getLoaders()
+{
+    Loaders loaders = {&loadInteger<T>, &loadFloating<T>,
+            is_unsigned<T>::value};
+    return loaders;
+}
+
+
+// Select the loaders of a primitive type.
+bool selectLoaders(const PrimitiveType& type, Loaders& loaders)
+{
+    switch (type.getKind())
+    {
+        case PrimitiveType::Bool: loaders = getLoaders<bool>(); break;
+        case PrimitiveType::Char: loaders = getLoaders<char>(); break;
+        case PrimitiveType::WChar: loaders = getLoaders<wchar_t>(); break;
+        case PrimitiveType::Short: loaders = getLoaders<short>(); break;
+        case PrimitiveType::Int: loaders = getLoaders<int>(); break;
+        case PrimitiveType::Long: loaders = getLoaders<long>(); break;
+        case PrimitiveType::Float: loaders = getLoaders<float>(); break;
+        case PrimitiveType::Double: loaders = getLoaders<double>(); break;
+        case PrimitiveType::UChar: loaders = getLoaders<uchar>(); break;
+        case PrimitiveType::UShort: loaders = getLoaders<ushort>(); break;
+        case PrimitiveType::UInt: loaders = getLoaders<uint>(); break;
+        case PrimitiveType::ULong: loaders = getLoaders<ulong>(); break;
+        default:
+            // enumerations, by size and signedness
+            if (type.getEnum() && !type.getEnum()->isSigned())
+            {
+                switch (type.getSize())
+                {
+                    case 1: loaders = getLoaders<uchar>(); break;
+                    case 2: loaders = getLoaders<ushort>(); break;
+                    case 4: loaders = getLoaders<uint>(); break;
+                    case 8: loaders = getLoaders<long long>(); break;
+                    default: return false;
+                }
+                break;
+            }
+            switch (type.getSize())
+            {
+                case 1: loaders = getLoaders<signed char>(); break;
+                case 2: loaders = getLoaders<short>(); break;
+                case 4: loaders = getLoaders<int>(); break;
+                case 8: loaders = getLoaders<long long>(); break;
+                default: return false;
+            }
+    }
+    return true;
+}
+
+
+template<typename T>
+bool compare(T lhs, T rhs, int comparison)
+{
+    switch (comparison)
+    {
+        case 0: return lhs == rhs;
+        case 1: return lhs != rhs;
+        case 2: return lhs < rhs;
+        case 3: return lhs <= rhs;
+        case 4: return lhs > rhs;
+        default: return lhs >= rhs;
+    }
+}
+
+
+// Compare two integers of which at least one is unsigned, both loaded as
+// long long: a negative signed value is less than any unsigned one, the
+// others compare as unsigned.
+bool compareUnsigned(long long lhs,
+                     bool lhsUnsigned,
+                     long long rhs,
+                     bool rhsUnsigned,
+                     int comparison)
+{
+    if (!lhsUnsigned && lhs < 0)
+        return compare(0, 1, comparison);
+    if (!rhsUnsigned && rhs < 0)
+        return compare(1, 0, comparison);
+    return compare(static_cast<unsigned long long>(lhs),
+                   static_cast<unsigned long long>(rhs), comparison);
+}
+
+} // namespace
+
+
+/**
+ * Recursive descent parser of the predicates, building the nodes of a Query.
+ */
+class Query::Parser
+{
+public:
+    Parser(const Class& clazz, vector<Node>& nodes, const string& predicate)
+        : class_(clazz), nodes_(nodes), text_(predicate), pos_(0)
+    {
+    }
+    
+    void parse()
+    {
+        parseOr();
+        skipWhitespace();
+        if (pos_ != text_.size())
+            error("Unexpected character");
+    }
+    
+    // Parse a text made of a single property path.
+    Operand parsePath()
+    {
+        Operand operand = parseOperand();
+        skipWhitespace();
+        if (operand.constant || pos_ != text_.size())
+            error("Expected a property");
+        return operand;
+    }
+    
+private:
+    size_t parseOr()
+    {
+        size_t left = parseAnd();
+        while (accept("||"))
+            left = addNode(OrNode, left, parseAnd());
+        return left;
+    }
+    
+    size_t parseAnd()
+    {
+        size_t left = parseUnary();
+        while (accept("&&"))
+            left = addNode(AndNode, left, parseUnary());
+        return left;
+    }
+    
+    size_t parseUnary()
+    {
+        if (accept("!"))
+            return addNode(NotNode, parseUnary(), 0);
+        if (accept("("))
+        {
+            size_t node = parseOr();
+            if (!accept(")"))
+                error("Expected ')'");
+            return node;
+        }
+        return parseComparison();
+    }
+    
+    size_t parseComparison()
+    {
+        Node node;
+        node.left = node.right = 0;
+        node.comparison = Equal;
+        node.lhs = parseOperand();
+        
+        static const char* operators[] = {"==", "!=", "<=", ">=", "<", ">"};
+        static const Comparison comparisons[] =
+                {Equal, NotEqual, LessEqual, GreaterEqual, Less, Greater};
+        int op = -1;
+        for (int i = 0; i < 6 && op < 0; i++)
+        {
+            if (accept(operators[i]))
+                op = i;
+        }
+        
+        if (op < 0)
+        {
+            // a single operand is tested against zero
+            if (node.lhs.constant || !node.lhs.key.empty())
+                error("Expected a property");
+            node.kind = TestNode;
+            node.floating = node.lhs.floating;
+            node.isUnsigned = node.lhs.isUnsigned;
+        }
+        else
+        {
+            node.kind = CompareNode;
+            node.comparison = comparisons[op];
+            node.rhs = parseOperand();
+            resolveKey(node.lhs, node.rhs);
+            resolveKey(node.rhs, node.lhs);
+            node.floating = node.lhs.floating || node.rhs.floating;
+            node.isUnsigned = node.lhs.isUnsigned || node.rhs.isUnsigned;
+        }
+        
+        nodes_.push_back(node);
+        return nodes_.size() - 1;
+    }
+    
+    Operand parseOperand()
+    {
+        skipWhitespace();
+        if (pos_ == text_.size())
+            error("Expected an operand");
+        
+        Operand operand;
+        operand.constant = true;
+        operand.floating = false;
+        operand.isUnsigned = false;
+        operand.integerValue = 0;
+        operand.floatingValue = 0;
+        operand.loadInteger = NULL;
+        operand.loadFloating = NULL;
+        operand.type = NULL;
+        
+        char c = text_[pos_];
+        if (c == '"' || c == '\'')
+        {
+            // quoted enumeration key
+            size_t end = text_.find(c, pos_ + 1);
+            if (end == string::npos)
+                error("Unterminated string");
+            operand.key = text_.substr(pos_ + 1, end - pos_ - 1);
+            pos_ = end + 1;
+        }
+        else if (c == '-' || c == '.' || isdigit(c))
+        {
+            const char* start = text_.c_str() + pos_;
+            char* end;
+            double value = strtod(start, &end);
+            if (end == start)
+                error("Invalid number");
+            string number(start, end - start);
+            pos_ += end - start;
+            
+            if (number.find_first_of(".eE") != string::npos)
+            {
+                operand.floating = true;
+                operand.floatingValue = value;
+            }
+            else if (number[0] == '-')
+            {
+                operand.integerValue = strtoll(number.c_str(), NULL, 10);
+                operand.floatingValue = operand.integerValue;
+            }
+            else
+            {
+                // literals above the range of long long are unsigned
+                unsigned long long integer
+                        = strtoull(number.c_str(), NULL, 10);
+                operand.isUnsigned = integer > LLONG_MAX;
+                operand.integerValue = static_cast<long long>(integer);
+                operand.floatingValue = value;
+            }
+        }
+        else if (isalpha(c) || c == '_')
+        {
+            size_t start = pos_;
+            while (pos_ < text_.size() && (isalnum(text_[pos_])
+                   || text_[pos_] == '_' || text_[pos_] == '.'
+                   || text_[pos_] == ':'))
+                pos_ ++;
+            string identifier = text_.substr(start, pos_ - start);
+            
+            if (identifier == "true" || identifier == "false")
+            {
+                operand.integerValue = identifier == "true";
+                operand.floatingValue = operand.integerValue;
+            }
+            else if (!resolvePath(identifier, operand))
+                operand.key = identifier;
+        }
+        else
+            error("Unexpected character");
+        
+        return operand;
+    }
+    
+    // Resolve a property path into the steps to reach its value.
+    bool resolvePath(const string& path, Operand& operand)
+    {
+        const Class* clazz = &class_;
+        size_t start = 0;
+        while (true)
+        {
+            if (!clazz)
+                return false;
+            
+            size_t end = path.find('.', start);
+            if (end == string::npos)
+                end = path.size();
+            
+            const ClassLayout& layout = clazz->getLayout();
+            int index = layout.findField(path.c_str() + start, end - start);
+            if (index < 0)
+                return false;
+            const ClassLayout::Field& field = layout.getFields()[index];
+            
+            if (field.offset >= 0 && !operand.steps.empty()
+                && !operand.steps.back().getter)
+            {
+                // consecutive offsets are merged
+                operand.steps.back().offset += field.offset;
+            }
+            else
+            {
+                Step step;
+                step.offset = field.offset >= 0 ? field.offset : 0;
+                step.getter = field.offset >= 0 ? NULL : field.property;
+                step.owner = clazz;
+                operand.steps.push_back(step);
+            }
+            
+            const Type& type = field.property->getType();
+            if (end == path.size())
+            {
+                Loaders loaders;
+                operand.type = dynamic_cast<const PrimitiveType*>(&type);
+                if (!operand.type || !selectLoaders(*operand.type, loaders))
+                    error("Property " + path + " is not of primitive type");
+                operand.loadInteger = loaders.integer;
+                operand.loadFloating = loaders.floating;
+                operand.isUnsigned = loaders.isUnsigned;
+                
+                operand.constant = false;
+                PrimitiveType::Kind kind = operand.type->getKind();
+                operand.floating = kind == PrimitiveType::Float
+                        || kind == PrimitiveType::Double;
+                return true;
+            }
+            
+            clazz = dynamic_cast<const Class*>(&type);
+            start = end + 1;
+        }
+    }
+    
+    // Resolve an enumeration key compared with a property of enumeration
+    // type.
+    void resolveKey(Operand& operand, const Operand& other)
+    {
+        if (operand.key.empty())
+            return;
+        
+        const Enum* xmEnum = other.type ? other.type->getEnum() : NULL;
+        if (!xmEnum)
+            error("Unknown property " + operand.key);
+        
+        size_t separator = operand.key.rfind(':');
+        string key = separator == string::npos ? operand.key
+                : operand.key.substr(separator + 1);
+        long long value;
+        if (!xmEnum->tryGetValue(key, value))
+            error("Unknown key " + key + " of " + xmEnum->getName());
+        
+        operand.integerValue = value;
+        operand.floatingValue = operand.integerValue;
+        operand.key.clear();
+    }
+    
+    size_t addNode(NodeKind kind, size_t left, size_t right)
+    {
+        Node node;
+        node.kind = kind;
+        node.left = left;
+        node.right = right;
+        node.comparison = Equal;
+        node.floating = false;
+        node.isUnsigned = false;
+        nodes_.push_back(node);
+        return nodes_.size() - 1;
+    }
+    
+    bool accept(const char* token)
+    {
+        skipWhitespace();
+        size_t length = strlen(token);
+        if (text_.compare(pos_, length, token) != 0)
+            return false;
+        
+        // "<" and "!" must not match "<=" and "!="
+        if (length == 1 && pos_ + 1 < text_.size() && text_[pos_ + 1] == '='
+            && (token[0] == '<' || token[0] == '>' || token[0] == '!'))
+            return false;
+        
+        pos_ += length;
+        return true;
+    }
+    
+    void skipWhitespace()
+    {
+        while (pos_ < text_.size() && isspace(text_[pos_]))
+            pos_ ++;
+    }
+    
+    void error(const string& msg) const
+    {
+        char position[32];
+        sprintf(position, "%lu", static_cast<ulong>(pos_));
+        throw QueryException(msg + " at position " + position
+                + " of query \"" + text_ + "\"");
+    }
+    
+    const Class& class_;
+    vector<Node>& nodes_;
+    const string& text_;
+    size_t pos_;
+};
+
+
+Query::Query(const Class& clazz, const string& predicate)
+    : class_(&clazz)
+{
+    Parser parser(clazz, nodes_, predicate);
+    parser.parse();
+}
+
+
+const Class& Query::getClass() const
+{
+    return *class_;
+}
+
+
+bool Query::matches(const void* object) const
+{
+    return evaluate(nodes_.size() - 1, static_cast<const char*>(object));
+}
+
+
+bool Query::matches(const Variant& object) const
+{
+    checkClass(object.getType());
+    return matches(object.getAddress());
+}
+
+
+void Query::filter(const void* objects,
+                   size_t count,
+                   vector<size_t>& indexes,
+                   unsigned threads) const
+{
+    const char* data = static_cast<const char*>(objects);
+    size_t stride = class_->getSize();
+    indexes.clear();
+    
+    if (threads == 0)
+        threads = thread::hardware_concurrency();
+    if (count < ParallelThreshold || threads <= 1)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            if (matches(data + i * stride))
+                indexes.push_back(i);
+        }
+        return;
+    }
+    
+    // each thread filters a contiguous chunk, the results are then joined
+    // in order
+    size_t chunk = (count + threads - 1) / threads;
+    vector<vector<size_t> > results(threads);
+    vector<exception_ptr> errors(threads);
+    vector<thread> workers;
+    for (unsigned t = 0; t < threads; t++)
+    {
+        workers.push_back(thread([&, t]()
+        {
+            try
+            {
+                size_t end = min(count, (t + 1) * chunk);
+                for (size_t i = t * chunk; i < end; i++)
+                {
+                    if (matches(data + i * stride))
+                        results[t].push_back(i);
+                }
+            }
+            catch (...)
+            {
+                errors[t] = current_exception();
+            }
+        }));
+    }
+    
+    for (unsigned t = 0; t < threads; t++)
+        workers[t].join();
+    
+    for (unsigned t = 0; t < threads; t++)
+    {
+        if (errors[t])
+            rethrow_exception(errors[t]);
+        indexes.insert(indexes.end(), results[t].begin(), results[t].end());
+    }
+}
+
+
+void Query::checkClass(const Type& type) const
+{
+    if (&type != class_)
+        throw QueryException("Query on " + class_->getName()
+                + " cannot be evaluated on instances of " + type.getName());
+}
+
+
+bool Query::evaluate(size_t node, const char* obj) const
+{
+    const Node& current = nodes_[node];
+    switch (current.kind)
+    {
+        case AndNode:
+            return evaluate(current.left, obj) && evaluate(current.right, obj);
+            
+        case OrNode:
+            return evaluate(current.left, obj) || evaluate(current.right, obj);
+            
+        case NotNode:
+            return !evaluate(current.left, obj);
+            
+        case TestNode:
+            if (current.floating)
+                return evaluateFloating(current.lhs, obj) != 0;
+            return evaluateInteger(current.lhs, obj) != 0;
+            
+        default:
+            if (current.floating)
+                return compare(evaluateFloating(current.lhs, obj),
+                        evaluateFloating(current.rhs, obj), current.comparison);
+            if (current.isUnsigned)
+                return compareUnsigned(evaluateInteger(current.lhs, obj),
+                        current.lhs.isUnsigned,
+                        evaluateInteger(current.rhs, obj),
+                        current.rhs.isUnsigned, current.comparison);
+            return compare(evaluateInteger(current.lhs, obj),
+                    evaluateInteger(current.rhs, obj), current.comparison);
+    }
+}
+
+
+long long Query::evaluateInteger(const Operand& operand, const char* obj) const
+{
+    if (operand.constant)
+        return operand.integerValue;
+    
+    // fields are read in place
+    if (operand.steps.size() == 1 && !operand.steps[0].getter)
+        return operand.loadInteger(obj + operand.steps[0].offset);
+    
+    Variant holder;
+    return operand.loadInteger(resolve(operand, obj, holder));
+}
+
+
+double Query::evaluateFloating(const Operand& operand, const char* obj) const
+{
+    if (operand.constant)
+        return operand.floatingValue;
+    
+    if (operand.steps.size() == 1 && !operand.steps[0].getter)
+        return operand.loadFloating(obj + operand.steps[0].offset);
+    
+    Variant holder;
+    return operand.loadFloating(resolve(operand, obj, holder));
+}
+
+
+const char* Query::resolve(const Operand& operand,
+                           const char* obj,
+                           Variant& holder) const
+{
+    for (size_t i = 0; i < operand.steps.size(); i++)
+    {
+        const Step& step = operand.steps[i];
+        if (step.getter)
+        {
+            holder = step.getter->getData(
+                    Variant(const_cast<char*>(obj), *step.owner, 0));
+            obj = static_cast<const char*>(holder.getAddress());
+        }
+        else
+            obj += step.offset;
+    }
+    return obj;
+}
+
+
+void Query::project(const string& path,
+                    const void* objects,
+                    const vector<size_t>& indexes,
+                    vector<long long>& column) const
+{
+    project_(path, objects, indexes, column);
+}
+
+
+void Query::project(const string& path,
+                    const void* objects,
+                    const vector<size_t>& indexes,
+                    vector<unsigned long long>& column) const
+{
+    project_(path, objects, indexes, column);
+}
+
+
+void Query::project(const string& path,
+                    const void* objects,
+                    const vector<size_t>& indexes,
+                    vector<double>& column) const
+{
+    project_(path, objects, indexes, column);
+}
+
+
+template<typename T>
+void Query::project_(const string& path,
+                     const void* objects,
+                     const vector<size_t>& indexes,
+                     vector<T>& column) const
+{
+    // a path adds no nodes to the query
+    vector<Node> nodes;
+    Parser parser(*class_, nodes, path);
+    Operand operand = parser.parsePath();
+    
+    const char* data = static_cast<const char*>(objects);
+    size_t stride = class_->getSize();
+    bool floating = operand.floating || is_floating_point<T>::value;
+    column.resize(indexes.size());
+    for (size_t i = 0; i < indexes.size(); i++)
+    {
+        const char* obj = data + indexes[i] * stride;
+        if (floating)
+            column[i] = static_cast<T>(evaluateFloating(operand, obj));
+        else
+            column[i] = static_cast<T>(evaluateInteger(operand, obj));
+    }
+}
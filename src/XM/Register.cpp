@@ -34,15 +34,136 @@
 #include <XM/xMirror.hpp>
 #include <XM/Exceptions/NotFoundException.hpp>
 
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+
 
 using namespace std;
 using namespace xm;
 
 
+namespace {
+
+// Guards the metadata: the changes are exclusive, the lookups are shared.
+// A reader only increments the counter unless a writer is active, the writers
+// are serialized by a mutex and wait for the readers to leave.
+struct MetadataLock
+{
+    MetadataLock() : readers(0), writing(false) {}
+    
+    mutex writers;
+    mutex waiting;
+    condition_variable released;
+    atomic<unsigned> readers;
+    atomic<bool> writing;
+};
+
+
+MetadataLock& getMetadataLock()
+{
+    static MetadataLock metadataLock;
+    return metadataLock;
+}
+
+
+// the locks held by the current thread: nested locks, and shared locks
+// within an exclusive one, leave the metadata lock alone
+thread_local unsigned exclusiveDepth = 0;
+thread_local unsigned sharedDepth = 0;
+
+
+void lockExclusive()
+{
+    if (exclusiveDepth++ > 0)
+        return;
+    
+    MetadataLock& lock = getMetadataLock();
+    lock.writers.lock();
+    lock.writing.store(true);
+    unique_lock<mutex> waiting(lock.waiting);
+    lock.released.wait(waiting, [&]() { return lock.readers.load() == 0; });
+}
+
+
+void unlockExclusive()
+{
+    if (--exclusiveDepth > 0)
+        return;
+    
+    MetadataLock& lock = getMetadataLock();
+    {
+        lock_guard<mutex> waiting(lock.waiting);
+        lock.writing.store(false);
+    }
+    lock.released.notify_all();
+    lock.writers.unlock();
+}
+
+
+// Leave the readers, waking a writer waiting for them.
+void leaveShared(MetadataLock& lock)
+{
+    lock.readers.fetch_sub(1);
+    if (lock.writing.load())
+    {
+        lock_guard<mutex> waiting(lock.waiting);
+        lock.released.notify_all();
+    }
+}
+
+
+void lockShared()
+{
+    if (exclusiveDepth > 0 || sharedDepth++ > 0)
+        return;
+    
+    MetadataLock& lock = getMetadataLock();
+    while (true)
+    {
+        lock.readers.fetch_add(1);
+        if (!lock.writing.load())
+            return;
+        
+        // back off until the writer is done
+        leaveShared(lock);
+        unique_lock<mutex> waiting(lock.waiting);
+        lock.released.wait(waiting, [&]() { return !lock.writing.load(); });
+    }
+}
+
+
+void unlockShared()
+{
+    if (exclusiveDepth > 0 || --sharedDepth > 0)
+        return;
+    leaveShared(getMetadataLock());
+}
+
+
+// Guards the registration state of the types and the queued types.
+mutex& getRegistrationMutex()
+{
+    static mutex registrationMutex;
+    return registrationMutex;
+}
+
+
+condition_variable& getRegistrationDone()
+{
+    static condition_variable registrationDone;
+    return registrationDone;
+}
+
+} // namespace
+
+
 Register& Register::getSingleton()
 {
-    static Register typeReg;
-    return typeReg;
+    // never destroyed: the metadata is released with the process
+    static Register* typeReg = new Register();
+    return *typeReg;
 }
 
 
@@ -53,7 +174,7 @@ Register::Register()
 
 const Type& Register::getType(const type_info& cppType) const
 {
-    const Type* type = ptrSet::findByKey(types_, cppType);
+    const Type* type = findType(cppType);
     if (type)
         return *type;
     else
@@ -61,6 +182,15 @@ const Type& Register::getType(const type_info& cppType) const
 }
 
 
+const Type* Register::findType(const type_info& cppType) const
+{
+    Lock lock(Lock::Shared);
+    unordered_map<type_index, Type*>::const_iterator ite =
+            typesById_.find(type_index(cppType));
+    return ite != typesById_.end() ? ite->second : NULL;
+}
+
+
 const Class& Register::getClass(const type_info& cppType) const
 {
     return dynamic_cast<const Class&>(getType(cppType));
@@ -72,6 +202,178 @@ Register::~Register()
 
 }
 
+
+void Register::enqueueType(const Type& (*registerFnc)())
+{
+    lock_guard<mutex> lock(getRegistrationMutex());
+    queuedTypes_.push_back(registerFnc);
+}
+
+
+void Register::initialize(unsigned threads)
+{
+    vector<const Type& (*)()> queue;
+    {
+        lock_guard<mutex> lock(getRegistrationMutex());
+        queue.swap(queuedTypes_);
+    }
+    
+    if (threads == 0)
+        threads = thread::hardware_concurrency();
+    if (threads > queue.size())
+        threads = queue.size();
+    if (threads <= 1)
+    {
+        for (size_t i = 0; i < queue.size(); i++)
+            queue[i]();
+        return;
+    }
+    
+    // each thread takes the next queued type, the types it depends on are
+    // registered by whichever thread needs them first
+    atomic<size_t> next(0);
+    vector<exception_ptr> errors(threads);
+    vector<thread> workers;
+    for (unsigned t = 0; t < threads; t++)
+    {
+        workers.push_back(thread([&, t]()
+        {
+            try
+            {
+                for (size_t i = next++; i < queue.size(); i = next++)
+                    queue[i]();
+            }
+            catch (...)
+            {
+                errors[t] = current_exception();
+            }
+        }));
+    }
+    
+    for (unsigned t = 0; t < threads; t++)
+        workers[t].join();
+    
+    for (unsigned t = 0; t < threads; t++)
+    {
+        if (errors[t])
+            rethrow_exception(errors[t]);
+    }
+}
+
+
+Register::TypeSlot::TypeSlot()
+    : type(NULL), partial(NULL), claimed(false)
+{
+}
+
+
+namespace {
+
+// the type each thread is waiting for
+map<thread::id, const void*> waitingThreads;
+
+
+// Whether waiting for the type of the slot would close a cycle of threads
+// waiting for each other.
+template<typename SlotT>
+bool closesCycle(const SlotT* slot)
+{
+    thread::id self = this_thread::get_id();
+    for (size_t i = 0; slot && i <= waitingThreads.size(); i++)
+    {
+        if (slot->owner == self)
+            return true;
+        map<thread::id, const void*>::const_iterator ite =
+                waitingThreads.find(slot->owner);
+        if (ite == waitingThreads.end())
+            return false;
+        slot = static_cast<const SlotT*>(ite->second);
+    }
+    return false;
+}
+
+} // namespace
+
+
+Type* Register::claimType_(TypeSlot& slot)
+{
+    unique_lock<mutex> lock(getRegistrationMutex());
+    thread::id self = this_thread::get_id();
+    while (true)
+    {
+        Type* type = slot.type.load(memory_order_relaxed);
+        if (type)
+            return type;
+        
+        if (!slot.claimed)
+        {
+            slot.claimed = true;
+            slot.owner = self;
+            return NULL;
+        }
+        
+        // recursive registrations, and registrations that would wait for
+        // themselves, get the type being defined
+        if (slot.owner == self || (slot.partial && closesCycle(&slot)))
+            return slot.partial;
+        
+        // the type of a cycle may not be created yet, the other threads of
+        // the cycle are woken to check whether they can take the types they
+        // wait for, so that the owner can complete it
+        waitingThreads[self] = &slot;
+        if (!slot.partial)
+            getRegistrationDone().notify_all();
+        getRegistrationDone().wait(lock);
+        waitingThreads.erase(self);
+    }
+}
+
+
+void Register::addType_(TypeSlot& slot, Type& type)
+{
+    {
+        Lock lock;
+        addItem(type);
+        types_.insert(&type);
+        typesById_[type_index(type.getId())] = &type;
+        Class* clazz = dynamic_cast<Class*>(&type);
+        if (clazz)
+            classes_.insert(clazz);
+    }
+    
+    lock_guard<mutex> lock(getRegistrationMutex());
+    slot.partial = &type;
+}
+
+
+void Register::releaseType_(TypeSlot& slot, Type& type)
+{
+    {
+        lock_guard<mutex> lock(getRegistrationMutex());
+        slot.type.store(&type, memory_order_release);
+    }
+    getRegistrationDone().notify_all();
+}
+
+
+Register::Lock::Lock(Mode mode)
+    : mode_(mode)
+{
+    if (mode_ == Shared)
+        lockShared();
+    else
+        lockExclusive();
+}
+
+
+Register::Lock::~Lock()
+{
+    if (mode_ == Shared)
+        unlockShared();
+    else
+        unlockExclusive();
+}
+
 XM_REGISTER_TYPE(void)
 XM_REGISTER_TYPE(bool)
 XM_REGISTER_TYPE(char)
@@ -84,3 +386,4 @@ XM_REGISTER_TYPE(uchar)
 XM_REGISTER_TYPE(ushort)
 XM_REGISTER_TYPE(uint)
 XM_REGISTER_TYPE(ulong)
+XM_REGISTER_TYPE(std::string)
@@ -0,0 +1,472 @@
+/******************************************************************************      
+ *      Extended Mirror: Serializer.cpp                                       *
+ ******************************************************************************
+ *      Copyright (c) 2012-2015, Manuele Finocchiaro                          *
+ *      All rights reserved.                                                  *
+ ******************************************************************************
+ * Redistribution and use in source and binary forms, with or without         *
+ * modification, are permitted provided that the following conditions         *
+ * are met:                                                                   *
+ *                                                                            *
+ *    1. Redistributions of source code must retain the above copyright       *
+ *       notice, this list of conditions and the following disclaimer.        *
+ *                                                                            *
+ *    2. Redistributions in binary form must reproduce the above copyright    *
+ *       notice, this list of conditions and the following disclaimer in      *
+ *       the documentation and/or other materials provided with the           *
+ *       distribution.                                                        *
+ *                                                                            *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"* 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE  *
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE *
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE  *
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR        *
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF       *
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS   *
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN    *
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)    *
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF     *
+ * THE POSSIBILITY OF SUCH DAMAGE.                                            *
+ *****************************************************************************/
+
+
+#include <XM/xMirror.hpp>
+#include <XM/Serializer.hpp>
+#include <XM/Exceptions/SerializationException.hpp>
+#include <XM/Exceptions/VariantCostnessException.hpp>
+
+using namespace std;
+using namespace xm;
+
+
+OutStream::~OutStream()
+{
+}
+
+
+size_t InStream::getRemaining() const
+{
+    return numeric_limits<size_t>::max();
+}
+
+
+InStream::~InStream()
+{
+}
+
+
+BufferOutStream::BufferOutStream(void* buffer, size_t capacity)
+    : buffer_(static_cast<char*>(buffer)), capacity_(capacity), size_(0)
+{
+}
+
+
+void BufferOutStream::write(const void* data, size_t size)
+{
+    if (capacity_ - size_ < size)
+        throw SerializationException("Serialization buffer overflow");
+    
+    memcpy(buffer_ + size_, data, size);
+    size_ += size;
+}
+
+
+size_t BufferOutStream::getSize() const
+{
+    return size_;
+}
+
+
+BufferInStream::BufferInStream(const void* buffer, size_t size)
+    : buffer_(static_cast<const char*>(buffer)), size_(size), position_(0)
+{
+}
+
+
+void BufferInStream::read(void* data, size_t size)
+{
+    if (size_ - position_ < size)
+        throw SerializationException("Unexpected end of serialized data");
+    
+    memcpy(data, buffer_ + position_, size);
+    position_ += size;
+}
+
+
+size_t BufferInStream::getRemaining() const
+{
+    return size_ - position_;
+}
+
+
+size_t BufferInStream::getPosition() const
+{
+    return position_;
+}
+
+
+namespace {
+
+void writeObject(const char* obj, const Class& clazz, OutStream& out);
+void readObject(char* obj, const Class& clazz, InStream& in);
+void writeData(const char* data, const Type& type, OutStream& out);
+void readData(char* data, const Type& type, InStream& in);
+
+
+// Writes the elements of an associative container, keys followed by their
+// mapped values.
+class ElementWriter : public Associative::Visitor
+{
+public:
+    ElementWriter(const Associative& associative, OutStream& out)
+        : associative_(associative), out_(out) {}
+    
+    void visit(const Variant& key, const Variant& mapped)
+    {
+        writeData(static_cast<const char*>(key.getAddress()),
+                associative_.getKeyType(), out_);
+        if (associative_.getMappedType())
+            writeData(static_cast<const char*>(mapped.getAddress()),
+                    *associative_.getMappedType(), out_);
+    }
+    
+private:
+    const Associative& associative_;
+    OutStream& out_;
+};
+
+
+// Containers are written as their number of elements followed by the
+// elements, the other compound classes through their properties.
+void writeCompound(const char* data, const CompoundClass& clazz,
+        OutStream& out)
+{
+    Variant self(const_cast<char*>(data), clazz, Variant::Const);
+    const Sequence* sequence = clazz.getSequence();
+    const Associative* associative = clazz.getAssociative();
+    if (sequence)
+    {
+        const Type& elementType = sequence->getElementType();
+        uint32_t count = sequence->getSize(self);
+        out.write(&count, sizeof(count));
+        if (count && sequence->isContiguous()
+                && ClassLayout::isPlainData(elementType))
+        {
+            out.write(sequence->getData(self),
+                    count * elementType.getSize());
+            return;
+        }
+        for (uint32_t i = 0; i < count; i++)
+            writeData(static_cast<const char*>(
+                    sequence->at(self, i).getAddress()), elementType, out);
+    }
+    else if (associative)
+    {
+        uint32_t count = associative->getSize(self);
+        out.write(&count, sizeof(count));
+        ElementWriter writer(*associative, out);
+        associative->forEach(self, writer);
+    }
+    else
+        writeObject(data, clazz, out);
+}
+
+
+void readCompound(char* data, const CompoundClass& clazz, InStream& in)
+{
+    Variant self(data, clazz, 0);
+    const Sequence* sequence = clazz.getSequence();
+    const Associative* associative = clazz.getAssociative();
+    if (sequence)
+    {
+        const Type& elementType = sequence->getElementType();
+        bool plain = sequence->isContiguous()
+                && ClassLayout::isPlainData(elementType);
+        uint32_t count;
+        in.read(&count, sizeof(count));
+        
+        // the count is not trusted further than the bytes left can hold, so
+        // that corrupt data cannot make it allocate without bounds
+        size_t remaining = in.getRemaining();
+        if (plain && count > remaining / elementType.getSize())
+            throw SerializationException("Unexpected end of serialized data");
+        sequence->clear(self);
+        sequence->reserve(self, min<size_t>(count, remaining));
+        for (uint32_t i = 0; i < count; i++)
+        {
+            Variant element = sequence->emplaceBack(self);
+            if (!plain)
+                readData(static_cast<char*>(element.getAddress()),
+                        elementType, in);
+        }
+        
+        // plain elements are read at once
+        if (count && plain)
+            in.read(sequence->getData(self), count * elementType.getSize());
+    }
+    else if (associative)
+    {
+        uint32_t count;
+        in.read(&count, sizeof(count));
+        associative->clear(self);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            Variant key = associative->createKey();
+            readData(static_cast<char*>(key.getAddress()),
+                    associative->getKeyType(), in);
+            associative->insert(self, key);
+            if (associative->getMappedType())
+            {
+                Variant mapped = associative->find(self, key);
+                readData(static_cast<char*>(mapped.getAddress()),
+                        *associative->getMappedType(), in);
+            }
+        }
+    }
+    else
+        readObject(data, clazz, in);
+}
+
+
+void writeData(const char* data, const Type& type, OutStream& out)
+{
+    switch (type.getCategory())
+    {
+        case Type::Primitive:
+            out.write(data, type.getSize());
+            break;
+            
+        case Type::Array:
+        {
+            const ArrayType& arrayType = dynamic_cast<const ArrayType&>(type);
+            const Type& elementType = arrayType.getArrayElementType();
+            uint32_t count = arrayType.getArraySize();
+            out.write(&count, sizeof(count));
+            
+            if (ClassLayout::isPlainData(elementType))
+                out.write(data, type.getSize());
+            else
+            {
+                for (uint32_t i = 0; i < count; i++)
+                    writeData(data + i * elementType.getSize(), elementType,
+                            out);
+            }
+            break;
+        }
+            
+        case Type::Class:
+            writeObject(data, dynamic_cast<const Class&>(type), out);
+            break;
+            
+        case Type::CompoundClass:
+            writeCompound(data, dynamic_cast<const CompoundClass&>(type),
+                    out);
+            break;
+            
+        case Type::String:
+        {
+            const string& str = *reinterpret_cast<const string*>(data);
+            uint32_t length = str.size();
+            out.write(&length, sizeof(length));
+            out.write(str.data(), length);
+            break;
+        }
+            
+        default:
+            // pointers are not serialized
+            break;
+    }
+}
+
+
+void readData(char* data, const Type& type, InStream& in)
+{
+    switch (type.getCategory())
+    {
+        case Type::Primitive:
+            in.read(data, type.getSize());
+            break;
+            
+        case Type::Array:
+        {
+            const ArrayType& arrayType = dynamic_cast<const ArrayType&>(type);
+            const Type& elementType = arrayType.getArrayElementType();
+            uint32_t count;
+            in.read(&count, sizeof(count));
+            if (count != arrayType.getArraySize())
+                throw SerializationException("Array size mismatch for type "
+                        + type.getName());
+            
+            if (ClassLayout::isPlainData(elementType))
+                in.read(data, type.getSize());
+            else
+            {
+                for (uint32_t i = 0; i < count; i++)
+                    readData(data + i * elementType.getSize(), elementType, in);
+            }
+            break;
+        }
+            
+        case Type::Class:
+            readObject(data, dynamic_cast<const Class&>(type), in);
+            break;
+            
+        case Type::CompoundClass:
+            readCompound(data, dynamic_cast<const CompoundClass&>(type), in);
+            break;
+            
+        case Type::String:
+        {
+            string& str = *reinterpret_cast<string*>(data);
+            uint32_t length;
+            in.read(&length, sizeof(length));
+            str.resize(length);
+            if (length)
+                in.read(&str[0], length);
+            break;
+        }
+            
+        default:
+            // pointers are not serialized
+            break;
+    }
+}
+
+
+void writeObject(const char* obj, const Class& clazz, OutStream& out)
+{
+    const ClassLayout& layout = clazz.getLayout();
+    const ClassLayout::Field_Vector& fields = layout.getFields();
+    const ClassLayout::Run_Vector& runs = layout.getRuns();
+    
+    size_t run = 0;
+    size_t i = 0;
+    while (i < fields.size())
+    {
+        // adjacent primitive fields are written at once
+        if (run < runs.size() && runs[run].firstField == i)
+        {
+            out.write(obj + runs[run].offset, runs[run].size);
+            i += runs[run].fieldCount;
+            run ++;
+            continue;
+        }
+        
+        const ClassLayout::Field& field = fields[i];
+        if (field.offset >= 0)
+        {
+            writeData(obj + field.offset, field.property->getType(), out);
+        }
+        else
+        {
+            // go through the getter
+            Variant self(const_cast<char*>(obj), clazz, 0);
+            Variant value = field.property->getData(self);
+            writeData(static_cast<const char*>(value.getAddress()),
+                    value.getType(), out);
+        }
+        i ++;
+    }
+}
+
+
+void readObject(char* obj, const Class& clazz, InStream& in)
+{
+    const ClassLayout& layout = clazz.getLayout();
+    const ClassLayout::Field_Vector& fields = layout.getFields();
+    const ClassLayout::Run_Vector& runs = layout.getRuns();
+    
+    size_t run = 0;
+    size_t i = 0;
+    while (i < fields.size())
+    {
+        if (run < runs.size() && runs[run].firstField == i)
+        {
+            in.read(obj + runs[run].offset, runs[run].size);
+            i += runs[run].fieldCount;
+            run ++;
+            continue;
+        }
+        
+        const ClassLayout::Field& field = fields[i];
+        if (field.offset >= 0)
+        {
+            readData(obj + field.offset, field.property->getType(), in);
+        }
+        else
+        {
+            // read into a copy of the current value, then go through the
+            // setter
+            Variant self(obj, clazz, 0);
+            Variant value = field.property->getData(self);
+            if (value.isReference() || value.isConst())
+            {
+                Variant ref(value.getAddress(), value.getType(), 0);
+                value = Variant(const_cast<const Variant&>(ref));
+            }
+            
+            readData(static_cast<char*>(value.getAddress()), value.getType(),
+                    in);
+            
+            if (field.property->getFlags() & Property::Settable)
+                field.property->setData(self, value);
+        }
+        i ++;
+    }
+}
+
+
+const Class& getObjectClass(const Variant& object)
+{
+    const Class* clazz = dynamic_cast<const Class*>(&object.getType());
+    if (!clazz)
+        throw SerializationException("Cannot serialize non class type "
+                + object.getType().getName());
+    return *clazz;
+}
+
+} // namespace
+
+
+void xm::serialize(const Variant& object, OutStream& out)
+{
+    const Class& clazz = getObjectClass(object);
+    
+    uint64_t fingerprint = clazz.getLayout().getFingerprint();
+    out.write(&fingerprint, sizeof(fingerprint));
+    
+    writeData(static_cast<const char*>(object.getAddress()), clazz, out);
+}
+
+
+void xm::deserialize(const Variant& object, InStream& in)
+{
+    const Class& clazz = getObjectClass(object);
+    
+    if (object.isConst())
+        throw VariantCostnessException(clazz);
+    
+    uint64_t fingerprint;
+    in.read(&fingerprint, sizeof(fingerprint));
+    if (fingerprint != clazz.getLayout().getFingerprint())
+        throw SerializationException("Schema fingerprint mismatch for class "
+                + clazz.getName());
+    
+    readData(static_cast<char*>(object.getAddress()), clazz, in);
+}
+
+
+void xm::serializeValue(const Variant& value, OutStream& out)
+{
+    writeData(static_cast<const char*>(value.getAddress()), value.getType(),
+            out);
+}
+
+
+void xm::deserializeValue(const Variant& value, InStream& in)
+{
+    if (value.isConst())
+        throw VariantCostnessException(value.getType());
+    
+    readData(static_cast<char*>(value.getAddress()), value.getType(), in);
+}
@@ -0,0 +1,237 @@
+/******************************************************************************      
+ *      Extended Mirror: Sort.cpp                                             *
+ ******************************************************************************
+ *      Copyright (c) 2012-2015, Manuele Finocchiaro                          *
+ *      All rights reserved.                                                  *
+ ******************************************************************************
+ * Redistribution and use in source and binary forms, with or without         *
+ * modification, are permitted provided that the following conditions         *
+ * are met:                                                                   *
+ *                                                                            *
+ *    1. Redistributions of source code must retain the above copyright       *
+ *       notice, this list of conditions and the following disclaimer.        *
+ *                                                                            *
+ *    2. Redistributions in binary form must reproduce the above copyright    *
+ *       notice, this list of conditions and the following disclaimer in      *
+ *       the documentation and/or other materials provided with the           *
+ *       distribution.                                                        *
+ *                                                                            *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"* 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE  *
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE *
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE  *
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR        *
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF       *
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS   *
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN    *
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)    *
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF     *
+ * THE POSSIBILITY OF SUCH DAMAGE.                                            *
+ *****************************************************************************/
+
+
+#include <XM/xMirror.hpp>
+#include <XM/Sort.hpp>
+
+#include <cstring>
+
+using namespace std;
+using namespace xm;
+
+
+namespace {
+
+template<typename T>
+T load(const char* data)
+{
+    T value;
+    memcpy(&value, data, sizeof(T));
+    return value;
+}
+
+
+uint64_t loadUnsigned(const char* data, size_t size)
+{
+    switch (size)
+    {
+        case 1: return load<uint8_t>(data);
+        case 2: return load<uint16_t>(data);
+        case 4: return load<uint32_t>(data);
+        default: return load<uint64_t>(data);
+    }
+}
+
+
+// Signed values are offset so that the minimum value maps to zero.
+uint64_t loadSigned(const char* data, size_t size)
+{
+    uint64_t bias = uint64_t(1) << (size * 8 - 1);
+    switch (size)
+    {
+        case 1: return load<int8_t>(data) + bias;
+        case 2: return load<int16_t>(data) + bias;
+        case 4: return load<int32_t>(data) + bias;
+        default: return load<int64_t>(data) + bias;
+    }
+}
+
+
+// Positive floating point values get the sign bit set, negative ones are
+// inverted, so that the bit patterns sort as the values.
+uint64_t loadFloating(const char* data, size_t size)
+{
+    uint64_t bits = loadUnsigned(data, size);
+    uint64_t sign = uint64_t(1) << (size * 8 - 1);
+    return bits & sign ? ~bits : bits | sign;
+}
+
+
+bool isSigned(const PrimitiveType& type)
+{
+    switch (type.getKind())
+    {
+        case PrimitiveType::Char:
+            return numeric_limits<char>::is_signed;
+        case PrimitiveType::WChar:
+            return numeric_limits<wchar_t>::is_signed;
+        case PrimitiveType::Short:
+        case PrimitiveType::Int:
+        case PrimitiveType::Long:
+            return true;
+        case PrimitiveType::Other:
+            // enumerations, by the signedness of their underlying type
+            return !type.getEnum() || type.getEnum()->isSigned();
+        default:
+            return false;
+    }
+}
+
+
+// Convert the values of a primitive into radix keys.
+void makeKeys(const char* values,
+              size_t stride,
+              size_t count,
+              const PrimitiveType& type,
+              SortOrder order,
+              vector<uint64_t>& keys)
+{
+    size_t size = type.getSize();
+    uint64_t mask = size < 8 ? (uint64_t(1) << (size * 8)) - 1 : ~uint64_t(0);
+    
+    keys.resize(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        uint64_t key = getSortKey(values + i * stride, type);
+        keys[i] = (order == Descending ? ~key : key) & mask;
+    }
+}
+
+
+// Stable LSD radix sort of the indexes by the keys of the indexed values.
+void radixSort(const vector<uint64_t>& keys,
+               size_t bytes,
+               vector<size_t>& indexes,
+               vector<size_t>& scratch)
+{
+    size_t count = indexes.size();
+    
+    // the histograms of all the bytes are computed in a single pass
+    vector<size_t> histograms(bytes * 256, 0);
+    for (size_t i = 0; i < count; i++)
+    {
+        uint64_t key = keys[i];
+        for (size_t b = 0; b < bytes; b++)
+            histograms[b * 256 + ((key >> (b * 8)) & 0xFF)] ++;
+    }
+    
+    scratch.resize(count);
+    for (size_t b = 0; b < bytes; b++)
+    {
+        size_t* histogram = &histograms[b * 256];
+        
+        // skip the byte if it is the same for all the keys
+        uint64_t first = (keys[indexes[0]] >> (b * 8)) & 0xFF;
+        if (histogram[first] == count)
+            continue;
+        
+        size_t offset = 0;
+        for (size_t digit = 0; digit < 256; digit++)
+        {
+            size_t digitCount = histogram[digit];
+            histogram[digit] = offset;
+            offset += digitCount;
+        }
+        
+        for (size_t i = 0; i < count; i++)
+        {
+            size_t index = indexes[i];
+            scratch[histogram[(keys[index] >> (b * 8)) & 0xFF]++] = index;
+        }
+        indexes.swap(scratch);
+    }
+}
+
+} // namespace
+
+
+uint64_t xm::getSortKey(const void* value, const PrimitiveType& type)
+{
+    const char* data = static_cast<const char*>(value);
+    size_t size = type.getSize();
+    PrimitiveType::Kind kind = type.getKind();
+    uint64_t mask = size < 8 ? (uint64_t(1) << (size * 8)) - 1 : ~uint64_t(0);
+    
+    if (kind == PrimitiveType::Float || kind == PrimitiveType::Double)
+        return loadFloating(data, size) & mask;
+    else if (isSigned(type))
+        return loadSigned(data, size) & mask;
+    else
+        return loadUnsigned(data, size);
+}
+
+
+void xm::sortIndexes(const Class& clazz,
+                     const void* objects,
+                     size_t count,
+                     const vector<SortKey>& keys,
+                     vector<size_t>& indexes)
+{
+    indexes.resize(count);
+    for (size_t i = 0; i < count; i++)
+        indexes[i] = i;
+    if (count < 2)
+        return;
+    
+    vector<uint64_t> radixKeys;
+    vector<size_t> scratch;
+    
+    // the least significant key is sorted first
+    for (size_t k = keys.size(); k > 0; k--)
+    {
+        const SortKey& key = keys[k - 1];
+        Column column(clazz.getProperty(key.property));
+        gather(clazz, objects, count, column);
+        
+        // arrays are sorted by each element, from the last one
+        const Type* elementType = &column.getType();
+        size_t elementCount = 1;
+        while (elementType->getCategory() == Type::Array)
+        {
+            const ArrayType* arrayType =
+                    dynamic_cast<const ArrayType*>(elementType);
+            elementCount *= arrayType->getArraySize();
+            elementType = &arrayType->getArrayElementType();
+        }
+        const PrimitiveType& primitive =
+                dynamic_cast<const PrimitiveType&>(*elementType);
+        
+        const char* values = static_cast<const char*>(column.getData());
+        size_t stride = column.getType().getSize();
+        for (size_t e = elementCount; e > 0; e--)
+        {
+            makeKeys(values + (e - 1) * primitive.getSize(), stride, count,
+                    primitive, key.order, radixKeys);
+            radixSort(radixKeys, primitive.getSize(), indexes, scratch);
+        }
+    }
+}
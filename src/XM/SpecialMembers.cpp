@@ -59,6 +59,14 @@ void CopyConstructor::copy(Variant& copy, const Variant& orig) const
 }
 
 
+void CopyConstructor::assign(Variant& copy, const Variant& orig) const
+{
+    (void)(copy);
+    (void)(orig);
+    throw NonCopyableException(getOwner());
+}
+
+
 Destructor::Destructor(const Class& owner)
     : Item("", owner), Member("", owner) {};
 
@@ -71,7 +79,7 @@ void Destructor::destroy(Variant& var) const
 
 
 RefCaster::RefCaster(const Class& dstClass, const Class& owner)
-    : Item("", owner), dstClass_(&dstClass)
+    : Item("", owner), dstClass_(&dstClass), offset_(-1)
 {
     if(owner.inheritsFrom(dstClass))
         castDir_ = UpCast;
@@ -88,6 +96,12 @@ CastDirection RefCaster::getCastDirection() const
 }
 
 
+std::ptrdiff_t RefCaster::getOffset() const
+{
+    return offset_;
+}
+
+
 const Class& RefCaster::getDstClass() const
 {
     return *dstClass_;
@@ -63,6 +63,9 @@ TemplArg::TemplArg(const TemplArg& other)
 
 TemplArg::TemplArg(TemplArg&& other)
 {
+    // leave other as a type argument, which owns nothing
+    category_ = TypeArg;
+    ptr_.type_ = NULL;
     std::swap(category_, other.category_);
     std::swap(ptr_, other.ptr_);
 }
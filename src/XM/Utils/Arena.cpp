@@ -0,0 +1,171 @@
+/******************************************************************************      
+ *      Extended Mirror: Arena.cpp                                            *
+ ******************************************************************************
+ *      Copyright (c) 2012-2015, Manuele Finocchiaro                          *
+ *      All rights reserved.                                                  *
+ ******************************************************************************
+ * Redistribution and use in source and binary forms, with or without         *
+ * modification, are permitted provided that the following conditions         *
+ * are met:                                                                   *
+ *                                                                            *
+ *    1. Redistributions of source code must retain the above copyright       *
+ *       notice, this list of conditions and the following disclaimer.        *
+ *                                                                            *
+ *    2. Redistributions in binary form must reproduce the above copyright    *
+ *       notice, this list of conditions and the following disclaimer in      *
+ *       the documentation and/or other materials provided with the           *
+ *       distribution.                                                        *
+ *                                                                            *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"* 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE  *
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE *
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE  *
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR        *
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF       *
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS   *
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN    *
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)    *
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF     *
+ * THE POSSIBILITY OF SUCH DAMAGE.                                            *
+ *****************************************************************************/
+
+
+#include <XM/Utils/Arena.hpp>
+
+using namespace std;
+using namespace xm;
+
+
+namespace
+{
+    const size_t Alignment = alignof(max_align_t);
+    
+    size_t alignUp(size_t size)
+    {
+        return (size + Alignment - 1) & ~(Alignment - 1);
+    }
+    
+    thread_local unsigned scopeDepth = 0;
+}
+
+
+const size_t Arena::BlockSize;
+
+
+Arena::Arena() : current_(NULL), limit_(NULL), reserved_(0), used_(0)
+{
+}
+
+
+void* Arena::allocate(size_t size)
+{
+    size = alignUp(size ? size : 1);
+    lock_guard<mutex> lock(mutex_);
+    
+    // big chunks get a block of their own, keeping the current one alive
+    if (size > BlockSize / 4)
+    {
+        used_ += size;
+        return allocateBlock(size);
+    }
+    
+    if (size > size_t(limit_ - current_))
+    {
+        current_ = allocateBlock(BlockSize);
+        limit_ = current_ + BlockSize;
+    }
+    
+    void* ptr = current_;
+    current_ += size;
+    used_ += size;
+    return ptr;
+}
+
+
+char* Arena::allocateBlock(size_t size)
+{
+    Block block;
+    block.begin = static_cast<char*>(::operator new(size));
+    block.end = block.begin + size;
+    blocks_.insert(upper_bound(blocks_.begin(), blocks_.end(), block,
+            BlockCmp()), block);
+    reserved_ += size;
+    return block.begin;
+}
+
+
+bool Arena::owns(const void* ptr) const
+{
+    Block key;
+    key.begin = key.end = static_cast<char*>(const_cast<void*>(ptr));
+    lock_guard<mutex> lock(mutex_);
+    
+    // find the last block starting at or before ptr
+    vector<Block>::const_iterator ite = upper_bound(blocks_.begin(),
+            blocks_.end(), key, BlockCmp());
+    if (ite == blocks_.begin())
+        return false;
+    --ite;
+    return less<const char*>()(key.begin, ite->end);
+}
+
+
+size_t Arena::getReservedSize() const
+{
+    lock_guard<mutex> lock(mutex_);
+    return reserved_;
+}
+
+
+size_t Arena::getUsedSize() const
+{
+    lock_guard<mutex> lock(mutex_);
+    return used_;
+}
+
+
+Arena& Arena::getMetadataArena()
+{
+    static Arena* arena = new Arena();
+    return *arena;
+}
+
+
+Arena::Scope::Scope()
+{
+    scopeDepth++;
+}
+
+
+Arena::Scope::~Scope()
+{
+    scopeDepth--;
+}
+
+
+bool Arena::isScopeActive()
+{
+    return scopeDepth != 0;
+}
+
+
+Arena::~Arena()
+{
+    for (size_t i = 0; i < blocks_.size(); i++)
+        ::operator delete(blocks_[i].begin);
+}
+
+
+void* xm::allocateMetadata(size_t size)
+{
+    if (Arena::isScopeActive())
+        return Arena::getMetadataArena().allocate(size);
+    return ::operator new(size);
+}
+
+
+void xm::releaseMetadata(void* ptr)
+{
+    if (ptr && !Arena::getMetadataArena().owns(ptr))
+        ::operator delete(ptr);
+}
@@ -43,12 +43,62 @@ Variant::Variant() : data_(NULL), type_(&::getType<void>()), flags_(Const)
 }
 
 
+Variant::Variant(void* data, const Type& type, char flags)
+ : data_(data), type_(&type), flags_(flags | Reference)
+{
+}
+
+
+Variant::Variant(string&& str)
+ : type_(&registerType<string>()), flags_(0)
+{
+    data_ = new (&storage_) string(std::move(str));
+}
+
+
+template<>
+void Variant::Initialize<string>::operator()(string& data)
+{
+    variant_.type_ = &registerType<string>();
+    if (variant_.flags_ & Reference)
+        variant_.data_ = &data;
+    else
+        variant_.initString(data);
+}
+
+
+void Variant::initString(const string& str)
+{
+    data_ = new (&storage_) string(str);
+}
+
+
+Variant Variant::toDynamic() const
+{
+    void* address = getAddress();
+    const Class* clazz = dynamic_cast<const Class*>(type_);
+    if (!clazz)
+        return getRefVariant();
+    
+    const Class& dynamicClass = clazz->getDynamicClass(address);
+    if (flags_ & Shared)
+    {
+        // keep sharing the ownership
+        Variant dynamic(*this);
+        dynamic.data_ = address;
+        dynamic.type_ = &dynamicClass;
+        return dynamic;
+    }
+    return Variant(address, dynamicClass, flags_ & Const);
+}
+
+
 Variant Variant::getRefVariant() const
 {
     Variant refVar;
     refVar.data_ = data_;
     refVar.type_ = type_;
-    refVar.flags_ = flags_ | Reference;
+    refVar.flags_ = (flags_ | Reference) & ~Shared;
     
     // need a const cast to make compiler choose the copy constructor
     // instead of the template constructor
@@ -64,7 +114,22 @@ Variant::Variant(const Variant& orig)
 
     std::size_t size = orig.type_->getSize();
 
-    if (orig.flags_ & CopyByRef)
+    if (orig.flags_ & Shared)
+    {
+        // share the ownership instead of copying the data
+        data_ = orig.data_;
+        type_ = orig.type_;
+        flags_ = orig.flags_;
+        new (&storage_) shared_ptr<const void>(orig.getOwner());
+    }
+    else if (orig.type_->getCategory() == Type::String
+        && !(orig.flags_ & CopyByRef))
+    {
+        // strings are copied directly into the inline storage
+        type_ = orig.type_;
+        initString(*static_cast<const string*>(orig.getAddress()));
+    }
+    else if (orig.flags_ & CopyByRef)
     {
         // copy by reference
         if (size > sizeof(data_))
@@ -108,9 +173,9 @@ Variant::Variant(const Variant& orig)
 
             // perform raw memory copy
             if (size > sizeof(data_))
-                std::memcpy(data_, orig.data_, size);
+                std::memcpy(data_, orig.getAddress(), size);
             else
-                std::memcpy(&data_, &orig.data_, size);
+                std::memcpy(&data_, orig.getAddress(), size);
         }
     }
 }
@@ -119,21 +184,48 @@ Variant::Variant(const Variant& orig)
 Variant::Variant(Variant&& orig) :
     data_(NULL), type_(&::getType<void>()), flags_(0)
 {
-    std::swap(data_, orig.data_);
-    std::swap(flags_, orig.flags_);
-    std::swap(type_, orig.type_);
+    moveFrom(orig);
 }
 
 
 const Variant& Variant::operator=(Variant other)
 {
-    std::swap(data_, other.data_);
-    std::swap(flags_, other.flags_);
-    std::swap(type_, other.type_);
+    release();
+    data_ = NULL;
+    type_ = &::getType<void>();
+    flags_ = 0;
+    moveFrom(other);
     return *this;
 }
 
 
+void Variant::moveFrom(Variant& orig)
+{
+    if (orig.holdsString())
+    {
+        // the inline storage cannot change owner, move the string instead
+        data_ = new (&storage_) string(
+                std::move(*static_cast<string*>(orig.data_)));
+        type_ = orig.type_;
+        flags_ = orig.flags_;
+    }
+    else if (orig.flags_ & Shared)
+    {
+        // the owner lives in the inline storage too
+        data_ = orig.data_;
+        type_ = orig.type_;
+        flags_ = orig.flags_;
+        new (&storage_) shared_ptr<const void>(std::move(orig.getOwner()));
+    }
+    else
+    {
+        std::swap(data_, orig.data_);
+        std::swap(flags_, orig.flags_);
+        std::swap(type_, orig.type_);
+    }
+}
+
+
 bool Variant::recursiveCast(Variant& src,
                             Variant& dst,
                             const Class& targetClass,
@@ -142,7 +234,7 @@ bool Variant::recursiveCast(Variant& src,
     const Class& clazz = dynamic_cast<const Class&>(src.getType());
 
     // retrieve direct caster if any
-    Const_RefCaster_Set casters = clazz.getRefCasters();
+    const Const_RefCaster_Set& casters = clazz.getRefCasters();
     const RefCaster* caster = ptrSet::findByKey(casters, targetClass);
 
     // if a caster is found, cast this variant and return
@@ -173,10 +265,28 @@ bool Variant::recursiveCast(Variant& src,
 
 
 Variant::~Variant()
+{
+    release();
+}
+
+
+void Variant::release()
 {
     if(!data_ || *type_ == ::getType<void>())
         return;
     
+    if (holdsString())
+    {
+        static_cast<string*>(data_)->~string();
+        return;
+    }
+    
+    if (flags_ & Shared)
+    {
+        getOwner().~shared_ptr();
+        return;
+    }
+    
     if (!(flags_ & Reference))
     {        
         const Class* clazz = dynamic_cast<const Class*>(type_);
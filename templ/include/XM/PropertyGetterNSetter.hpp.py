@@ -232,6 +232,7 @@ public:
             extractedValue""" + gen_seq(""",
             extrArg$_""", n_extr_param) + """
         );
+        notifySet(self);
     }
     
 private:
@@ -51,7 +51,8 @@ Method::Method
         retType,
         owner,""" + gen_seq("""
         paramType$""", XM_FUNCTION_PARAM_MAX - 1, ",") + """
-    )
+    ),
+    slot_(NoSlot)
 {
 }
 """
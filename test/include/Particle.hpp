@@ -0,0 +1,132 @@
+#ifndef PARTICLE_HPP
+#define PARTICLE_HPP
+
+#include <XM/xMirror.hpp>
+
+struct Vec3
+{
+    float x;
+    float y;
+    float z;
+};
+
+XM_DECLARE_CLASS(Vec3);
+
+enum class ParticleTag : unsigned char
+{
+    None = 0,
+    Charged = 1,
+    Stable = 2,
+    Tracked = 0x80
+};
+
+class Particle
+{
+public:
+    enum Kind
+    {
+        Electron,
+        Proton,
+        Neutron
+    };
+    
+    Particle();
+    int id;
+    short flags;
+    Vec3 position;
+    double mass;
+    int samples[4];
+    Kind kind;
+    ulong serial;
+    int getCharge() const;
+    void setCharge(int charge);
+private:
+    int charge;
+};
+
+XM_DECLARE_ENUM(ParticleTag);
+XM_DECLARE_ENUM(Particle::Kind);
+XM_DECLARE_CLASS(Particle);
+
+class Trajectory
+{
+public:
+    std::vector<Vec3> points;
+    std::vector<std::string> labels;
+    std::map<std::string, int> counts;
+};
+
+XM_DECLARE_CLASS(Trajectory);
+
+class Link
+{
+public:
+    int value;
+    Link* next;
+};
+
+XM_DECLARE_CLASS(Link);
+
+enum class Checksum : unsigned long long
+{
+    Unset = 0
+};
+
+class Packet
+{
+public:
+    Checksum checksum;
+    std::vector<int> values;
+    std::set<int> ids;
+    std::map<int, std::string> names;
+};
+
+XM_DECLARE_ENUM(Checksum);
+XM_DECLARE_CLASS(Packet);
+
+// Not registered at startup, the tests queue them for xm::initialize().
+class Track
+{
+public:
+    int id;
+    Vec3 direction;
+};
+
+class ChargedTrack : public Track
+{
+public:
+    Particle particle;
+    double momentum;
+};
+
+class Event
+{
+public:
+    ChargedTrack lead;
+    Track neutral;
+    int number;
+};
+
+// Not registered at startup either, a node refers to its own type.
+class Node
+{
+public:
+    int value;
+    Node* next;
+    Node* parent;
+};
+
+class Graph
+{
+public:
+    Node root;
+    Node* current;
+};
+
+XM_DECLARE_CLASS(Track);
+XM_DECLARE_CLASS(ChargedTrack);
+XM_DECLARE_CLASS(Event);
+XM_DECLARE_CLASS(Node);
+XM_DECLARE_CLASS(Graph);
+
+#endif // PARTICLE_HPP
@@ -1,7 +1,8 @@
 #include <MyButton.hpp>
 
 MyButton::MyButton(int x, int y, int w, int h)
-	: Button(x, y, w, h), mouseClicks(0)
+	: Button(x, y, w, h), mouseClicks(0), mouseOver(false), clickX(0),
+	  clickY(0)
 {
 }
 
@@ -0,0 +1,119 @@
+#include <Particle.hpp>
+#include <XM/ReflectStd.hpp>
+
+Particle::Particle()
+    : id(0), flags(0), mass(0), kind(Electron), serial(0), charge(0)
+{
+    position.x = position.y = position.z = 0;
+    for (int i = 0; i < 4; i++)
+        samples[i] = 0;
+}
+
+int Particle::getCharge() const
+{
+    return charge;
+}
+
+void Particle::setCharge(int charge)
+{
+    this->charge = charge;
+}
+
+XM_DEFINE_CLASS(Vec3)
+{
+    bindProperty(XM_MNP(x));
+    bindProperty(XM_MNP(y));
+    bindProperty(XM_MNP(z));
+}
+
+XM_DEFINE_CLASS(Particle)
+{
+    bindProperty(XM_MNP(id));
+    bindProperty(XM_MNP(flags));
+    bindProperty(XM_MNP(position));
+    bindProperty(XM_MNP(mass));
+    bindProperty(XM_MNP(samples));
+    bindProperty(XM_MNP(kind));
+    bindProperty(XM_MNP(serial));
+    bindProperty("charge", &ClassT::getCharge, &ClassT::setCharge);
+}
+
+XM_REGISTER_TYPE(Particle);
+
+XM_DEFINE_CLASS(Trajectory)
+{
+    bindProperty(XM_MNP(points));
+    bindProperty(XM_MNP(labels));
+    bindProperty(XM_MNP(counts));
+}
+
+XM_REGISTER_TYPE(Trajectory);
+
+XM_DEFINE_CLASS(Link)
+{
+    bindProperty(XM_MNP(value));
+    bindProperty(XM_MNP(next));
+}
+
+XM_REGISTER_TYPE(Link);
+
+XM_DEFINE_CLASS(Packet)
+{
+    bindProperty(XM_MNP(checksum));
+    bindProperty(XM_MNP(values));
+    bindProperty(XM_MNP(ids));
+    bindProperty(XM_MNP(names));
+}
+
+XM_REGISTER_TYPE(Packet);
+
+XM_DEFINE_CLASS(Track)
+{
+    bindProperty(XM_MNP(id));
+    bindProperty(XM_MNP(direction));
+}
+
+XM_DEFINE_CLASS(ChargedTrack)
+{
+    XM_BIND_BASE(Track);
+    bindProperty(XM_MNP(particle));
+    bindProperty(XM_MNP(momentum));
+}
+
+XM_DEFINE_CLASS(Event)
+{
+    bindProperty(XM_MNP(lead));
+    bindProperty(XM_MNP(neutral));
+    bindProperty(XM_MNP(number));
+}
+
+XM_DEFINE_CLASS(Node)
+{
+    bindProperty(XM_MNP(value));
+    bindProperty(XM_MNP(next));
+    bindProperty(XM_MNP(parent));
+}
+
+XM_DEFINE_CLASS(Graph)
+{
+    bindProperty(XM_MNP(root));
+    bindProperty(XM_MNP(current));
+}
+
+XM_BIND_FREE_ITEMS
+{
+    XM_BIND_ENUM_TYPE(Particle::Kind)
+            .XM_ADD_ENUM_VAL(Particle::Electron)
+            .XM_ADD_ENUM_VAL(Particle::Proton)
+            .XM_ADD_ENUM_VAL(Particle::Neutron);
+    
+    XM_BIND_ENUM_TYPE(ParticleTag)
+            .setFlags()
+            .XM_ADD_ENUM_VAL(ParticleTag::None)
+            .XM_ADD_ENUM_VAL(ParticleTag::Charged)
+            .XM_ADD_ENUM_VAL(ParticleTag::Stable)
+            .XM_ADD_ENUM_VAL(ParticleTag::Tracked);
+    
+    XM_BIND_ENUM_TYPE(Checksum)
+            .XM_ADD_ENUM_VAL(Checksum::Unset);
+}
@@ -1,5 +1,15 @@
 #include <gtest/gtest.h>
-#include <MyButton.hpp>
+#include <climits>
+#include <unordered_set>
+#include <MyTemplate.hpp>
+#include <Particle.hpp>
+#include <XM/Exceptions/SerializationException.hpp>
+#include <XM/Exceptions/MemberExceptions.hpp>
+#include <XM/Exceptions/NotFoundException.hpp>
+#include <XM/Exceptions/QueryException.hpp>
+#include <XM/Exceptions/VariantTypeException.hpp>
+#include <XM/Exceptions/SequenceIndexException.hpp>
+#include <XM/ReflectStd.hpp>
 
 TEST(Register, GetType)
 {
@@ -40,6 +50,187 @@ TEST(Register, GetEnum)
 }
 
 
+TEST(Register, EnumLookup)
+{
+    const xm::Enum& kind = xm::getEnum("::Particle::Kind");
+    long long value = -1;
+    ASSERT_TRUE(kind.tryGetValue("Neutron", value));
+    ASSERT_EQ(Particle::Neutron, value);
+    ASSERT_FALSE(kind.tryGetValue("Quark", value));
+    ASSERT_EQ("Proton", *kind.findKey(Particle::Proton));
+    ASSERT_EQ(NULL, kind.findKey(42));
+    ASSERT_EQ("42", kind.format(42));
+    
+    // flags of an unsigned char enumeration, beyond the range of a char
+    const xm::Enum& tag = xm::getEnum("::ParticleTag");
+    ASSERT_TRUE(tag.isFlags());
+    ASSERT_FALSE(tag.isSigned());
+    ASSERT_EQ("None", tag.format(0));
+    ASSERT_EQ("Charged|Tracked", tag.format(0x81));
+    ASSERT_EQ("Stable|4", tag.format(0x06));
+    ASSERT_TRUE(tag.parse(" Stable | Tracked|4", value));
+    ASSERT_EQ(0x86, value);
+    ASSERT_FALSE(tag.parse("Stable|Bogus", value));
+    ASSERT_FALSE(kind.parse("Electron|Proton", value));
+}
+
+
+TEST(Register, LargeEnumLookup)
+{
+    // the tables are built once, on the first lookup after the binding,
+    // and again after values are added
+    xm::Enum large("LargeEnum");
+    char key[16];
+    for (int i = 0; i < 5000; i++)
+    {
+        sprintf(key, "Key%d", i);
+        large.addValue(key, i * 3);
+    }
+    long long value;
+    for (int i = 0; i < 5000; i++)
+    {
+        sprintf(key, "Key%d", i);
+        ASSERT_TRUE(large.tryGetValue(key, value));
+        ASSERT_EQ(i * 3, value);
+    }
+    ASSERT_FALSE(large.tryGetValue("Key5000", value));
+    ASSERT_EQ("Key42", *large.findKey(126));
+    
+    large.addValue("Late", -1);
+    ASSERT_TRUE(large.tryGetValue("Late", value));
+    ASSERT_EQ(-1, value);
+    ASSERT_EQ("Late", *large.findKey(-1));
+}
+
+
+TEST(Register, FindItem)
+{
+    const xm::Register& reg = xm::Register::getSingleton();
+    const xm::Class* clazz = reg.findItem<xm::Class>("Particle");
+    ASSERT_TRUE(clazz != NULL);
+    ASSERT_EQ(&xm::getClass<Particle>(), clazz);
+    ASSERT_TRUE(clazz->findItem<xm::Property>("mass") != NULL);
+    ASSERT_EQ(NULL, clazz->findItem<xm::Property>("spin"));
+    ASSERT_EQ(NULL, reg.findItem<xm::Class>("::Missing::Particle"));
+    ASSERT_EQ(NULL, reg.findItem<xm::Enum>("Particle"));
+    
+    // the message is only formatted when requested
+    try
+    {
+        clazz->getProperty("spin");
+        FAIL();
+    }
+    catch (const xm::NotFoundException& e)
+    {
+        ASSERT_STREQ("Class ::Particle has no Property with name spin",
+                e.what());
+    }
+}
+
+
+TEST(Register, Initialize)
+{
+    xm::Register& reg = xm::Register::getSingleton();
+    reg.enqueueType(&xm::registerType<Event>);
+    reg.enqueueType(&xm::registerType<ChargedTrack>);
+    reg.enqueueType(&xm::registerType<Track>);
+    ASSERT_EQ(NULL, reg.findType(typeid(Track)));
+    
+    xm::initialize(3);
+    
+    // the dependencies are complete whichever thread defined them
+    const xm::Class& event = xm::getClass<Event>();
+    const xm::Class& charged = xm::getClass<ChargedTrack>();
+    const xm::Class& track = xm::getClass<Track>();
+    ASSERT_EQ(1u, charged.getBaseClasses().size());
+    ASSERT_TRUE(charged.inheritsFrom(track));
+    ASSERT_EQ(4u, charged.getProperties().size());
+    ASSERT_EQ(3u, event.getProperties().size());
+    ASSERT_EQ(&charged, &event.getProperty("lead").getType());
+    
+    // nothing is left queued
+    xm::initialize(3);
+}
+
+
+TEST(Register, InitializeCycles)
+{
+    // the pointer type of a class is created while the class is defined,
+    // both are registered once whichever thread needs them first
+    xm::Register& reg = xm::Register::getSingleton();
+    reg.enqueueType(&xm::registerType<Graph>);
+    reg.enqueueType(&xm::registerType<Node*>);
+    reg.enqueueType(&xm::registerType<Node>);
+    reg.enqueueType(&xm::registerType<Graph*>);
+    xm::initialize(4);
+    
+    const xm::Class& node = xm::getClass<Node>();
+    const xm::Type& nodePointer = xm::getType<Node*>();
+    ASSERT_EQ(&nodePointer, reg.findType(typeid(Node*)));
+    ASSERT_EQ(&nodePointer, &node.getProperty("next").getType());
+    ASSERT_EQ(&nodePointer, &node.getProperty("parent").getType());
+    ASSERT_EQ(&nodePointer,
+              &xm::getClass<Graph>().getProperty("current").getType());
+    ASSERT_EQ(&node, &dynamic_cast<const xm::PointerType&>(nodePointer)
+              .getPointedType());
+}
+
+
+TEST(Register, LazyConcurrentRegistration)
+{
+    // application threads registering different types on first use, each
+    // type ends up in the register once
+    using namespace std;
+    using xm::registerType;
+    const xm::Type* types[4];
+    std::thread threads[] = {
+        std::thread([&]() { types[0] = &registerType<vector<Track> >(); }),
+        std::thread([&]() { types[1] = &registerType<map<int, Track> >(); }),
+        std::thread([&]() { types[2] = &registerType<vector<Event> >(); }),
+        std::thread([&]() { types[3] = &registerType<map<int, Event> >(); })
+    };
+    for (size_t i = 0; i < 4; i++)
+        threads[i].join();
+    
+    const xm::Register& reg = xm::Register::getSingleton();
+    ASSERT_EQ(types[0], reg.findType(typeid(vector<Track>)));
+    ASSERT_EQ(types[1], reg.findType(typeid(map<int, Track>)));
+    ASSERT_EQ(types[2], reg.findType(typeid(vector<Event>)));
+    ASSERT_EQ(types[3], reg.findType(typeid(map<int, Event>)));
+}
+
+
+TEST(Register, ConcurrentLookups)
+{
+    // lookups running in parallel with each other and with a registration
+    const xm::Register& reg = xm::Register::getSingleton();
+    std::atomic<int> misses(0);
+    auto lookup = [&]()
+    {
+        for (int i = 0; i < 1000; i++)
+        {
+            if (reg.findType(typeid(Particle)) != &xm::getClass<Particle>()
+                || !reg.findItem<xm::Function>("::dgui_factories::makeButton"))
+                misses ++;
+        }
+    };
+    const xm::Type* registered = NULL;
+    std::thread threads[] = {
+        std::thread(lookup),
+        std::thread(lookup),
+        std::thread([&]()
+        {
+            registered = &xm::registerType<std::vector<Packet> >();
+        })
+    };
+    for (size_t i = 0; i < 3; i++)
+        threads[i].join();
+    
+    ASSERT_EQ(0, misses);
+    ASSERT_EQ(registered, reg.findType(typeid(std::vector<Packet>)));
+}
+
+
 TEST(Register, GetFunction)
 {
     const xm::Function& func = xm::getFunction("::dgui_factories::makeButton");
@@ -78,6 +269,125 @@ TEST(Register, GetNamespace)
 }
 
 
+TEST(CompoundClass, Sequence)
+{
+    const xm::CompoundClass& clazz = dynamic_cast<const xm::CompoundClass&>(
+            xm::getClass<std::vector<int> >());
+    const xm::Sequence* sequence = clazz.getSequence();
+    ASSERT_TRUE(sequence != NULL);
+    ASSERT_TRUE(sequence->isContiguous());
+    ASSERT_EQ(xm::getType<int>(), sequence->getElementType());
+    
+    std::vector<int> vec;
+    xm::Variant var(vec, xm::Variant::Reference);
+    ASSERT_TRUE(sequence->getData(var) == NULL);
+    sequence->reserve(var, 4);
+    for (int i = 0; i < 4; i++)
+        sequence->pushBack(var, xm::Variant(i));
+    ASSERT_EQ(4u, sequence->getSize(var));
+    ASSERT_EQ(vec.data(), sequence->getData(var));
+    
+    sequence->at(var, 2).as<int>() = 20;
+    ASSERT_EQ(20, vec[2]);
+    ASSERT_THROW(sequence->at(var, 4), xm::SequenceIndexException);
+    
+    xm::Variant constVar(vec, xm::Variant::Reference | xm::Variant::Const);
+    ASSERT_TRUE(sequence->at(constVar, 0).isConst());
+    ASSERT_THROW(sequence->pushBack(constVar, xm::Variant(5)),
+                 xm::VariantCostnessException);
+}
+
+
+struct SumVisitor : public xm::Associative::Visitor
+{
+    SumVisitor() : sum(0) {}
+    
+    void visit(const xm::Variant& key, const xm::Variant& mapped)
+    {
+        ASSERT_TRUE(key.isConst());
+        sum += const_cast<xm::Variant&>(mapped).as<const int>();
+    }
+    
+    int sum;
+};
+
+
+TEST(CompoundClass, Associative)
+{
+    typedef std::unordered_map<std::string, int> Map;
+    const xm::CompoundClass& clazz = dynamic_cast<const xm::CompoundClass&>(
+            xm::getClass<Map>());
+    const xm::Associative* associative = clazz.getAssociative();
+    ASSERT_TRUE(associative != NULL);
+    ASSERT_TRUE(associative->isHashed());
+    ASSERT_EQ(xm::getType<int>(), *associative->getMappedType());
+    
+    Map map;
+    xm::Variant var(map, xm::Variant::Reference);
+    ASSERT_TRUE(associative->insert(var, xm::Variant(std::string("a")),
+                                    xm::Variant(1)));
+    ASSERT_TRUE(associative->insert(var, xm::Variant(std::string("b"))));
+    ASSERT_FALSE(associative->insert(var, xm::Variant(std::string("a"))));
+    ASSERT_EQ(2u, associative->getSize(var));
+    
+    associative->find(var, xm::Variant(std::string("b"))).as<int>() = 5;
+    ASSERT_EQ(5, map["b"]);
+    ASSERT_EQ(xm::getType<void>(),
+              associative->find(var, xm::Variant(std::string("c"))).getType());
+    
+    SumVisitor visitor;
+    associative->forEach(var, visitor);
+    ASSERT_EQ(6, visitor.sum);
+    
+    ASSERT_TRUE(associative->erase(var, xm::Variant(std::string("a"))));
+    ASSERT_EQ(1u, map.size());
+    
+    std::set<int> set;
+    xm::Variant setVar(set, xm::Variant::Reference);
+    const xm::Associative* setAssociative =
+            dynamic_cast<const xm::CompoundClass&>(
+                xm::getClass<std::set<int> >()).getAssociative();
+    ASSERT_FALSE(setAssociative->isHashed());
+    ASSERT_TRUE(setAssociative->getMappedType() == NULL);
+    setAssociative->insert(setVar, xm::Variant(3));
+    ASSERT_EQ(3, setAssociative->find(setVar, xm::Variant(3)).as<const int>());
+}
+
+
+TEST(Register, MemoryStats)
+{
+    xm::getClass<Particle>().getLayout();
+    xm::MemoryStats stats = xm::memoryStats();
+    ASSERT_LT(0u, stats.items);
+    ASSERT_LT(0u, stats.types);
+    ASSERT_LT(0u, stats.members);
+    ASSERT_LT(0u, stats.containers);
+    ASSERT_LT(0u, stats.layouts);
+    ASSERT_EQ(stats.total, stats.types + stats.members + stats.namespaces
+              + stats.names + stats.containers + stats.memberTables
+              + stats.layouts);
+}
+
+
+TEST(Register, MetadataArena)
+{
+    const xm::Class& clazz = xm::getClass<Particle>();
+    xm::Arena& arena = xm::Arena::getMetadataArena();
+    ASSERT_TRUE(arena.owns(&clazz));
+    ASSERT_TRUE(arena.owns(&clazz.getProperty("id")));
+    ASSERT_LE(arena.getUsedSize(), arena.getReservedSize());
+    
+    int onStack = 0;
+    ASSERT_FALSE(arena.owns(&onStack));
+    
+    std::set<int*> set;
+    for (int i = 0; i < 8; i++)
+        set.insert(new int(i));
+    ptrSet::deleteAll(set);
+    ASSERT_TRUE(set.empty());
+}
+
+
 TEST(Class, GetProperty)
 {
     const xm::Class& clazz = xm::getClass<Control>();
@@ -121,6 +431,110 @@ TEST(Class, GetOverloadedMethod)
 }
 
 
+TEST(Class, InheritsFrom)
+{
+    const xm::Class& myButton = xm::getClass<MyButton>();
+    ASSERT_TRUE(myButton.inheritsFrom(xm::getClass<Button>()));
+    ASSERT_TRUE(myButton.inheritsFrom(xm::getClass<Shape>()));
+    ASSERT_TRUE(myButton.inheritsFrom(xm::getClass<Control>()));
+    ASSERT_FALSE(myButton.inheritsFrom(myButton));
+    ASSERT_FALSE(xm::getClass<Button>().inheritsFrom(myButton));
+    ASSERT_FALSE(myButton.inheritsFrom(xm::getClass<Particle>()));
+    ASSERT_TRUE(myButton.inheritsFrom("::Rectangle"));
+    ASSERT_TRUE(myButton.inheritsFrom("Control"));
+    ASSERT_FALSE(myButton.inheritsFrom("::Particle"));
+    
+    // bases added later are propagated to the derived classes
+    xm::Class base("InheritsFromBase");
+    xm::Class middle("InheritsFromMiddle");
+    xm::Class derived("InheritsFromDerived");
+    derived.addBaseClass(middle);
+    middle.addBaseClass(base);
+    ASSERT_TRUE(derived.inheritsFrom(base));
+    ASSERT_FALSE(base.inheritsFrom(derived));
+}
+
+
+TEST(Class, InheritedMembers)
+{
+    xm::Class base("InheritedMembersBase");
+    xm::Class derived("InheritedMembersDerived");
+    derived.addBaseClass(base);
+    ASSERT_FALSE(derived.hasMethod("late"));
+    
+    // members added to a base later are seen by the derived classes, which
+    // share the member table when they add none
+    base.addMember(*new xm::Method("late", base));
+    ASSERT_TRUE(derived.hasMethod("late"));
+    ASSERT_EQ(&base.getMethods(), &derived.getMethods());
+    ASSERT_EQ(&base, &derived.getMethod("late").getOwner());
+    
+    derived.addMember(*new xm::Method("own", derived));
+    ASSERT_NE(&base.getMethods(), &derived.getMethods());
+    ASSERT_TRUE(derived.hasMethod("late"));
+    ASSERT_FALSE(derived.hasMethod("late", false));
+    ASSERT_FALSE(base.hasMethod("own"));
+    
+    // the returned sets are kept up to date rather than rebuilt
+    const xm::Const_Method_Set& methods = derived.getMethods();
+    base.addMember(*new xm::Method("later", base));
+    ASSERT_EQ(&methods, &derived.getMethods());
+    ASSERT_EQ(3u, methods.size());
+}
+
+
+TEST(Class, MethodSlots)
+{
+    const xm::Class& control = xm::getClass<Control>();
+    const xm::Class& myButton = xm::getClass<MyButton>();
+    const xm::Method& onMouseClick = control.getMethod("onMouseClick");
+    size_t slot = onMouseClick.getSlot();
+    ASSERT_NE(xm::Method::NoSlot, slot);
+    ASSERT_EQ(&onMouseClick, myButton.getMethodBySlot(slot));
+    
+    MyButton button;
+    myButton.getMethodBySlot(slot)->call(xm::ref(button));
+    ASSERT_EQ(1u, button.getClickCount());
+    
+    size_t clickCountSlot = myButton.getMethod("getClickCount").getSlot();
+    ASSERT_NE(slot, clickCountSlot);
+    ASSERT_TRUE(control.getMethodBySlot(clickCountSlot) == NULL);
+    
+    // overrides take the slot of the overridden method
+    xm::Class base("MethodSlotsBase");
+    xm::Class derived("MethodSlotsDerived");
+    derived.addBaseClass(base);
+    xm::Method* baseMethod = new xm::Method("update", base);
+    base.addMember(*baseMethod);
+    ASSERT_EQ(baseMethod, derived.getMethodBySlot(baseMethod->getSlot()));
+    xm::Method* override = new xm::Method("update", derived);
+    derived.addMember(*override);
+    ASSERT_EQ(baseMethod->getSlot(), override->getSlot());
+    ASSERT_EQ(override, derived.getMethodBySlot(baseMethod->getSlot()));
+    ASSERT_EQ(baseMethod, base.getMethodBySlot(baseMethod->getSlot()));
+    
+    // the slots are numbered per hierarchy, a derived class extends the
+    // ones of its base
+    xm::Method* derivedMethod = new xm::Method("draw", derived);
+    derived.addMember(*derivedMethod);
+    ASSERT_EQ(0u, baseMethod->getSlot());
+    ASSERT_EQ(1u, derivedMethod->getSlot());
+    
+    // the clashing slots of a second base are moved
+    xm::Class other("MethodSlotsOther");
+    xm::Method* otherMethod = new xm::Method("reset", other);
+    other.addMember(*otherMethod);
+    ASSERT_EQ(0u, otherMethod->getSlot());
+    derived.addBaseClass(other);
+    ASSERT_NE(baseMethod->getSlot(), otherMethod->getSlot());
+    ASSERT_EQ(override, derived.getMethodBySlot(baseMethod->getSlot()));
+    ASSERT_EQ(otherMethod, derived.getMethodBySlot(otherMethod->getSlot()));
+    ASSERT_EQ(otherMethod, other.getMethodBySlot(otherMethod->getSlot()));
+    ASSERT_EQ(derivedMethod,
+              derived.getMethodBySlot(derivedMethod->getSlot()));
+}
+
+
 TEST(PropertyField, GetData)
 {
     Button* button = new MyButton();
@@ -261,6 +675,1130 @@ TEST(Variant, CallV)
 }
 
 
+TEST(Variant, UpCast)
+{
+    MyButton button;
+    xm::Variant var = xm::ref(button);
+    ASSERT_EQ(static_cast<Control*>(&button), &var.as<Control>());
+    ASSERT_EQ(static_cast<Shape*>(&button), &var.as<Shape>());
+    
+    const xm::RefCaster* caster = ptrSet::findByKey(
+            xm::getClass<Button>().getRefCasters(), xm::getClass<Control>());
+    ASSERT_TRUE(caster != NULL);
+    ASSERT_NE(-1, caster->getOffset());
+    Button& base = button;
+    ASSERT_EQ(static_cast<Control*>(&button),
+              caster->cast(xm::ref(base)).getAddress());
+}
+
+
+TEST(Variant, String)
+{
+    xm::Variant literal("hello");
+    ASSERT_EQ(xm::Type::String, literal.getType().getCategory());
+    ASSERT_EQ(xm::getType<std::string>(), literal.getType());
+    ASSERT_EQ("hello", literal.as<std::string>());
+    
+    std::string text(100, 'x');
+    xm::Variant var(text);
+    xm::Variant copy(var);
+    copy.as<std::string>() += "y";
+    ASSERT_EQ(text, var.as<std::string>());
+    
+    xm::Variant moved(std::move(copy));
+    ASSERT_EQ(101u, moved.as<std::string>().size());
+    var = moved;
+    ASSERT_TRUE(xm::equals(var, moved));
+    ASSERT_EQ(xm::hashOf(var), xm::hashOf(moved));
+    
+    xm::Variant ref(text, xm::Variant::Reference);
+    ref = std::string("z");
+    ASSERT_EQ("z", text);
+    
+    char buffer[128];
+    xm::BufferOutStream out(buffer, sizeof(buffer));
+    xm::serializeValue(moved, out);
+    std::string result;
+    xm::BufferInStream in(buffer, out.getSize());
+    xm::deserializeValue(xm::Variant(result, xm::Variant::Reference), in);
+    ASSERT_EQ(moved.as<std::string>(), result);
+}
+
+
+TEST(Variant, Shared)
+{
+    std::shared_ptr<MyButton> button = std::make_shared<MyButton>(1, 2, 3, 4);
+    xm::Variant var(button);
+    ASSERT_TRUE(var.isShared());
+    ASSERT_EQ(2, button.use_count());
+    
+    xm::Variant copy(var);
+    ASSERT_EQ(3, button.use_count());
+    ASSERT_EQ(button.get(), &copy.as<MyButton>());
+    
+    const xm::Property& width = xm::getClass<MyButton>().getProperty("width");
+    width.setData(copy, 10);
+    ASSERT_EQ(10, button->getWidth());
+    
+    std::shared_ptr<Button> base = copy.asShared<Button>();
+    ASSERT_EQ(static_cast<Button*>(button.get()), base.get());
+    ASSERT_EQ(4, button.use_count());
+    base.reset();
+    copy = xm::Variant();
+    ASSERT_EQ(2, button.use_count());
+    
+    std::unique_ptr<MyButton> unique(new MyButton());
+    xm::Variant owner(std::move(unique));
+    ASSERT_TRUE(unique == NULL);
+    std::weak_ptr<MyButton> weak = owner.asShared<MyButton>();
+    ASSERT_FALSE(weak.expired());
+    owner = xm::Variant();
+    ASSERT_TRUE(weak.expired());
+}
+
+
+TEST(ArrayView, Strided)
+{
+    float matrix[3][4];
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 4; j++)
+            matrix[i][j] = i * 10 + j;
+    
+    const xm::ArrayType& type = dynamic_cast<const xm::ArrayType&>(
+            xm::registerType<float[3][4]>());
+    xm::ArrayView view(matrix, type);
+    ASSERT_EQ(2u, view.getRank());
+    ASSERT_EQ(12u, view.getSize());
+    ASSERT_TRUE(view.isContiguous());
+    ASSERT_EQ(12.0f, view.at({1, 2}).as<float>());
+    ASSERT_THROW(view.at({3, 0}), xm::SequenceIndexException);
+    
+    // the second column
+    xm::ArrayView::Extent_Vector extents(1, 3);
+    xm::ArrayView::Stride_Vector strides(1, sizeof(matrix[0]));
+    xm::ArrayView column(&matrix[0][1], xm::getType<float>(), extents,
+                         strides);
+    ASSERT_FALSE(column.isContiguous());
+    float values[3];
+    column.copyTo(values);
+    ASSERT_EQ(21.0f, values[2]);
+    values[0] = -1;
+    column.copyFrom(values);
+    ASSERT_EQ(-1.0f, matrix[0][1]);
+    ASSERT_THROW(column.copyTo(static_cast<int*>(NULL)),
+                 xm::VariantTypeException);
+    
+    Particle particle;
+    particle.samples[3] = 7;
+    xm::ArrayView samples(xm::ref(particle),
+            xm::getClass<Particle>().getProperty("samples"));
+    int copy[4];
+    samples.copyTo(copy);
+    ASSERT_EQ(7, copy[3]);
+    
+    // objects are assigned to the constructed objects of the buffer
+    Trajectory trajectories[2];
+    trajectories[1].labels.push_back("first");
+    xm::ArrayView objects(trajectories, dynamic_cast<const xm::ArrayType&>(
+            xm::registerType<Trajectory[2]>()));
+    Trajectory buffer[2];
+    buffer[1].labels.push_back("old");
+    buffer[1].labels.push_back("older");
+    objects.copyTo(buffer);
+    ASSERT_EQ(1u, buffer[1].labels.size());
+    ASSERT_EQ("first", buffer[1].labels[0]);
+    buffer[0].counts["count"] = 2;
+    objects.copyFrom(buffer);
+    ASSERT_EQ(2, trajectories[0].counts["count"]);
+}
+
+
+// Classes without copy assignment, with and without a non-throwing move.
+struct Tagged
+{
+    Tagged(int tag) : tag(tag) {}
+    const int tag;
+};
+
+struct PinnedTagged
+{
+    PinnedTagged(int tag) : tag(tag) {}
+    PinnedTagged(const PinnedTagged& other) : tag(other.tag) {}
+    const int tag;
+};
+
+
+TEST(ArrayView, CopyAssign)
+{
+    const xm::Class& owner = xm::getClass<Particle>();
+    Tagged tagged(1);
+    xm::CopyAssign<Tagged>()(tagged, Tagged(2), owner);
+    ASSERT_EQ(2, tagged.tag);
+    
+    PinnedTagged pinned(1);
+    ASSERT_THROW(xm::CopyAssign<PinnedTagged>()(pinned, PinnedTagged(2), owner),
+                 xm::NonCopyableException);
+    ASSERT_EQ(1, pinned.tag);
+}
+
+
+TEST(Variant, ToDynamic)
+{
+    MyButton button;
+    Control& control = button;
+    
+    xm::Variant var = xm::ref(control);
+    ASSERT_EQ(&xm::getClass<Control>(), &var.getType());
+    xm::Variant dynamic = var.toDynamic();
+    ASSERT_EQ(&xm::getClass<MyButton>(), &dynamic.getType());
+    ASSERT_EQ(static_cast<void*>(&button), dynamic.getAddress());
+    ASSERT_EQ(0u, dynamic.call("getClickCount").as<unsigned int>());
+    
+    xm::Variant flagged(control, xm::Variant::Reference | xm::Variant::Dynamic);
+    ASSERT_EQ(&xm::getClass<MyButton>(), &flagged.getType());
+    ASSERT_EQ(static_cast<void*>(&button), flagged.getAddress());
+    
+    // template instances are resolved too
+    typedef MyTemplate<int, float> Instance;
+    Instance instance;
+    Control& instanceControl = instance;
+    ASSERT_EQ(&xm::getClass<Instance>(),
+              &xm::ref(instanceControl).toDynamic().getType());
+    
+    ASSERT_TRUE(xm::getClass<Control>().isPolymorphic());
+    ASSERT_FALSE(xm::getClass<Particle>().isPolymorphic());
+    Particle particle;
+    ASSERT_EQ(&xm::getClass<Particle>(),
+              &xm::ref(particle).toDynamic().getType());
+}
+
+
+TEST(ClassLayout, Fields)
+{
+    const xm::ClassLayout& layout = xm::getClass<Particle>().getLayout();
+    const xm::ClassLayout::Field_Vector& fields = layout.getFields();
+    Particle particle;
+    ASSERT_EQ(8u, fields.size());
+    ASSERT_STREQ("id", fields[0].property->getUnqualifiedName().c_str());
+    ASSERT_EQ(reinterpret_cast<char*>(&particle.mass)
+                - reinterpret_cast<char*>(&particle),
+              fields[3].offset);
+    ASSERT_STREQ("charge", fields[7].property->getUnqualifiedName().c_str());
+    ASSERT_EQ(-1, fields[7].offset);
+    ASSERT_EQ(7, layout.findField("charge", 6));
+    ASSERT_EQ(-1, layout.findField("chargeX", 7));
+    ASSERT_EQ(2u, layout.getRuns()[0].fieldCount);
+}
+
+
+TEST(ClassLayout, InheritedFields)
+{
+    const xm::Class& clazz = xm::getClass<MyButton>();
+    const xm::Property& property = clazz.getProperty("name");
+    const xm::ClassLayout& layout = clazz.getLayout();
+    int index = layout.getFieldIndex(property);
+    ASSERT_LE(0, index);
+    MyButton button;
+    ASSERT_EQ(reinterpret_cast<char*>(&button.name)
+                - reinterpret_cast<char*>(&button),
+              layout.getFields()[index].offset);
+}
+
+
+TEST(ClassLayout, ConcurrentBuild)
+{
+    // the layout is built once whichever thread asks first
+    const xm::Class& clazz = xm::getClass<Trajectory>();
+    const xm::ClassLayout* layouts[4];
+    std::thread threads[4];
+    for (size_t i = 0; i < 4; i++)
+        threads[i] = std::thread([&, i]()
+                { layouts[i] = &clazz.getLayout(); });
+    for (size_t i = 0; i < 4; i++)
+        threads[i].join();
+    for (size_t i = 1; i < 4; i++)
+        ASSERT_EQ(layouts[0], layouts[i]);
+}
+
+
+TEST(Serializer, RoundTrip)
+{
+    Particle orig;
+    orig.id = 7;
+    orig.flags = 3;
+    orig.position.y = 1.5f;
+    orig.mass = 2.25;
+    orig.samples[3] = 42;
+    orig.setCharge(-1);
+    
+    char buffer[256];
+    xm::BufferOutStream out(buffer, sizeof(buffer));
+    xm::serialize(xm::ref(orig), out);
+    
+    Particle copy;
+    xm::BufferInStream in(buffer, out.getSize());
+    xm::deserialize(xm::ref(copy), in);
+    ASSERT_EQ(out.getSize(), in.getPosition());
+    ASSERT_EQ(7, copy.id);
+    ASSERT_EQ(3, copy.flags);
+    ASSERT_EQ(1.5f, copy.position.y);
+    ASSERT_EQ(2.25, copy.mass);
+    ASSERT_EQ(42, copy.samples[3]);
+    ASSERT_EQ(-1, copy.getCharge());
+}
+
+
+TEST(Serializer, Containers)
+{
+    Trajectory orig;
+    Vec3 point = {1, 2, 3};
+    orig.points.push_back(point);
+    orig.points.push_back(point);
+    orig.points[1].z = 4;
+    orig.labels.push_back("start");
+    orig.labels.push_back("");
+    orig.counts["hits"] = 5;
+    orig.counts["misses"] = 2;
+    
+    char buffer[256];
+    xm::BufferOutStream out(buffer, sizeof(buffer));
+    xm::serialize(xm::ref(orig), out);
+    
+    Trajectory copy;
+    copy.labels.push_back("stale");
+    copy.counts["stale"] = 1;
+    xm::BufferInStream in(buffer, out.getSize());
+    xm::deserialize(xm::ref(copy), in);
+    ASSERT_EQ(out.getSize(), in.getPosition());
+    ASSERT_EQ(2u, copy.points.size());
+    ASSERT_EQ(2.0f, copy.points[0].y);
+    ASSERT_EQ(4.0f, copy.points[1].z);
+    ASSERT_EQ(orig.labels, copy.labels);
+    ASSERT_EQ(orig.counts, copy.counts);
+}
+
+
+TEST(Serializer, InheritedProperties)
+{
+    MyButton orig(1, 2, 3, 4);
+    char buffer[1024];
+    xm::BufferOutStream out(buffer, sizeof(buffer));
+    xm::serialize(xm::ref(orig), out);
+    
+    MyButton copy;
+    xm::BufferInStream in(buffer, out.getSize());
+    xm::deserialize(xm::ref(copy), in);
+    ASSERT_EQ(2, copy.getY());
+    ASSERT_EQ(3, copy.getWidth());
+    ASSERT_EQ(4, copy.getHeight());
+}
+
+
+TEST(Serializer, FingerprintMismatch)
+{
+    Particle particle;
+    char buffer[256];
+    xm::BufferOutStream out(buffer, sizeof(buffer));
+    xm::serialize(xm::ref(particle), out);
+    
+    Vec3 vec;
+    xm::BufferInStream in(buffer, out.getSize());
+    ASSERT_THROW(xm::deserialize(xm::ref(vec), in),
+                 xm::SerializationException);
+}
+
+
+TEST(Serializer, BufferOverflow)
+{
+    Particle particle;
+    char buffer[16];
+    xm::BufferOutStream out(buffer, sizeof(buffer));
+    ASSERT_THROW(xm::serialize(xm::ref(particle), out),
+                 xm::SerializationException);
+}
+
+
+TEST(Serializer, CorruptCount)
+{
+    // a count larger than the data left is rejected before allocating
+    uint32_t data[] = {0xFFFFFFFF, 1};
+    std::vector<int> values;
+    xm::BufferInStream in(data, sizeof(data));
+    ASSERT_THROW(xm::deserializeValue(xm::ref(values), in),
+                 xm::SerializationException);
+    ASSERT_GT(1000u, values.capacity());
+    
+    std::vector<std::string> labels;
+    xm::BufferInStream labelsIn(data, sizeof(data));
+    ASSERT_THROW(xm::deserializeValue(xm::ref(labels), labelsIn),
+                 xm::SerializationException);
+    ASSERT_GT(1000u, labels.capacity());
+}
+
+
+TEST(Json, CyclicPointers)
+{
+    Link last = {2, NULL};
+    Link first = {1, &last};
+    char buffer[256];
+    xm::BufferOutStream out(buffer, sizeof(buffer));
+    xm::JsonWriter writer(out);
+    writer.write(xm::ref(first));
+    ASSERT_EQ("{\"value\":1,\"next\":{\"value\":2,\"next\":null}}",
+            std::string(buffer, out.getSize()));
+    
+    last.next = &first;
+    ASSERT_THROW(writer.write(xm::ref(first)), xm::SerializationException);
+}
+
+
+TEST(Json, RoundTrip)
+{
+    Particle orig;
+    orig.id = 7;
+    orig.flags = -3;
+    orig.position.y = 1.5f;
+    orig.mass = 2.25;
+    orig.samples[3] = 42;
+    orig.kind = Particle::Proton;
+    orig.setCharge(-1);
+    
+    char buffer[512];
+    xm::BufferOutStream out(buffer, sizeof(buffer));
+    xm::JsonWriter writer(out);
+    writer.write(xm::ref(orig));
+    std::string json(buffer, out.getSize());
+    ASSERT_NE(std::string::npos, json.find("\"kind\":\"Proton\""));
+    
+    Particle copy;
+    xm::JsonReader reader(json.data(), json.size());
+    reader.read(xm::ref(copy));
+    ASSERT_EQ(xm::JsonReader::End, reader.next());
+    ASSERT_EQ(7, copy.id);
+    ASSERT_EQ(-3, copy.flags);
+    ASSERT_EQ(1.5f, copy.position.y);
+    ASSERT_EQ(2.25, copy.mass);
+    ASSERT_EQ(42, copy.samples[3]);
+    ASSERT_EQ(Particle::Proton, copy.kind);
+    ASSERT_EQ(-1, copy.getCharge());
+}
+
+
+TEST(Json, Containers)
+{
+    Packet orig;
+    orig.checksum = static_cast<Checksum>(0xFFFFFFFFFFFFFFF0ull);
+    orig.values.push_back(3);
+    orig.values.push_back(-1);
+    orig.ids.insert(5);
+    orig.ids.insert(2);
+    orig.names[4] = "four";
+    Trajectory trajectory;
+    Vec3 point = {1, 2, 3};
+    trajectory.points.push_back(point);
+    trajectory.labels.push_back("start");
+    trajectory.counts["hits"] = 5;
+    
+    char buffer[512];
+    xm::BufferOutStream out(buffer, sizeof(buffer));
+    xm::JsonWriter writer(out);
+    writer.write(xm::ref(orig));
+    std::string json(buffer, out.getSize());
+    ASSERT_EQ("{\"checksum\":18446744073709551600,\"values\":[3,-1],"
+              "\"ids\":[2,5],\"names\":[[4,\"four\"]]}", json);
+    xm::BufferOutStream trajectoryOut(buffer, sizeof(buffer));
+    xm::JsonWriter trajectoryWriter(trajectoryOut);
+    trajectoryWriter.write(xm::ref(trajectory));
+    std::string trajectoryJson(buffer, trajectoryOut.getSize());
+    ASSERT_NE(std::string::npos,
+              trajectoryJson.find("\"counts\":{\"hits\":5}"));
+    
+    Packet copy;
+    copy.values.push_back(9);
+    xm::JsonReader reader(json.data(), json.size());
+    reader.read(xm::ref(copy));
+    ASSERT_EQ(orig.checksum, copy.checksum);
+    ASSERT_EQ(orig.values, copy.values);
+    ASSERT_EQ(orig.ids, copy.ids);
+    ASSERT_EQ(orig.names, copy.names);
+    
+    Trajectory trajectoryCopy;
+    xm::JsonReader trajectoryReader(trajectoryJson.data(),
+                                    trajectoryJson.size());
+    trajectoryReader.read(xm::ref(trajectoryCopy));
+    ASSERT_EQ(1u, trajectoryCopy.points.size());
+    ASSERT_EQ(3.0f, trajectoryCopy.points[0].z);
+    ASSERT_EQ(trajectory.labels, trajectoryCopy.labels);
+    ASSERT_EQ(trajectory.counts, trajectoryCopy.counts);
+    
+    const char negative[] = "{\"checksum\": -1}";
+    xm::JsonReader negativeReader(negative, sizeof(negative) - 1);
+    ASSERT_THROW(negativeReader.read(xm::ref(copy)),
+                 xm::SerializationException);
+}
+
+
+TEST(Json, UnknownKeys)
+{
+    const char json[] = "{ \"unknown\": {\"a\": [1, \"\\u00e8\"]},"
+                        "  \"id\": 12, \"extra\": null }";
+    Particle particle;
+    xm::JsonReader reader(json, sizeof(json) - 1);
+    reader.read(xm::ref(particle));
+    ASSERT_EQ(12, particle.id);
+}
+
+
+TEST(Json, Errors)
+{
+    Particle particle;
+    const char outOfRange[] = "{\"flags\": 70000}";
+    xm::JsonReader reader1(outOfRange, sizeof(outOfRange) - 1);
+    ASSERT_THROW(reader1.read(xm::ref(particle)), xm::SerializationException);
+    
+    const char malformed[] = "{\"id\" 1}";
+    xm::JsonReader reader2(malformed, sizeof(malformed) - 1);
+    ASSERT_THROW(reader2.read(xm::ref(particle)), xm::SerializationException);
+    
+    const char wrongSize[] = "{\"samples\": [1, 2]}";
+    xm::JsonReader reader3(wrongSize, sizeof(wrongSize) - 1);
+    ASSERT_THROW(reader3.read(xm::ref(particle)), xm::SerializationException);
+}
+
+
+TEST(Archive, RecordViews)
+{
+    Particle particles[3];
+    for (int i = 0; i < 3; i++)
+    {
+        particles[i].id = i;
+        particles[i].position.z = i * 0.5f;
+        particles[i].mass = i * 2.0;
+    }
+    
+    uint64_t buffer[128];
+    xm::BufferOutStream out(buffer, sizeof(buffer));
+    xm::ArchiveWriter writer(xm::getClass<Particle>(), 3, out);
+    for (int i = 0; i < 3; i++)
+        writer.write(xm::ref(particles[i]));
+    ASSERT_THROW(writer.write(xm::ref(particles[0])),
+                 xm::SerializationException);
+    
+    xm::MappedArchive archive(buffer, out.getSize(), xm::getClass<Particle>());
+    ASSERT_TRUE(archive.isSchemaCurrent());
+    ASSERT_EQ(3u, archive.getRecordCount());
+    
+    xm::RecordView record = archive.getRecord(2);
+    const xm::Property& mass = xm::getClass<Particle>().getProperty("mass");
+    ASSERT_EQ(4.0, record.getData(mass).as<const double>());
+    ASSERT_EQ(1.0f, record.getData("position.z").as<const float>());
+    ASSERT_EQ(&xm::Variant::Void.getType(),
+              &record.getData("charge").getType());
+    
+    Particle particle;
+    record.load(xm::ref(particle));
+    ASSERT_EQ(2, particle.id);
+    ASSERT_EQ(1.0f, particle.position.z);
+    
+    // map the archive from a file
+    FILE* file = fopen("particles.xmar", "wb");
+    fwrite(buffer, 1, out.getSize(), file);
+    fclose(file);
+    {
+        xm::MappedArchive mapped("particles.xmar", xm::getClass<Particle>());
+        ASSERT_EQ(1, mapped.getRecord(1).getData("id").as<const int>());
+    }
+    remove("particles.xmar");
+}
+
+
+TEST(Archive, SchemaReconciliation)
+{
+    Vec3 vec;
+    vec.x = 1;
+    vec.y = 2;
+    vec.z = 3;
+    uint64_t buffer[32];
+    xm::BufferOutStream out(buffer, sizeof(buffer));
+    xm::ArchiveWriter writer(xm::getClass<Vec3>(), 1, out);
+    writer.write(xm::ref(vec));
+    
+    // read the archive of Vec3 as an archive of Particle: only the fields
+    // with matching path and type are found
+    xm::MappedArchive archive(buffer, out.getSize(), xm::getClass<Particle>());
+    ASSERT_FALSE(archive.isSchemaCurrent());
+    xm::RecordView record = archive.getRecord(0);
+    ASSERT_EQ(&xm::Variant::Void.getType(), &record.getData("id").getType());
+    ASSERT_THROW(archive.getRecord(1), xm::SerializationException);
+}
+
+
+TEST(Archive, CorruptField)
+{
+    Vec3 vec;
+    uint64_t buffer[32];
+    xm::BufferOutStream out(buffer, sizeof(buffer));
+    xm::ArchiveWriter writer(xm::getClass<Vec3>(), 1, out);
+    writer.write(xm::ref(vec));
+    
+    // a field offset wrapping around the record size is rejected; the
+    // fields follow the 32 bytes of the header
+    uint32_t offset = 0xFFFFFFFE;
+    memcpy(reinterpret_cast<char*>(buffer) + 32, &offset, sizeof(offset));
+    ASSERT_THROW(xm::MappedArchive(buffer, out.getSize(),
+                                   xm::getClass<Vec3>()),
+                 xm::SerializationException);
+}
+
+
+TEST(Patch, DiffAndApply)
+{
+    Particle from;
+    Particle to;
+    to.flags = 5;
+    to.position.x = 3.5f;
+    to.samples[1] = 9;
+    to.setCharge(2);
+    
+    char buffer[256];
+    xm::BufferOutStream out(buffer, sizeof(buffer));
+    ASSERT_TRUE(xm::diff(xm::ref(from), xm::ref(to), out));
+    
+    // fingerprint, flags, position.x, samples, charge and the terminators
+    ASSERT_EQ(8u + 3u + (1u + 5u + 1u) + (1u + 4u + 16u) + 5u + 1u,
+              out.getSize());
+    
+    Particle target;
+    target.id = 11;
+    xm::BufferInStream in(buffer, out.getSize());
+    xm::apply(in, xm::ref(target));
+    ASSERT_EQ(out.getSize(), in.getPosition());
+    ASSERT_EQ(11, target.id);
+    ASSERT_EQ(5, target.flags);
+    ASSERT_EQ(3.5f, target.position.x);
+    ASSERT_EQ(9, target.samples[1]);
+    ASSERT_EQ(2, target.getCharge());
+}
+
+
+TEST(Patch, NoChanges)
+{
+    MyButton button(1, 2, 3, 4);
+    MyButton copy(1, 2, 3, 4);
+    char buffer[64];
+    xm::BufferOutStream out(buffer, sizeof(buffer));
+    ASSERT_FALSE(xm::diff(xm::ref(button), xm::ref(copy), out));
+    ASSERT_EQ(9u, out.getSize());
+}
+
+
+TEST(Patch, Containers)
+{
+    // containers are patched as whole values
+    Packet from;
+    from.ids.insert(1);
+    Packet to;
+    to.values.push_back(4);
+    to.values.push_back(2);
+    to.names[3] = "three";
+    
+    char buffer[256];
+    xm::BufferOutStream out(buffer, sizeof(buffer));
+    ASSERT_TRUE(xm::diff(xm::ref(from), xm::ref(to), out));
+    
+    Packet target;
+    target.values.push_back(7);
+    target.ids.insert(1);
+    target.ids.insert(8);
+    xm::BufferInStream in(buffer, out.getSize());
+    xm::apply(in, xm::ref(target));
+    ASSERT_EQ(out.getSize(), in.getPosition());
+    ASSERT_EQ(to.values, target.values);
+    ASSERT_TRUE(target.ids.empty());
+    ASSERT_EQ(to.names, target.names);
+}
+
+
+class ChangeCounter : public xm::ChangeListener
+{
+public:
+    ChangeCounter() : notifications(0), properties(0) {}
+    
+    void propertiesChanged(const xm::Variant& object,
+                           const std::vector<const xm::Property*>& changed)
+    {
+        (void) object;
+        notifications ++;
+        properties += changed.size();
+    }
+    
+    int notifications;
+    int properties;
+};
+
+
+TEST(ChangeTracker, BatchedNotifications)
+{
+    const xm::Class& clazz = xm::getClass<Particle>();
+    const xm::Property& id = clazz.getProperty("id");
+    const xm::Property& charge = clazz.getProperty("charge");
+    Particle particle;
+    Particle untracked;
+    
+    xm::ChangeTracker tracker;
+    ChangeCounter counter;
+    tracker.addListener(counter);
+    tracker.track(xm::ref(particle));
+    
+    id.setData(xm::ref(particle), 1);
+    id.setData(xm::ref(particle), 2);
+    charge.setData(xm::ref(particle), 3);
+    id.setData(xm::ref(untracked), 4);
+    ASSERT_TRUE(tracker.isChanged(xm::ref(particle), id));
+    ASSERT_FALSE(tracker.isChanged(xm::ref(untracked), id));
+    ASSERT_EQ(0, counter.notifications);
+    
+    tracker.flush();
+    ASSERT_EQ(1, counter.notifications);
+    ASSERT_EQ(2, counter.properties);
+    ASSERT_FALSE(tracker.isChanged(xm::ref(particle), id));
+    
+    tracker.untrack(xm::ref(particle));
+    id.setData(xm::ref(particle), 5);
+    tracker.flush();
+    ASSERT_EQ(1, counter.notifications);
+}
+
+
+TEST(ChangeTracker, ConcurrentSets)
+{
+    // instances are tracked and set from several threads
+    const xm::Property& id = xm::getClass<Particle>().getProperty("id");
+    Particle particles[64];
+    xm::ChangeTracker tracker;
+    ChangeCounter counter;
+    tracker.addListener(counter);
+    std::thread threads[4];
+    for (size_t t = 0; t < 4; t++)
+    {
+        threads[t] = std::thread([&, t]()
+        {
+            for (size_t i = t; i < 64; i += 4)
+            {
+                tracker.track(xm::ref(particles[i]));
+                id.setData(xm::ref(particles[i]), int(i));
+            }
+        });
+    }
+    for (size_t t = 0; t < 4; t++)
+        threads[t].join();
+    tracker.flush();
+    ASSERT_EQ(64, counter.notifications);
+    
+    // a member at the address of the instance has properties of its own
+    const xm::Class& graphClass =
+            dynamic_cast<const xm::Class&>(xm::registerType<Graph>());
+    const xm::Property& value = xm::getClass<Node>().getProperty("value");
+    Graph graph;
+    tracker.track(xm::ref(graph));
+    value.setData(xm::ref(graph.root), 1);
+    ASSERT_FALSE(tracker.isChanged(xm::ref(graph),
+                                   graphClass.getProperty("root")));
+    tracker.flush();
+    ASSERT_EQ(64, counter.notifications);
+}
+
+
+TEST(Columns, GatherAndScatter)
+{
+    std::vector<Particle> particles(100);
+    for (int i = 0; i < 100; i++)
+    {
+        particles[i].mass = i * 0.5;
+        particles[i].setCharge(i);
+    }
+    
+    const xm::Class& clazz = xm::getClass<Particle>();
+    xm::Column masses(clazz.getProperty("mass"));
+    xm::gather(particles, masses);
+    ASSERT_EQ(100u, masses.getSize());
+    ASSERT_EQ(0u, reinterpret_cast<size_t>(masses.getData())
+                    % xm::Column::Alignment);
+    ASSERT_EQ(49.5, masses.as<double>()[99]);
+    ASSERT_THROW(masses.as<float>(), xm::VariantTypeException);
+    
+    xm::Column charges(clazz.getProperty("charge"));
+    xm::gather(particles, charges);
+    ASSERT_EQ(42, charges.as<int>()[42]);
+    
+    for (int i = 0; i < 100; i++)
+    {
+        masses.as<double>()[i] *= 2;
+        charges.as<int>()[i] = -i;
+    }
+    xm::ChangeTracker tracker;
+    tracker.track(xm::ref(particles[7]));
+    xm::scatter(masses, particles);
+    xm::scatter(charges, particles);
+    ASSERT_EQ(99.0, particles[99].mass);
+    ASSERT_EQ(-42, particles[42].getCharge());
+    
+    // the fields written directly are reported to the trackers
+    ASSERT_TRUE(tracker.isChanged(xm::ref(particles[7]),
+                                  clazz.getProperty("mass")));
+    ASSERT_TRUE(tracker.isChanged(xm::ref(particles[7]),
+                                  clazz.getProperty("charge")));
+    
+    ASSERT_THROW(xm::Column(clazz.getProperty("position")),
+                 xm::NonCopyableException);
+}
+
+
+TEST(Hash, HashAndEquality)
+{
+    Particle particle1;
+    Particle particle2;
+    particle1.position.y = particle2.position.y = 2.0f;
+    ASSERT_TRUE(xm::equals(xm::ref(particle1), xm::ref(particle2)));
+    ASSERT_EQ(xm::hashOf(xm::ref(particle1)), xm::hashOf(xm::ref(particle2)));
+    
+    particle2.setCharge(1);
+    ASSERT_FALSE(xm::equals(xm::ref(particle1), xm::ref(particle2)));
+    ASSERT_NE(xm::hashOf(xm::ref(particle1)), xm::hashOf(xm::ref(particle2)));
+    
+    particle2.setCharge(0);
+    particle2.samples[2] = 1;
+    ASSERT_FALSE(xm::equals(xm::ref(particle1), xm::ref(particle2)));
+    ASSERT_FALSE(xm::equals(xm::ref(particle1), xm::ref(particle1.position)));
+}
+
+
+TEST(Hash, Containers)
+{
+    Trajectory a;
+    Vec3 point = {1, 2, 3};
+    a.points.push_back(point);
+    a.labels.push_back("start");
+    a.counts["hits"] = 5;
+    Trajectory b = a;
+    xm::ReflectedHash<Trajectory> hash;
+    xm::ReflectedEqual<Trajectory> equal;
+    ASSERT_TRUE(equal(a, b));
+    ASSERT_EQ(hash(a), hash(b));
+    
+    b.labels[0] = "stop";
+    ASSERT_FALSE(equal(a, b));
+    ASSERT_NE(hash(a), hash(b));
+    
+    b = a;
+    b.counts["hits"] = 6;
+    ASSERT_FALSE(equal(a, b));
+    b.counts.erase("hits");
+    b.counts["misses"] = 5;
+    ASSERT_FALSE(equal(a, b));
+    b.points.push_back(point);
+    ASSERT_NE(hash(a), hash(b));
+    
+    // hashed containers compare whatever their iteration order
+    std::unordered_set<int> set1;
+    std::unordered_set<int> set2;
+    for (int i = 0; i < 64; i++)
+    {
+        set1.insert(i);
+        set2.insert(63 - i);
+    }
+    set2.rehash(512);
+    const xm::Type& setType = xm::registerType<std::unordered_set<int> >();
+    ASSERT_TRUE(xm::equals(&set1, &set2, setType));
+    ASSERT_EQ(xm::hashOf(&set1, setType), xm::hashOf(&set2, setType));
+}
+
+
+TEST(Hash, UnorderedSet)
+{
+    std::unordered_set<Particle, xm::ReflectedHash<Particle>,
+                       xm::ReflectedEqual<Particle> > particles;
+    Particle particle;
+    for (int i = 0; i < 10; i++)
+    {
+        particle.id = i % 5;
+        particles.insert(particle);
+    }
+    ASSERT_EQ(5u, particles.size());
+}
+
+
+TEST(Sort, SingleKey)
+{
+    std::vector<Particle> particles(1000);
+    for (int i = 0; i < 1000; i++)
+    {
+        particles[i].id = (i * 7919) % 1000 - 500;
+        particles[i].mass = ((i * 31) % 1000) * -0.25;
+    }
+    
+    xm::sortBy(particles, "id");
+    for (int i = 0; i < 1000; i++)
+        ASSERT_EQ(i - 500, particles[i].id);
+    
+    xm::sortBy(particles, "mass", xm::Descending);
+    for (int i = 1; i < 1000; i++)
+        ASSERT_GE(particles[i - 1].mass, particles[i].mass);
+}
+
+
+TEST(Sort, UnsignedEnum)
+{
+    std::vector<Packet> packets(4);
+    packets[0].checksum = Checksum(~0ull);
+    packets[1].checksum = Checksum(1);
+    packets[2].checksum = Checksum(1ull << 63);
+    packets[3].checksum = Checksum::Unset;
+    
+    xm::sortBy(packets, "checksum");
+    ASSERT_EQ(Checksum::Unset, packets[0].checksum);
+    ASSERT_EQ(Checksum(1), packets[1].checksum);
+    ASSERT_EQ(Checksum(1ull << 63), packets[2].checksum);
+    ASSERT_EQ(Checksum(~0ull), packets[3].checksum);
+    
+    xm::ObjectStore store(xm::getClass<Packet>());
+    store.addIndex("checksum", xm::OrderedIndex);
+    for (size_t i = 0; i < packets.size(); i++)
+        store.insert(xm::ref(packets[i]));
+    
+    std::vector<const Packet*> found;
+    store.findRange("checksum", Checksum(1), Checksum(1ull << 63), found);
+    ASSERT_EQ(2u, found.size());
+    ASSERT_EQ(&packets[1], found[0]);
+    ASSERT_EQ(&packets[2], found[1]);
+}
+
+
+TEST(Sort, MultipleKeys)
+{
+    std::vector<Particle> particles(100);
+    for (int i = 0; i < 100; i++)
+    {
+        particles[i].id = i;
+        particles[i].flags = i % 3;
+        particles[i].samples[0] = i % 2;
+        particles[i].setCharge(i % 5);
+    }
+    
+    std::vector<xm::SortKey> keys;
+    keys.push_back(xm::SortKey("flags"));
+    keys.push_back(xm::SortKey("samples"));
+    keys.push_back(xm::SortKey("charge", xm::Descending));
+    xm::sortBy(particles, keys);
+    for (int i = 1; i < 100; i++)
+    {
+        const Particle& p1 = particles[i - 1];
+        const Particle& p2 = particles[i];
+        ASSERT_LE(p1.flags, p2.flags);
+        if (p1.flags != p2.flags)
+            continue;
+        ASSERT_LE(p1.samples[0], p2.samples[0]);
+        if (p1.samples[0] != p2.samples[0])
+            continue;
+        ASSERT_GE(p1.getCharge(), p2.getCharge());
+        if (p1.getCharge() == p2.getCharge())
+        {
+            ASSERT_LT(p1.id, p2.id);
+        }
+    }
+}
+
+
+TEST(Query, Predicates)
+{
+    const xm::Class& clazz = xm::getClass<Particle>();
+    Particle particle;
+    particle.id = 3;
+    particle.mass = 12.5;
+    particle.position.y = 1.5f;
+    particle.kind = Particle::Proton;
+    particle.setCharge(-1);
+    
+    ASSERT_TRUE(xm::Query(clazz, "mass > 10 && kind == Proton")
+                .matches(xm::ref(particle)));
+    ASSERT_FALSE(xm::Query(clazz, "mass > 10 && kind == 'Neutron'")
+                 .matches(xm::ref(particle)));
+    ASSERT_TRUE(xm::Query(clazz, "!(id < 3) && (charge == -1 || id == 0)")
+                .matches(xm::ref(particle)));
+    ASSERT_TRUE(xm::Query(clazz, "position.y >= 1.5 && id != 4")
+                .matches(xm::ref(particle)));
+    ASSERT_TRUE(xm::Query(clazz, "kind == Particle::Proton && id")
+                .matches(xm::ref(particle)));
+    
+    ASSERT_THROW(xm::Query(clazz, "mass >"), xm::QueryException);
+    ASSERT_THROW(xm::Query(clazz, "weight > 1"), xm::QueryException);
+    ASSERT_THROW(xm::Query(clazz, "kind == Photon"), xm::QueryException);
+    ASSERT_THROW(xm::Query(clazz, "position > 1"), xm::QueryException);
+}
+
+
+TEST(Query, UnsignedValues)
+{
+    const xm::Class& clazz = xm::getClass<Particle>();
+    Particle particle;
+    particle.serial = ULONG_MAX - 1;
+    particle.setCharge(-1);
+    
+    ASSERT_TRUE(xm::Query(clazz, "serial > 0 && serial > -1")
+                .matches(xm::ref(particle)));
+    ASSERT_TRUE(xm::Query(clazz, "serial < 18446744073709551615")
+                .matches(xm::ref(particle)));
+    ASSERT_TRUE(xm::Query(clazz, "serial > 9223372036854775807")
+                .matches(xm::ref(particle)));
+    ASSERT_FALSE(xm::Query(clazz, "charge > 18446744073709551615")
+                 .matches(xm::ref(particle)));
+    ASSERT_FALSE(xm::Query(clazz, "serial == 0").matches(xm::ref(particle)));
+}
+
+
+TEST(Query, Projection)
+{
+    std::vector<Particle> particles(10);
+    for (size_t i = 0; i < particles.size(); i++)
+    {
+        particles[i].id = i;
+        particles[i].position.x = i * 0.5f;
+        particles[i].serial = ULONG_MAX - i;
+        particles[i].setCharge(i % 2);
+    }
+    
+    xm::Query query(xm::getClass<Particle>(), "id >= 6 && charge == 1");
+    std::vector<std::string> paths;
+    paths.push_back("id");
+    paths.push_back("position.x");
+    std::vector<std::vector<double> > columns;
+    query.project(particles, paths, columns);
+    ASSERT_EQ(2u, columns.size());
+    ASSERT_EQ(2u, columns[0].size());
+    ASSERT_EQ(7, columns[0][0]);
+    ASSERT_EQ(9, columns[0][1]);
+    ASSERT_EQ(4.5, columns[1][1]);
+    
+    std::vector<size_t> indexes;
+    query.filter(&particles[0], particles.size(), indexes);
+    std::vector<unsigned long long> serials;
+    query.project("serial", &particles[0], indexes, serials);
+    ASSERT_EQ(2u, serials.size());
+    ASSERT_EQ(ULONG_MAX - 7, serials[0]);
+    std::vector<long long> charges;
+    query.project("charge", &particles[0], indexes, charges);
+    ASSERT_EQ(1, charges[1]);
+    
+    ASSERT_THROW(query.project("weight", &particles[0], indexes, charges),
+                 xm::QueryException);
+    ASSERT_THROW(query.project("position", &particles[0], indexes, charges),
+                 xm::QueryException);
+    
+    // the instances must be of the class of the query
+    std::vector<Packet> packets(1);
+    std::vector<const Packet*> matches;
+    ASSERT_THROW(query.filter(packets, matches), xm::QueryException);
+    ASSERT_THROW(query.project(packets, paths, columns), xm::QueryException);
+    ASSERT_THROW(query.matches(xm::ref(packets[0])), xm::QueryException);
+}
+
+
+TEST(Query, ParallelFilter)
+{
+    std::vector<Particle> particles(3 * xm::Query::ParallelThreshold);
+    for (size_t i = 0; i < particles.size(); i++)
+        particles[i].id = i;
+    
+    xm::Query query(xm::getClass<Particle>(), "id >= 100 && id < 40000");
+    std::vector<const Particle*> matches;
+    query.filter(particles, matches, 4);
+    ASSERT_EQ(39900u, matches.size());
+    for (size_t i = 0; i < matches.size(); i++)
+        ASSERT_EQ(int(i + 100), matches[i]->id);
+}
+
+
+TEST(ObjectStore, PointLookups)
+{
+    const xm::Class& clazz = xm::getClass<Particle>();
+    std::vector<Particle> particles(10);
+    for (int i = 0; i < 10; i++)
+    {
+        particles[i].id = i;
+        particles[i].kind = i % 2 ? Particle::Proton : Particle::Neutron;
+        particles[i].setCharge(i % 3);
+    }
+    
+    xm::ObjectStore store(clazz);
+    store.addIndex("kind", xm::HashIndex);
+    for (size_t i = 0; i < particles.size(); i++)
+        store.insert(xm::ref(particles[i]));
+    store.addIndex("charge", xm::HashIndex);
+    ASSERT_EQ(10u, store.getSize());
+    
+    std::vector<Particle*> found;
+    store.find("kind", Particle::Proton, found);
+    ASSERT_EQ(5u, found.size());
+    store.find("charge", 2, found);
+    ASSERT_EQ(3u, found.size());
+    
+    // changes made through setters are followed
+    clazz.getProperty("kind").setData(xm::ref(particles[0]), Particle::Proton);
+    clazz.getProperty("charge").setData(xm::ref(particles[1]), 2);
+    store.find("kind", Particle::Proton, found);
+    ASSERT_EQ(6u, found.size());
+    store.find("charge", 2, found);
+    ASSERT_EQ(4u, found.size());
+    
+    // direct changes are reported with update()
+    particles[2].setCharge(7);
+    store.update(xm::ref(particles[2]));
+    store.find("charge", 7, found);
+    ASSERT_EQ(1u, found.size());
+    ASSERT_EQ(&particles[2], found[0]);
+    
+    store.erase(xm::ref(particles[2]));
+    store.find("charge", 7, found);
+    ASSERT_TRUE(found.empty());
+    ASSERT_FALSE(store.contains(xm::ref(particles[2])));
+    
+    ASSERT_THROW(store.find("id", 1, found), xm::QueryException);
+    ASSERT_THROW(store.find("charge", 2.0, found), xm::VariantTypeException);
+    ASSERT_THROW(store.addIndex("position", xm::HashIndex),
+                 xm::QueryException);
+}
+
+
+TEST(ObjectStore, RangeLookups)
+{
+    const xm::Class& clazz = xm::getClass<Particle>();
+    std::vector<Particle> particles(100);
+    
+    xm::ObjectStore store(clazz);
+    store.addIndex("mass", xm::OrderedIndex);
+    for (int i = 0; i < 100; i++)
+    {
+        particles[i].mass = 50 - i;
+        store.insert(xm::ref(particles[i]));
+    }
+    
+    std::vector<const Particle*> found;
+    store.findRange("mass", -2.0, 2.0, found);
+    ASSERT_EQ(5u, found.size());
+    for (size_t i = 0; i < found.size(); i++)
+        ASSERT_EQ(-2.0 + i, found[i]->mass);
+    
+    clazz.getProperty("mass").setData(xm::ref(particles[0]), 0.5);
+    store.findRange("mass", -2.0, 2.0, found);
+    ASSERT_EQ(6u, found.size());
+    ASSERT_EQ(&particles[0], found[3]);
+    
+    store.find("mass", -49.0, found);
+    ASSERT_EQ(1u, found.size());
+    ASSERT_EQ(&particles[99], found[0]);
+}
+
+
 int main(int argc, char**argv)
 {
 	::testing::InitGoogleTest(&argc, argv);